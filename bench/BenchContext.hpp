@@ -0,0 +1,65 @@
+/*
+  BenchContext.hpp
+
+  A stand-in for the parts of Rack's engine that the DSP code reaches for.
+
+  Much of the plugin's DSP code reads the sample rate through
+  APP->engine->getSampleRate() and APP->engine->getSampleTime().  Both of
+  those, along with rack::contextGet() behind the APP macro, live in libRack,
+  which the benchmarks don't link against.  This file supplies them instead,
+  backed by a sample rate which the benchmarks set with setSampleRate().
+
+  Only these three symbols are provided.  Anything else from libRack which
+  ends up being called (logging, assets, the module base class, etc.) will
+  show up as a link error, which is the cue to either provide it here too or
+  to keep it out of the code being benchmarked.
+
+  The context and engine objects are never constructed: their constructors
+  and destructors are also in libRack, and nothing here needs them.  The
+  engine methods below don't touch _this_, and the context is only used to
+  hold the engine pointer.
+
+  Include this file from exactly one translation unit.
+*/
+
+#pragma once
+
+namespace bench
+{
+  float sample_rate = 44100.0;
+
+  alignas(rack::Context) unsigned char context_storage[sizeof(rack::Context)];
+  alignas(rack::engine::Engine) unsigned char engine_storage[sizeof(rack::engine::Engine)];
+
+  rack::Context *context()
+  {
+    return((rack::Context *) context_storage);
+  }
+
+  void setSampleRate(float new_sample_rate)
+  {
+    sample_rate = new_sample_rate;
+    context()->engine = (rack::engine::Engine *) engine_storage;
+  }
+}
+
+namespace rack
+{
+  Context *contextGet()
+  {
+    return(bench::context());
+  }
+
+  namespace engine
+  {
+    float Engine::getSampleRate()
+    {
+      return(bench::sample_rate);
+    }
+
+    float Engine::getSampleTime()
+    {
+      return(1.0 / bench::sample_rate);
+    }
+  }
+}
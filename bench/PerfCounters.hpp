@@ -0,0 +1,111 @@
+/*
+  PerfCounters.hpp
+
+  Hardware instruction and cache miss counters for the benchmarks.
+
+  On Linux these come from perf_event_open().  The counters only cover this
+  process, in user space, so they work without root as long as
+  /proc/sys/kernel/perf_event_paranoid is 2 or lower (the default on most
+  distributions).  On other platforms, or when the kernel refuses, available()
+  returns false and the benchmarks report timings only.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#if defined __linux__
+  #include <linux/perf_event.h>
+  #include <sys/ioctl.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+#endif
+
+struct PerfCounters
+{
+  enum Counters
+  {
+    INSTRUCTIONS,
+    CACHE_MISSES,
+    NUMBER_OF_COUNTERS
+  };
+
+  int file_descriptors[NUMBER_OF_COUNTERS];
+  uint64_t values[NUMBER_OF_COUNTERS];
+
+  PerfCounters()
+  {
+    for(unsigned int i = 0; i < NUMBER_OF_COUNTERS; i++)
+    {
+      file_descriptors[i] = -1;
+      values[i] = 0;
+    }
+
+#if defined __linux__
+    file_descriptors[INSTRUCTIONS] = open(PERF_COUNT_HW_INSTRUCTIONS);
+    file_descriptors[CACHE_MISSES] = open(PERF_COUNT_HW_CACHE_MISSES);
+#endif
+  }
+
+  PerfCounters(const PerfCounters &other) = delete;
+  PerfCounters& operator=(const PerfCounters &other) = delete;
+
+  ~PerfCounters()
+  {
+#if defined __linux__
+    for(unsigned int i = 0; i < NUMBER_OF_COUNTERS; i++)
+    {
+      if(file_descriptors[i] >= 0) close(file_descriptors[i]);
+    }
+#endif
+  }
+
+  bool available(unsigned int counter) const
+  {
+    return(file_descriptors[counter] >= 0);
+  }
+
+  void start()
+  {
+#if defined __linux__
+    for(unsigned int i = 0; i < NUMBER_OF_COUNTERS; i++)
+    {
+      if(file_descriptors[i] < 0) continue;
+      ioctl(file_descriptors[i], PERF_EVENT_IOC_RESET, 0);
+      ioctl(file_descriptors[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+  }
+
+  void stop()
+  {
+#if defined __linux__
+    for(unsigned int i = 0; i < NUMBER_OF_COUNTERS; i++)
+    {
+      values[i] = 0;
+      if(file_descriptors[i] < 0) continue;
+
+      ioctl(file_descriptors[i], PERF_EVENT_IOC_DISABLE, 0);
+      if(read(file_descriptors[i], &values[i], sizeof(uint64_t)) != sizeof(uint64_t)) values[i] = 0;
+    }
+#endif
+  }
+
+#if defined __linux__
+  static int open(uint64_t config)
+  {
+    struct perf_event_attr attributes;
+    std::memset(&attributes, 0, sizeof(attributes));
+
+    attributes.type = PERF_TYPE_HARDWARE;
+    attributes.size = sizeof(attributes);
+    attributes.config = config;
+    attributes.disabled = 1;
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+
+    return(syscall(__NR_perf_event_open, &attributes, 0, -1, -1, 0));
+  }
+#endif
+};
@@ -0,0 +1,532 @@
+/*
+  dsp_bench.cpp
+
+  Headless benchmarks for the plugin's DSP code.  Build and run with:
+
+    make bench
+
+  or, to only run the benchmarks whose names contain "Grain":
+
+    make bench/dsp_bench && ./bench/dsp_bench Grain
+
+  Each benchmark renders a few seconds of audio from fixed, synthetic input
+  at 44.1, 48 and 96 kHz and reports:
+
+  - ns/sample:    wall clock time per sample frame, per voice
+  - instr/sample: retired instructions per sample frame, per voice (Linux only)
+  - miss/sample:  cache misses per sample frame, per voice (Linux only)
+  - budget:       time spent per sample frame as a percentage of the time
+                  available for one frame at that sample rate, for all voices
+
+  A "voice" is whatever the benchmark runs several of at once: grains,
+  ghosts, tracks, etc.
+
+  The benchmarks are compiled with the same flags as the plugin, but they
+  don't link against libRack.  See BenchContext.hpp for how the engine's
+  sample rate is provided.  Whole modules (anything derived from
+  rack::Module) can't be constructed without libRack, so the benchmarks
+  drive the DSP classes that modules' process() methods are built from.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include <deque>
+#include <array>
+
+#include "rack.hpp"
+using namespace rack;
+
+#include "BenchContext.hpp"
+#include "PerfCounters.hpp"
+
+// Plugin code under test
+#include "Common/sample.hpp"
+#include "Common/SampleLoader.hpp"
+#include "Common/SamplePlayer.hpp"
+#include "Common/DspProfiler.hpp"
+#include "Common/dsp/ADSR.cpp"
+#include "Common/dsp/Filter.hpp"
+#include "Common/dsp/SimpleDelay.hpp"
+#include "Common/dsp/StereoFadeOut.hpp"
+#include "Common/dsp/StereoPan.hpp"
+#include "Common/dsp/StereoSmooth.hpp"
+#include "Common/dsp/FastSlewLimiter.hpp"
+#include "Common/dsp/Random.hpp"
+#include "Common/SliceCrossfade.hpp"
+#include "Common/TimeStretch.hpp"
+
+#include "GrooveBox/defines.h"
+using namespace groove_box;
+
+#include "GrooveBox/ParameterLockSettings.hpp"
+#include "GrooveBox/TrackModel.hpp"
+#include "GrooveBox/Track.hpp"
+#include "GrooveBox/TrackEngine.hpp"
+
+#include "GrainEngineMK2/defines.h"
+#include "GrainEngineMK2/GrainManager.hpp"
+
+#include "Ghosts/GhostsEx.hpp"
+
+#include "ByteBeat/defines.h"
+#include "ByteBeat/ByteBeatEquations.hpp"
+
+//
+// Synthetic input
+//
+
+// Fills _sample_ with two seconds of a 44.1 kHz stereo test signal: a pair
+// of detuned saw waves with a little noise, so that interpolation and
+// filtering have something to chew on.
+void makeTestSample(Sample *sample)
+{
+  Random random(1);
+  unsigned int length = 44100 * 2;
+
+  sample->initialize_recording();
+
+  for(unsigned int i = 0; i < length; i++)
+  {
+    float left = std::fmod(i * (110.0 / 44100.0), 1.0) * 2.0 - 1.0;
+    float right = std::fmod(i * (110.5 / 44100.0), 1.0) * 2.0 - 1.0;
+    float noise = random.uniform(-0.1, 0.1);
+
+    sample->record_audio(left + noise, right + noise);
+  }
+
+  sample->sample_rate = 44100.0;
+  sample->channels = 2;
+  sample->loaded = true;
+}
+
+//
+// Benchmarks
+//
+// Each benchmark is constructed after the sample rate has been set, so
+// anything that reads the sample rate when it's constructed sees the right
+// one.  process() renders one frame for all voices and returns something
+// derived from the output, so that the compiler can't optimize the work away.
+//
+
+struct Benchmark
+{
+  virtual ~Benchmark() {}
+  virtual unsigned int voices() { return(1); }
+  virtual float process() = 0;
+};
+
+struct FilterBenchmark : Benchmark
+{
+  Filter filter;
+  Random random;
+  unsigned int frame = 0;
+
+  FilterBenchmark() : random(2)
+  {
+    filter.setResonance(0.4);
+  }
+
+  float process() override
+  {
+    // Sweep the cutoff, as the slewed cutoff in GrooveBox does, so that the
+    // coefficients are recalculated on every frame.
+    filter.setCutoff(0.3 + 0.2 * std::sin(frame++ * 0.0001));
+
+    float left = random.uniform(-5, 5);
+    float right = random.uniform(-5, 5);
+    filter.process(&left, &right);
+
+    return(left + right);
+  }
+};
+
+struct SimpleDelayBenchmark : Benchmark
+{
+  std::unique_ptr<SimpleDelay> delay;
+  Random random;
+
+  SimpleDelayBenchmark() : delay(new SimpleDelay()), random(3)
+  {
+    delay->setSampleRate(APP->engine->getSampleRate());
+    delay->allocate();
+    delay->setMix(0.5);
+    delay->setFeedback(0.5);
+    delay->setBufferSize(0.5 * (APP->engine->getSampleRate() / 4));
+  }
+
+  float process() override
+  {
+    float left = 0;
+    float right = 0;
+
+    delay->process(random.uniform(-5, 5), random.uniform(-5, 5), left, right);
+
+    return(left + right);
+  }
+};
+
+struct GrainManagerBenchmark : Benchmark
+{
+  static const unsigned int NUMBER_OF_GRAINS = 128;
+
+  Sample sample;
+  GrainManager grain_manager;
+  Random random;
+
+  GrainManagerBenchmark() : random(4)
+  {
+    makeTestSample(&sample);
+  }
+
+  unsigned int voices() override { return(NUMBER_OF_GRAINS); }
+
+  float process() override
+  {
+    // Keep the grain count topped up, as a busy GrainEngineMK2 would
+    while(grain_manager.size() < (int) NUMBER_OF_GRAINS)
+    {
+      double start_position = random.uniform(0, sample.size());
+      unsigned int lifespan = APP->engine->getSampleRate() * random.uniform(0.02, 0.2);
+      float pan = random.uniform(-1, 1);
+
+      grain_manager.addGrain(start_position, lifespan, pan, &sample, MAX_GRAINS, 1.0);
+    }
+
+    std::pair<float, float> output = grain_manager.process();
+    return(output.first + output.second);
+  }
+};
+
+struct GhostsExBenchmark : Benchmark
+{
+  static const unsigned int NUMBER_OF_GHOSTS = 32;
+
+  Sample sample;
+  GhostsEx graveyard;
+  Random random;
+
+  GhostsExBenchmark() : random(5)
+  {
+    makeTestSample(&sample);
+
+    for(unsigned int i = 0; i < NUMBER_OF_GHOSTS; i++)
+    {
+      graveyard.add(random.uniform(0, sample.size()), APP->engine->getSampleRate() / 8, &sample);
+    }
+  }
+
+  unsigned int voices() override { return(NUMBER_OF_GHOSTS); }
+
+  float process() override
+  {
+    float left = 0;
+    float right = 0;
+
+    graveyard.process(0.01, 1.0, &left, &right);
+
+    return(left + right);
+  }
+};
+
+// Eight GrooveBox tracks with every per-track effect switched on, triggered
+// on every 16th note at 120 BPM, rendered by the TrackEngine.  The shared
+// resources are wired up the same way as in the GrooveBox constructor.
+struct TrackBenchmark : Benchmark
+{
+  SamplePlayer sample_players[NUMBER_OF_TRACKS];
+  std::vector<std::unique_ptr<SimpleDelay>> delay_dsps;
+  std::vector<Track> tracks;
+  std::unique_ptr<TrackEngine> track_engine;
+  Output track_outputs[NUMBER_OF_TRACKS * 2];
+
+  unsigned int frame = 0;
+  unsigned int frames_per_step = 0;
+
+  TrackBenchmark()
+  {
+    frames_per_step = APP->engine->getSampleRate() / 8;
+    tracks.resize(NUMBER_OF_TRACKS);
+
+    track_engine.reset(new TrackEngine());
+    track_engine->setSlewSpeed(100.0f);
+
+    for(unsigned int t = 0; t < NUMBER_OF_TRACKS; t++)
+    {
+      makeTestSample(&sample_players[t].sample);
+      sample_players[t].updateSampleRate();
+
+      delay_dsps.push_back(std::unique_ptr<SimpleDelay>(new SimpleDelay()));
+      delay_dsps[t]->setSampleRate(APP->engine->getSampleRate());
+      delay_dsps[t]->allocate();
+
+      Track &track = tracks[t];
+      track.setSamplePlayer(&sample_players[t]);
+      track.setDelayDsp(delay_dsps[t].get());
+
+      for(unsigned int step = 0; step < NUMBER_OF_STEPS; step++)
+      {
+        track.setValue(step, true);
+        track.setParameter(PITCH, step, 0.45 + (t * 0.02));
+        track.setParameter(PAN, step, 0.3);
+        track.setParameter(ATTACK, step, 0.01);
+        track.setParameter(RELEASE, step, 0.5);
+        track.setParameter(FILTER_CUTOFF, step, 0.6);
+        track.setParameter(FILTER_RESONANCE, step, 0.3);
+        track.setParameter(DELAY_MIX, step, 0.3);
+      }
+    }
+  }
+
+  unsigned int voices() override { return(NUMBER_OF_TRACKS); }
+
+  float process() override
+  {
+    if((frame++ % frames_per_step) == 0)
+    {
+      for(Track &track : tracks)
+      {
+        track.step();
+        track.trigger(0);
+      }
+    }
+
+    float left = 0;
+    float right = 0;
+    track_engine->process(tracks.data(), 1, NULL, track_outputs, &left, &right);
+
+    return(left + right);
+  }
+};
+
+struct ByteBeatBenchmark : Benchmark
+{
+  ByteBeatEquations equations;
+  uint32_t t = 0;
+
+  float process() override
+  {
+    // Work through every equation, as a modulated equation input would
+    uint32_t equation = (t >> 12) % NUMBER_OF_EQUATIONS;
+    float output = equations.compute(equation, t, 60, 90, 120);
+    t++;
+
+    return(output);
+  }
+};
+
+// Eight Autobreak Studio voices time stretching a two second loop to 140
+// BPM, which is slower than the loop's own tempo, and jumping to a random
+// slice on every 8th note.
+struct TimeStretchBenchmark : Benchmark
+{
+  static const unsigned int NUMBER_OF_VOICES = 8;
+
+  Sample sample;
+  TimeStretchAnalysis analysis;
+  TimeStretch time_stretch[NUMBER_OF_VOICES];
+  double positions[NUMBER_OF_VOICES];
+  double rate = 0.0;
+  unsigned int frames_per_slice = 0;
+  unsigned int frame = 0;
+  Random random;
+
+  TimeStretchBenchmark() : random(6)
+  {
+    makeTestSample(&sample);
+
+    analysis.build(sample.size(), [this](unsigned int index, float *left, float *right) {
+      sample.read(index, left, right);
+    });
+
+    float sample_rate = APP->engine->getSampleRate();
+    double frames_per_loop = (60.0 / 140.0) * sample_rate * 8.0;
+
+    rate = sample.size() / frames_per_loop;
+    frames_per_slice = frames_per_loop / 16;
+
+    for(unsigned int i = 0; i < NUMBER_OF_VOICES; i++) positions[i] = 0;
+  }
+
+  unsigned int voices() override { return(NUMBER_OF_VOICES); }
+
+  float process() override
+  {
+    float output = 0;
+    bool jump = (frame % frames_per_slice == 0);
+
+    for(unsigned int i = 0; i < NUMBER_OF_VOICES; i++)
+    {
+      if(jump) positions[i] = random.uniform(0, 15) * (sample.size() / 16);
+
+      float left, right;
+      time_stretch[i].process(&sample, &analysis, positions[i], 1, &left, &right);
+      output += left + right;
+
+      positions[i] += rate;
+      if(positions[i] >= sample.size()) positions[i] = 0;
+    }
+
+    frame++;
+
+    return(output);
+  }
+};
+
+// Eight Autobreak Studio voices playing a two second loop at 140 BPM without
+// time stretching, and ratcheting to a random slice on every 16th note.  Each
+// ratchet starts a crossfade between the voice's old and new position.
+struct SliceCrossfadeBenchmark : Benchmark
+{
+  static const unsigned int NUMBER_OF_VOICES = 8;
+
+  Sample sample;
+  SliceCrossfade slice_crossfade[NUMBER_OF_VOICES];
+  double positions[NUMBER_OF_VOICES];
+  double rate = 0.0;
+  unsigned int frames_per_ratchet = 0;
+  unsigned int frame = 0;
+  Random random;
+
+  SliceCrossfadeBenchmark() : random(7)
+  {
+    makeTestSample(&sample);
+
+    float sample_rate = APP->engine->getSampleRate();
+    double frames_per_loop = (60.0 / 140.0) * sample_rate * 8.0;
+
+    rate = sample.size() / frames_per_loop;
+    frames_per_ratchet = frames_per_loop / 32;
+
+    for(unsigned int i = 0; i < NUMBER_OF_VOICES; i++) positions[i] = 0;
+  }
+
+  unsigned int voices() override { return(NUMBER_OF_VOICES); }
+
+  float process() override
+  {
+    float output = 0;
+    bool jump = (frame % frames_per_ratchet == 0);
+
+    for(unsigned int i = 0; i < NUMBER_OF_VOICES; i++)
+    {
+      if(jump) positions[i] = random.uniform(0, 15) * (sample.size() / 16);
+
+      float left, right;
+      slice_crossfade[i].process(&sample, positions[i], &left, &right);
+      output += left + right;
+
+      positions[i] += rate;
+      if(positions[i] >= sample.size()) positions[i] = 0;
+    }
+
+    frame++;
+
+    return(output);
+  }
+};
+
+//
+// Runner
+//
+
+struct BenchmarkDefinition
+{
+  const char *name;
+  Benchmark *(*create)();
+};
+
+template <typename T>
+Benchmark *createBenchmark()
+{
+  return(new T());
+}
+
+const BenchmarkDefinition benchmark_definitions[] = {
+  { "Filter", createBenchmark<FilterBenchmark> },
+  { "SimpleDelay", createBenchmark<SimpleDelayBenchmark> },
+  { "GrainManager (128 grains)", createBenchmark<GrainManagerBenchmark> },
+  { "GhostsEx (32 ghosts)", createBenchmark<GhostsExBenchmark> },
+  { "GrooveBox Track (8 tracks)", createBenchmark<TrackBenchmark> },
+  { "ByteBeat compute", createBenchmark<ByteBeatBenchmark> },
+  { "TimeStretch (8 voices)", createBenchmark<TimeStretchBenchmark> },
+  { "SliceCrossfade (8 voices)", createBenchmark<SliceCrossfadeBenchmark> }
+};
+
+const float sample_rates[] = { 44100.0, 48000.0, 96000.0 };
+const float seconds_per_run = 2.0;
+
+volatile float sink = 0;
+
+void run(const BenchmarkDefinition &definition, float sample_rate, PerfCounters &perf_counters)
+{
+  bench::setSampleRate(sample_rate);
+
+  std::unique_ptr<Benchmark> benchmark(definition.create());
+
+  // Warm up caches, branch predictors and grain pools
+  unsigned int warm_up_frames = sample_rate * 0.1;
+  float output = 0;
+  for(unsigned int i = 0; i < warm_up_frames; i++) output += benchmark->process();
+
+  unsigned int frames = sample_rate * seconds_per_run;
+
+  perf_counters.start();
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  for(unsigned int i = 0; i < frames; i++) output += benchmark->process();
+
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+  perf_counters.stop();
+
+  sink = sink + output;
+
+  double elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+  double voice_frames = (double) frames * benchmark->voices();
+  double budget = 100.0 * (elapsed_ns / frames) / (1e9 / sample_rate);
+
+  char instructions[32] = "n/a";
+  char cache_misses[32] = "n/a";
+
+  if(perf_counters.available(PerfCounters::INSTRUCTIONS))
+  {
+    snprintf(instructions, sizeof(instructions), "%.1f", perf_counters.values[PerfCounters::INSTRUCTIONS] / voice_frames);
+  }
+
+  if(perf_counters.available(PerfCounters::CACHE_MISSES))
+  {
+    snprintf(cache_misses, sizeof(cache_misses), "%.3f", perf_counters.values[PerfCounters::CACHE_MISSES] / voice_frames);
+  }
+
+  printf("%-28s %6.1f kHz %10.2f %14s %12s %9.2f%%\n",
+    definition.name,
+    sample_rate / 1000.0,
+    elapsed_ns / voice_frames,
+    instructions,
+    cache_misses,
+    budget);
+}
+
+int main(int argc, char **argv)
+{
+  const char *filter = (argc > 1) ? argv[1] : NULL;
+
+  PerfCounters perf_counters;
+
+  printf("%-28s %10s %10s %14s %12s %10s\n", "benchmark", "rate", "ns/sample", "instr/sample", "miss/sample", "budget");
+
+  for(const BenchmarkDefinition &definition : benchmark_definitions)
+  {
+    if(filter && ! std::strstr(definition.name, filter)) continue;
+
+    for(float sample_rate : sample_rates)
+    {
+      run(definition, sample_rate, perf_counters);
+    }
+  }
+
+  return(0);
+}
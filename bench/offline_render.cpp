@@ -0,0 +1,544 @@
+/*
+  offline_render.cpp
+
+  Renders a module offline, as fast as the CPU allows, without a running
+  Rack.  Useful for regression testing (is the output bit-for-bit the same as
+  the last version?) and for throughput testing (how many hours of audio per
+  minute?).
+
+  Build with:
+
+    make render RACK_LIB_DIR=/path/to/Rack2
+
+  Unlike bench/dsp_bench.cpp, the renderer links the whole plugin against
+  libRack, so RACK_LIB_DIR must point at a directory containing libRack: a
+  Rack installation, or the SDK on Windows.  The plugin's sources are
+  compiled again into build/render/, with VOXGLITCH_OFFLINE_RENDER defined,
+  so that Random (see Common/dsp/Random.hpp) is seeded by
+  offlineRenderSeed() below instead of by std::random_device.  plugin.so is
+  left untouched.
+
+  Usage:
+
+    offline_render --module <slug> [options]
+
+    --module <slug>             Module to render, e.g. groovebox, grainenginemk2
+    --preset <file>             Module state to load with fromJson().  Either a
+                                module preset (.vcvm) or an uncompressed patch
+                                JSON, in which case the first module with a
+                                matching model is used.
+    --seconds <n>               Length of the render (default: 10)
+    --sample-rate <hz>          Engine sample rate (default: 48000)
+    --input <port>=<file.wav>[@<gain>]
+                                Feed a .wav file into an input.  Each channel
+                                of the file becomes a polyphonic channel.
+                                Samples are multiplied by _gain_ (default 5.0,
+                                so full scale audio is +/-5V).  The file loops.
+    --gate <port>=<file.txt>    Feed gates into an input.  Each line of the file
+                                is "<start seconds> [<length seconds>] [<volts>]".
+                                Length defaults to 1 ms and volts to 10.
+    --output <file.wav>         Write the outputs to a 32 bit float .wav file,
+                                one channel per output port (divided by 5.0).
+    --outputs <a,b,...>         Output ports to write (default: all of them)
+    --seed <n>                  Random seed (default: 1).  Use the same seed to
+                                compare renders.
+
+  Port numbers are the module's InputIds / OutputIds enum values.
+
+  After rendering, the renderer prints the time taken, the speed relative to
+  real time, and a hash of every output voltage.  Two renders of the same
+  preset and inputs with the same seed should print the same hash.
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "plugin.hpp"
+#include "Common/sample.hpp"
+#include "Common/dsp/Random.hpp"
+
+// Defined in plugin.cpp
+void init(Plugin *p);
+
+// Every Random constructed during the render is seeded from this counter in
+// turn, so that the same --seed gives the same output on every run
+static std::atomic<uint64_t> random_seed {1};
+
+uint64_t offlineRenderSeed()
+{
+  return(random_seed.fetch_add(1));
+}
+
+//
+// Input sources
+//
+
+struct WavInput
+{
+  unsigned int port = 0;
+  float gain = 5.0;
+  AudioFile<float> audio_file;
+
+  bool load(std::string path)
+  {
+    return(audio_file.load(path) && audio_file.getNumSamplesPerChannel() > 0);
+  }
+
+  void apply(engine::Module *module, uint64_t frame)
+  {
+    unsigned int channels = std::min(audio_file.getNumChannels(), (int) PORT_MAX_CHANNELS);
+    unsigned int index = frame % audio_file.getNumSamplesPerChannel();
+
+    module->inputs[port].setChannels(channels);
+
+    for(unsigned int c = 0; c < channels; c++)
+    {
+      module->inputs[port].setVoltage(audio_file.samples[c][index] * gain, c);
+    }
+  }
+};
+
+struct GateInput
+{
+  struct Gate
+  {
+    uint64_t start;
+    uint64_t end;
+    float voltage;
+  };
+
+  unsigned int port = 0;
+  std::vector<Gate> gates;
+  unsigned int next_gate = 0;
+
+  bool load(std::string path, float sample_rate)
+  {
+    std::ifstream file(path);
+    if(! file) return(false);
+
+    std::string line;
+
+    while(std::getline(file, line))
+    {
+      if(line.empty() || line[0] == '#') continue;
+
+      double start = 0;
+      double length = 0.001;
+      float voltage = 10.0;
+
+      std::istringstream fields(line);
+      if(! (fields >> start)) continue;
+      fields >> length >> voltage;
+
+      Gate gate;
+      gate.start = start * sample_rate;
+      gate.end = gate.start + std::max(1.0, length * sample_rate);
+      gate.voltage = voltage;
+      gates.push_back(gate);
+    }
+
+    std::sort(gates.begin(), gates.end(), [](const Gate &a, const Gate &b) { return(a.start < b.start); });
+    return(true);
+  }
+
+  void apply(engine::Module *module, uint64_t frame)
+  {
+    while(next_gate < gates.size() && gates[next_gate].end <= frame) next_gate++;
+
+    float voltage = 0;
+    if(next_gate < gates.size() && gates[next_gate].start <= frame) voltage = gates[next_gate].voltage;
+
+    module->inputs[port].setChannels(1);
+    module->inputs[port].setVoltage(voltage);
+  }
+};
+
+//
+// Output
+//
+
+// Writes 32 bit float .wav files in chunks, so that long renders don't have
+// to fit in memory.
+struct WavWriter
+{
+  FILE *file = NULL;
+  unsigned int channels = 0;
+  uint64_t frames = 0;
+
+  bool open(std::string path, unsigned int channels, unsigned int sample_rate)
+  {
+    file = std::fopen(path.c_str(), "wb");
+    if(! file) return(false);
+
+    this->channels = channels;
+    writeHeader(sample_rate);
+    return(true);
+  }
+
+  void write(const float *frame)
+  {
+    std::fwrite(frame, sizeof(float), channels, file);
+    frames++;
+  }
+
+  void close(unsigned int sample_rate)
+  {
+    if(! file) return;
+
+    // Go back and fill in the sizes
+    std::fseek(file, 0, SEEK_SET);
+    writeHeader(sample_rate);
+    std::fclose(file);
+    file = NULL;
+  }
+
+  void writeUInt32(uint32_t value)
+  {
+    uint8_t bytes[4] = { (uint8_t) value, (uint8_t) (value >> 8), (uint8_t) (value >> 16), (uint8_t) (value >> 24) };
+    std::fwrite(bytes, 1, 4, file);
+  }
+
+  void writeUInt16(uint16_t value)
+  {
+    uint8_t bytes[2] = { (uint8_t) value, (uint8_t) (value >> 8) };
+    std::fwrite(bytes, 1, 2, file);
+  }
+
+  void writeHeader(unsigned int sample_rate)
+  {
+    // Sizes are clamped for renders that go past the 4GB limit of .wav
+    uint64_t data_size = std::min(frames * channels * sizeof(float), (uint64_t) 0xFFFFFFFF - 36);
+
+    std::fwrite("RIFF", 1, 4, file);
+    writeUInt32(36 + data_size);
+    std::fwrite("WAVE", 1, 4, file);
+
+    std::fwrite("fmt ", 1, 4, file);
+    writeUInt32(16);
+    writeUInt16(3);                                   // IEEE float
+    writeUInt16(channels);
+    writeUInt32(sample_rate);
+    writeUInt32(sample_rate * channels * sizeof(float));
+    writeUInt16(channels * sizeof(float));
+    writeUInt16(32);
+
+    std::fwrite("data", 1, 4, file);
+    writeUInt32(data_size);
+  }
+};
+
+//
+// Setup
+//
+
+void usage()
+{
+  fprintf(stderr, "usage: offline_render --module <slug> [--preset <file>] [--seconds <n>] [--sample-rate <hz>]\n");
+  fprintf(stderr, "                      [--input <port>=<file.wav>[@<gain>]] [--gate <port>=<file.txt>]\n");
+  fprintf(stderr, "                      [--output <file.wav>] [--outputs <a,b,...>] [--seed <n>]\n");
+}
+
+plugin::Model *findModel(plugin::Plugin *voxglitch_plugin, std::string slug)
+{
+  for(plugin::Model *model : voxglitch_plugin->models)
+  {
+    if(model->slug == slug) return(model);
+  }
+
+  return(NULL);
+}
+
+// Returns the module's JSON from a preset or from an uncompressed patch
+json_t *findModuleJson(json_t *root, std::string slug)
+{
+  json_t *modules_json = json_object_get(root, "modules");
+  if(! modules_json) return(root);
+
+  size_t index;
+  json_t *module_json;
+
+  json_array_foreach(modules_json, index, module_json)
+  {
+    json_t *model_json = json_object_get(module_json, "model");
+    if(model_json && slug == json_string_value(model_json)) return(module_json);
+  }
+
+  return(NULL);
+}
+
+bool splitPortArgument(std::string argument, unsigned int *port, std::string *value)
+{
+  size_t equals = argument.find('=');
+  if(equals == std::string::npos) return(false);
+
+  *port = std::atoi(argument.substr(0, equals).c_str());
+  *value = argument.substr(equals + 1);
+  return(true);
+}
+
+int main(int argc, char **argv)
+{
+  std::string module_slug;
+  std::string preset_path;
+  std::string output_path;
+  std::string output_list;
+  float seconds = 10.0;
+  float sample_rate = 48000.0;
+  uint64_t seed = 1;
+  std::vector<std::string> input_arguments;
+  std::vector<std::string> gate_arguments;
+
+  for(int i = 1; i < argc; i++)
+  {
+    std::string argument = argv[i];
+    bool has_value = (i + 1) < argc;
+
+    if(argument == "--module" && has_value) module_slug = argv[++i];
+    else if(argument == "--preset" && has_value) preset_path = argv[++i];
+    else if(argument == "--seconds" && has_value) seconds = std::atof(argv[++i]);
+    else if(argument == "--sample-rate" && has_value) sample_rate = std::atof(argv[++i]);
+    else if(argument == "--input" && has_value) input_arguments.push_back(argv[++i]);
+    else if(argument == "--gate" && has_value) gate_arguments.push_back(argv[++i]);
+    else if(argument == "--output" && has_value) output_path = argv[++i];
+    else if(argument == "--outputs" && has_value) output_list = argv[++i];
+    else if(argument == "--seed" && has_value) seed = std::strtoull(argv[++i], NULL, 10);
+    else
+    {
+      usage();
+      return(1);
+    }
+  }
+
+  if(module_slug.empty() || seconds <= 0 || sample_rate <= 0)
+  {
+    usage();
+    return(1);
+  }
+
+  // Make every source of randomness repeatable.  Rack's own generator is
+  // seeded first, so that random::init() (which some modules call) leaves it
+  // alone.
+  random_seed.store(seed ? seed : 1);
+  std::srand(seed);
+  random::local().seed(seed, seed ^ 0x9E3779B97F4A7C15ULL);
+
+  // The parts of Rack that modules rely on when they aren't in a patch.
+  // Development mode keeps Rack's user folder in the current directory and
+  // sends log messages to stderr.
+  settings::devMode = true;
+  asset::init();
+  logger::init();
+
+  contextSet(new Context);
+  APP->engine = new engine::Engine;
+
+  plugin::Plugin *voxglitch_plugin = new plugin::Plugin;
+  voxglitch_plugin->slug = "voxglitch";
+  init(voxglitch_plugin);
+
+  plugin::Model *model = findModel(voxglitch_plugin, module_slug);
+
+  if(! model)
+  {
+    fprintf(stderr, "Unknown module \"%s\".  Available modules:\n", module_slug.c_str());
+    for(plugin::Model *available_model : voxglitch_plugin->models) fprintf(stderr, "  %s\n", available_model->slug.c_str());
+    return(1);
+  }
+
+  engine::Module *module = model->createModule();
+  APP->engine->addModule(module);
+  APP->engine->setSampleRate(sample_rate);
+
+  //
+  // Load the module's state
+  //
+
+  if(! preset_path.empty())
+  {
+    json_error_t error;
+    json_t *root = json_load_file(preset_path.c_str(), 0, &error);
+
+    if(! root)
+    {
+      fprintf(stderr, "Couldn't read %s: %s (line %d)\n", preset_path.c_str(), error.text, error.line);
+      return(1);
+    }
+
+    json_t *module_json = findModuleJson(root, module_slug);
+
+    if(! module_json)
+    {
+      fprintf(stderr, "%s doesn't contain a %s module\n", preset_path.c_str(), module_slug.c_str());
+      return(1);
+    }
+
+    try
+    {
+      module->fromJson(module_json);
+    }
+    catch(Exception &e)
+    {
+      fprintf(stderr, "Couldn't load %s: %s\n", preset_path.c_str(), e.what());
+      return(1);
+    }
+
+    json_decref(root);
+  }
+
+  // Samples referenced by the preset have already been loaded.  With
+  // VOXGLITCH_OFFLINE_RENDER defined, the SampleLoader decodes each file as
+  // soon as it's requested, and sample banks are serviced from process()
+  // rather than by a worker thread, so every render starts from the same
+  // state, and picks up new samples on the same frame.
+
+  //
+  // Inputs
+  //
+
+  std::vector<WavInput *> wav_inputs;
+  std::vector<GateInput *> gate_inputs;
+
+  for(std::string argument : input_arguments)
+  {
+    unsigned int port;
+    std::string value;
+    if(! splitPortArgument(argument, &port, &value) || port >= module->inputs.size())
+    {
+      fprintf(stderr, "Bad input: %s\n", argument.c_str());
+      return(1);
+    }
+
+    WavInput *wav_input = new WavInput();
+    wav_input->port = port;
+
+    size_t at = value.rfind('@');
+    if(at != std::string::npos)
+    {
+      wav_input->gain = std::atof(value.substr(at + 1).c_str());
+      value = value.substr(0, at);
+    }
+
+    if(! wav_input->load(value))
+    {
+      fprintf(stderr, "Couldn't load %s\n", value.c_str());
+      return(1);
+    }
+
+    wav_inputs.push_back(wav_input);
+  }
+
+  for(std::string argument : gate_arguments)
+  {
+    unsigned int port;
+    std::string value;
+    GateInput *gate_input = new GateInput();
+
+    if(! splitPortArgument(argument, &port, &value) || port >= module->inputs.size() || ! gate_input->load(value, sample_rate))
+    {
+      fprintf(stderr, "Bad gate input: %s\n", argument.c_str());
+      return(1);
+    }
+
+    gate_input->port = port;
+    gate_inputs.push_back(gate_input);
+  }
+
+  //
+  // Outputs
+  //
+
+  std::vector<unsigned int> output_ports;
+
+  if(output_list.empty())
+  {
+    for(unsigned int i = 0; i < module->outputs.size(); i++) output_ports.push_back(i);
+  }
+  else
+  {
+    std::istringstream ports(output_list);
+    std::string port;
+    while(std::getline(ports, port, ',')) output_ports.push_back(std::atoi(port.c_str()));
+  }
+
+  for(unsigned int port : output_ports)
+  {
+    if(port >= module->outputs.size())
+    {
+      fprintf(stderr, "Module only has %d outputs\n", (int) module->outputs.size());
+      return(1);
+    }
+
+    // Modules often skip work for outputs which aren't patched
+    module->outputs[port].setChannels(1);
+  }
+
+  WavWriter wav_writer;
+
+  if(! output_path.empty() && ! wav_writer.open(output_path, output_ports.size(), sample_rate))
+  {
+    fprintf(stderr, "Couldn't write %s\n", output_path.c_str());
+    return(1);
+  }
+
+  //
+  // Render
+  //
+
+  uint64_t total_frames = (uint64_t) (seconds * sample_rate);
+  std::vector<float> frame_output(output_ports.size());
+  uint64_t hash = 0xcbf29ce484222325ULL;  // FNV-1a
+
+  engine::Module::ProcessArgs args;
+  args.sampleRate = sample_rate;
+  args.sampleTime = 1.0 / sample_rate;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  for(uint64_t frame = 0; frame < total_frames; frame++)
+  {
+    for(WavInput *wav_input : wav_inputs) wav_input->apply(module, frame);
+    for(GateInput *gate_input : gate_inputs) gate_input->apply(module, frame);
+
+    args.frame = frame;
+    module->process(args);
+
+    for(unsigned int i = 0; i < output_ports.size(); i++)
+    {
+      float voltage = module->outputs[output_ports[i]].getVoltage();
+
+      uint32_t bits;
+      std::memcpy(&bits, &voltage, sizeof(bits));
+      for(unsigned int b = 0; b < 4; b++)
+      {
+        hash ^= (bits >> (b * 8)) & 0xFF;
+        hash *= 0x100000001b3ULL;
+      }
+
+      frame_output[i] = voltage / 5.0;
+    }
+
+    if(wav_writer.file) wav_writer.write(frame_output.data());
+  }
+
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+  wav_writer.close(sample_rate);
+
+  double elapsed = std::chrono::duration<double>(end - start).count();
+
+  printf("module:     %s\n", module_slug.c_str());
+  printf("rendered:   %.1f s at %.0f Hz\n", seconds, sample_rate);
+  printf("took:       %.3f s (%.1fx real time, %.1f ns/frame)\n", elapsed, seconds / elapsed, (elapsed * 1e9) / total_frames);
+  printf("hash:       %016llx\n", (unsigned long long) hash);
+
+  // Skip tearing down the engine and plugin.  The process is about to exit.
+  return(0);
+}
@@ -30,14 +30,30 @@ struct Autobreak : VoxglitchSamplerModule
   bool clock_triggered = false;
   bool ratchet_triggered = false;
 
-  // StereoSmoothSubModule loop_smooth;
-  DeclickFilter declick_filter;
+  // Fits the loop to the tempo without changing its pitch.  When turned off,
+  // the loop is played faster or slower instead, like a record, through
+  // slice_crossfade.  Both crossfade from the old position whenever playback
+  // jumps (see SliceCrossfade.hpp).  On for new modules, but off for patches
+  // saved before it existed (see dataFromJson()).
+  TimeStretch time_stretch;
+  SliceCrossfade slice_crossfade;
+  bool time_stretching = true;
+
+  // Jumps land on the drum hits found in each sample (see SliceMap.hpp)
+  // instead of on equal divisions of the loop.  On for new modules, but off
+  // for patches saved before it existed (see dataFromJson()).
+  bool snap_to_transients = true;
 
   std::string root_dir;
   std::string path;
 
+  // Samples are loaded in the background, along with the analysis used for
+  // time stretching and the slice map, and swapped in by process()
   Sample samples[NUMBER_OF_SAMPLES];
-  std::string loaded_filenames[NUMBER_OF_SAMPLES] = {""};
+  TimeStretchAnalysis stretch_analyses[NUMBER_OF_SAMPLES];
+  SliceMap slice_maps[NUMBER_OF_SAMPLES];
+  LoadSlot<BreakbeatLoadRequest> load_slots[NUMBER_OF_SAMPLES];
+  PathHandle loaded_paths[NUMBER_OF_SAMPLES];   // Read by the GUI, as the samples may be swapped at any time
 
   dsp::SchmittTrigger resetTrigger;
   dsp::SchmittTrigger clockTrigger;
@@ -77,8 +93,6 @@ struct Autobreak : VoxglitchSamplerModule
     config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
     configParam(WAV_KNOB, 0.0f, 1.0f, 0.0f, "SampleSelectKnob");
     configParam(WAV_ATTN_KNOB, 0.0f, 1.0f, 1.0f, "SampleSelectAttnKnob");
-
-    std::fill_n(loaded_filenames, NUMBER_OF_SAMPLES, "[ EMPTY ]");
   }
 
   // Autosave settings
@@ -91,9 +105,12 @@ struct Autobreak : VoxglitchSamplerModule
     json_t *json_root = json_object();
     for(int i=0; i < NUMBER_OF_SAMPLES; i++)
     {
-      json_object_set_new(json_root, ("loaded_sample_path_" + std::to_string(i+1)).c_str(), json_string(samples[i].path.c_str()));
+      json_object_set_new(json_root, ("loaded_sample_path_" + std::to_string(i+1)).c_str(), json_string(loaded_paths[i].path().c_str()));
     }
 
+    json_object_set_new(json_root, "time_stretching", json_boolean(time_stretching));
+    json_object_set_new(json_root, "snap_to_transients", json_boolean(snap_to_transients));
+
     return json_root;
   }
 
@@ -109,10 +126,66 @@ struct Autobreak : VoxglitchSamplerModule
       json_t *loaded_sample_path = json_object_get(json_root, ("loaded_sample_path_" +  std::to_string(i+1)).c_str());
       if (loaded_sample_path)
       {
-        samples[i].load(json_string_value(loaded_sample_path));
-        loaded_filenames[i] = samples[i].filename;
+        loadSample(i, json_string_value(loaded_sample_path));
       }
     }
+
+    // Patches saved before time stretching existed played the loop like a
+    // record, so they keep doing so
+    json_t *time_stretching_json = json_object_get(json_root, "time_stretching");
+    time_stretching = (time_stretching_json && json_is_true(time_stretching_json));
+
+    // Likewise, slices in older patches start at equal divisions of the loop
+    json_t *snap_to_transients_json = json_object_get(json_root, "snap_to_transients");
+    snap_to_transients = (snap_to_transients_json && json_is_true(snap_to_transients_json));
+  }
+
+  // Called from the GUI thread.  The sample is swapped in by process() once
+  // it has loaded.
+  void loadSample(unsigned int sample_number, std::string path)
+  {
+    load_slots[sample_number].post(SampleLoader::instance().submit(new BreakbeatLoadRequest(path)));
+  }
+
+  void acceptLoadedSample(unsigned int sample_number)
+  {
+    BreakbeatLoadRequest *load_request = load_slots[sample_number].take();
+    if(load_request == NULL) return;
+
+    if(load_request->success)
+    {
+      samples[sample_number].swap(load_request->sample);
+      stretch_analyses[sample_number].swap(load_request->analysis);
+      slice_maps[sample_number].swap(load_request->slice_map);
+      loaded_paths[sample_number].store(load_request->path_handle);
+
+      if(sample_number == selected_sample_slot)
+      {
+        time_stretch.jump();
+        slice_crossfade.jump();
+      }
+    }
+
+    // The request now holds the old sample, which the loader will free
+    load_request->release();
+  }
+
+  // Returns the theoretical playback position at which slice
+  // _breakbeat_location_ (0 to 15) starts.  The slices divide the loop
+  // equally, but with snap_to_transients on, each one starts at the drum hit
+  // nearest to it instead, if there's one within half a slice.
+  float slicePosition(int breakbeat_location, float samples_to_play_per_loop)
+  {
+    float position = breakbeat_location * (samples_to_play_per_loop / 16.0f);
+
+    SliceMap *slice_map = &slice_maps[selected_sample_slot];
+    if(! snap_to_transients || slice_map->empty()) return(position);
+
+    float sample_length = samples[selected_sample_slot].size();
+    float actual_position = (position / samples_to_play_per_loop) * sample_length;
+    float snapped_position = slice_map->snap(actual_position, sample_length / 32.0f);
+
+    return((snapped_position / sample_length) * samples_to_play_per_loop);
   }
 
   float calculate_inputs(int input_index, int knob_index, int attenuator_index, float scale)
@@ -126,15 +199,17 @@ struct Autobreak : VoxglitchSamplerModule
 
   void process(const ProcessArgs &args) override
   {
+    for(unsigned int i=0; i < NUMBER_OF_SAMPLES; i++)
+    {
+      acceptLoadedSample(i);
+    }
+
     unsigned int wav_input_value = calculate_inputs(WAV_INPUT, WAV_KNOB, WAV_ATTN_KNOB, NUMBER_OF_SAMPLES);
     wav_input_value = clamp(wav_input_value, 0, NUMBER_OF_SAMPLES - 1);
 
     if(wav_input_value != selected_sample_slot)
     {
-      // Reset the smooth ramp if the selected sample has changed
-      declick_filter.trigger();
-
-      // Set the selected sample
+      // Set the selected sample.  Playback crossfades to it by itself.
       selected_sample_slot = wav_input_value;
     }
 
@@ -176,8 +251,9 @@ struct Autobreak : VoxglitchSamplerModule
         actual_playback_position = 0;
         theoretical_playback_position = 0;
 
-        // Smooth back into playback
-        declick_filter.trigger();
+        // Crossfade back into playback
+        time_stretch.jump();
+        slice_crossfade.jump();
       }
     }
 
@@ -187,21 +263,25 @@ struct Autobreak : VoxglitchSamplerModule
       // 8.0 is for 8 beats (2 bars) of loops, which is a typical drum loop length
       float samples_to_play_per_loop = ((60.0 / bpm) * args.sampleRate) * 8.0;
 
-      actual_playback_position = clamp(actual_playback_position, 0.0, selected_sample->size() - 1);
+      bool reverse = (inputs[REVERSE_INPUT].getVoltage() >= 5);
 
-      selected_sample->read((int)actual_playback_position, &left_output, &right_output);
+      actual_playback_position = clamp(actual_playback_position, 0.0, selected_sample->size() - 1);
 
-      // Handle smoothing
-      // float smooth_rate = (128.0f / args.sampleRate);
-      // loop_smooth.process(left_output * GAIN, right_output * GAIN, smooth_rate, &left_output, &right_output);
-      declick_filter.process(&left_output, &right_output);
+      if(time_stretching)
+      {
+        time_stretch.process(selected_sample, &stretch_analyses[selected_sample_slot], actual_playback_position, reverse ? -1 : 1, &left_output, &right_output);
+      }
+      else
+      {
+        slice_crossfade.process(selected_sample, actual_playback_position, &left_output, &right_output);
+      }
 
       // Output audio
       outputs[AUDIO_OUTPUT_LEFT].setVoltage(left_output * GAIN);
       outputs[AUDIO_OUTPUT_RIGHT].setVoltage(right_output * GAIN);
 
       // Step the theoretical playback position
-      if(inputs[REVERSE_INPUT].getVoltage() >= 5)
+      if(reverse)
       {
         theoretical_playback_position = theoretical_playback_position - 1;
       }
@@ -220,7 +300,7 @@ struct Autobreak : VoxglitchSamplerModule
 
         if(breakbeat_location != -1)
         {
-          theoretical_playback_position = breakbeat_location * (samples_to_play_per_loop / 16.0f);
+          theoretical_playback_position = slicePosition(breakbeat_location, samples_to_play_per_loop);
         }
 
         clock_triggered = false;
@@ -235,7 +315,7 @@ struct Autobreak : VoxglitchSamplerModule
 
           if(breakbeat_location != -1)
           {
-            theoretical_playback_position = breakbeat_location * (samples_to_play_per_loop / 16.0f);
+            theoretical_playback_position = slicePosition(breakbeat_location, samples_to_play_per_loop);
           }
           ratchet_triggered = false;
         }
@@ -245,12 +325,10 @@ struct Autobreak : VoxglitchSamplerModule
       if(theoretical_playback_position >= samples_to_play_per_loop)
       {
         theoretical_playback_position = 0;
-        declick_filter.trigger();
       }
       else if (theoretical_playback_position < 0)
       {
         theoretical_playback_position = samples_to_play_per_loop;
-        declick_filter.trigger();
       }
 
       // Map the theoretical playback position to the actual sample playback position
@@ -8,7 +8,12 @@
 #include "osdialog.h"
 #include "Common/constants.h"
 #include "Common/sample.hpp"
-#include "Common/dsp/DeclickFilter.hpp"
+#include "Common/SampleLoader.hpp"
+#include "Common/TimeStretch.hpp"
+#include "Common/SliceMap.hpp"
+#include "Common/SliceCrossfade.hpp"
+#include "Common/BreakbeatLoadRequest.hpp"
+#include "Common/OverviewLoadRequest.hpp"
 #include "Common/dsp/StereoPan.hpp"
 
 #include "Common/Theme.hpp"
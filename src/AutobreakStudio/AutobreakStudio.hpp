@@ -45,18 +45,35 @@ struct AutobreakStudio : VoxglitchSamplerModule
   // the correct step.
   unsigned int sequencer_step = 0;
 
-  // StereoSmoothSubModule loop_smooth;
-  DeclickFilter declick_filter;
   StereoPan stereo_pan;
 
+  // Fits the loop to the tempo without changing its pitch.  When turned off,
+  // the loop is played faster or slower instead, like a record, through
+  // slice_crossfade.  Both crossfade from the old position whenever playback
+  // jumps (see SliceCrossfade.hpp).  On for new modules, but off for patches
+  // saved before it existed (see dataFromJson()).
+  TimeStretch time_stretch;
+  SliceCrossfade slice_crossfade;
+  bool time_stretching = true;
+
+  // Jumps land on the drum hits found in each sample (see SliceMap.hpp)
+  // instead of on equal divisions of the loop.  On for new modules, but off
+  // for patches saved before it existed (see dataFromJson()).
+  bool snap_to_transients = true;
+
   std::string root_dir;
   std::string path;
 
   // bool waveform_visible[NUMBER_OF_SAMPLES];
   // float waveform_playback_percentage = 0.0;
 
+  // Samples are loaded in the background, along with the analysis used for
+  // time stretching and the slice map, and swapped in by process()
   Sample samples[NUMBER_OF_SAMPLES];
-  std::string loaded_filenames[NUMBER_OF_SAMPLES] = {""};
+  TimeStretchAnalysis stretch_analyses[NUMBER_OF_SAMPLES];
+  SliceMap slice_maps[NUMBER_OF_SAMPLES];
+  LoadSlot<BreakbeatLoadRequest> load_slots[NUMBER_OF_SAMPLES];
+  PathHandle loaded_paths[NUMBER_OF_SAMPLES];   // Read by the GUI, as the samples may be swapped at any time
 
   dsp::SchmittTrigger resetTrigger;
   dsp::SchmittTrigger clockTrigger;
@@ -148,13 +165,12 @@ struct AutobreakStudio : VoxglitchSamplerModule
     for(unsigned int i=0; i<NUMBER_OF_SAMPLES; i++)
     {
       waveform_model[i].sample = &samples[i];
+      waveform_model[i].loaded_path = &loaded_paths[i];
       waveform_model[i].visible = false;
       waveform_model[i].playback_percentage = 0.0;
     }
     waveform_model[0].visible = true;
 
-    std::fill_n(loaded_filenames, NUMBER_OF_SAMPLES, "[ EMPTY ]");
-
     clock_ignore_on_reset = (long) (44100 / 100);
   }
 
@@ -167,7 +183,7 @@ struct AutobreakStudio : VoxglitchSamplerModule
     json_t *json_root = json_object();
     for (int i = 0; i < NUMBER_OF_SAMPLES; i++)
     {
-      json_object_set_new(json_root, ("loaded_sample_path_" + std::to_string(i + 1)).c_str(), json_string(samples[i].path.c_str()));
+      json_object_set_new(json_root, ("loaded_sample_path_" + std::to_string(i + 1)).c_str(), json_string(loaded_paths[i].path().c_str()));
     }
 
     //
@@ -195,6 +211,9 @@ struct AutobreakStudio : VoxglitchSamplerModule
     // Save which memory is selected
     json_object_set(json_root, "selected_memory_index", json_integer(selected_memory_index));
 
+    json_object_set_new(json_root, "time_stretching", json_boolean(time_stretching));
+    json_object_set_new(json_root, "snap_to_transients", json_boolean(snap_to_transients));
+
     return json_root;
   }
 
@@ -224,11 +243,19 @@ struct AutobreakStudio : VoxglitchSamplerModule
       json_t *loaded_sample_path = json_object_get(json_root, ("loaded_sample_path_" + std::to_string(i + 1)).c_str());
       if (loaded_sample_path)
       {
-        samples[i].load(json_string_value(loaded_sample_path));
-        loaded_filenames[i] = samples[i].filename;
+        loadSample(i, json_string_value(loaded_sample_path));
       }
     }
 
+    // Patches saved before time stretching existed played the loop like a
+    // record, so they keep doing so
+    json_t *time_stretching_json = json_object_get(json_root, "time_stretching");
+    time_stretching = (time_stretching_json && json_is_true(time_stretching_json));
+
+    // Likewise, slices in older patches start at equal divisions of the loop
+    json_t *snap_to_transients_json = json_object_get(json_root, "snap_to_transients");
+    snap_to_transients = (snap_to_transients_json && json_is_true(snap_to_transients_json));
+
     //
     // Load Memory Data
     //
@@ -286,6 +313,55 @@ struct AutobreakStudio : VoxglitchSamplerModule
     sequencer->setLength(json_integer_value(sequencer_length_json));
   }
 
+  // Called from the GUI thread.  The sample is swapped in by process() once
+  // it has loaded.
+  void loadSample(unsigned int sample_number, std::string path)
+  {
+    load_slots[sample_number].post(SampleLoader::instance().submit(new BreakbeatLoadRequest(path)));
+  }
+
+  void acceptLoadedSample(unsigned int sample_number)
+  {
+    BreakbeatLoadRequest *load_request = load_slots[sample_number].take();
+    if(load_request == NULL) return;
+
+    if(load_request->success)
+    {
+      samples[sample_number].swap(load_request->sample);
+      stretch_analyses[sample_number].swap(load_request->analysis);
+      slice_maps[sample_number].swap(load_request->slice_map);
+      loaded_paths[sample_number].store(load_request->path_handle);
+      waveform_model[sample_number].sample_revision++;
+
+      if(sample_number == selected_sample_slot)
+      {
+        time_stretch.jump();
+        slice_crossfade.jump();
+      }
+    }
+
+    // The request now holds the old sample, which the loader will free
+    load_request->release();
+  }
+
+  // Returns the theoretical playback position at which slice
+  // _breakbeat_location_ (0 to 15) starts.  The slices divide the loop
+  // equally, but with snap_to_transients on, each one starts at the drum hit
+  // nearest to it instead, if there's one within half a slice.
+  float slicePosition(int breakbeat_location, float samples_to_play_per_loop)
+  {
+    float position = breakbeat_location * (samples_to_play_per_loop / 16.0f);
+
+    SliceMap *slice_map = &slice_maps[selected_sample_slot];
+    if(! snap_to_transients || slice_map->empty()) return(position);
+
+    float sample_length = samples[selected_sample_slot].size();
+    float actual_position = (position / samples_to_play_per_loop) * sample_length;
+    float snapped_position = slice_map->snap(actual_position, sample_length / 32.0f);
+
+    return((snapped_position / sample_length) * samples_to_play_per_loop);
+  }
+
   void selectMemory(unsigned int i)
   {
     selected_memory_index = i;
@@ -396,6 +472,10 @@ struct AutobreakStudio : VoxglitchSamplerModule
 
   void process(const ProcessArgs &args) override
   {
+    for(unsigned int i = 0; i < NUMBER_OF_SAMPLES; i++)
+    {
+      acceptLoadedSample(i);
+    }
 
     // Process clear button
     if (clearButtonTrigger.process(params[CLEAR_BUTTON].getValue()))
@@ -478,8 +558,9 @@ struct AutobreakStudio : VoxglitchSamplerModule
         theoretical_playback_position = 0;
         ratchet_counter = 0;
 
-        // Smooth back into playback
-        declick_filter.trigger();
+        // Crossfade back into playback
+        time_stretch.jump();
+        slice_crossfade.jump();
 
         // Reset all of the sequencers
         position_sequencer->reset();
@@ -552,10 +633,7 @@ struct AutobreakStudio : VoxglitchSamplerModule
       waveform_model[selected_sample_slot].visible = false;
       waveform_model[sample_selection].visible = true;
 
-      // Reset the smooth ramp if the selected sample has changed
-      declick_filter.trigger();
-
-      // Set the selected sample
+      // Set the selected sample.  Playback crossfades to it by itself.
       selected_sample_slot = sample_selection;
     }
     Sample *selected_sample = &samples[selected_sample_slot];
@@ -624,6 +702,8 @@ struct AutobreakStudio : VoxglitchSamplerModule
     // 8.0 is for 8 beats (2 bars) of loops, which is a typical drum loop length
     float samples_to_play_per_loop = ((60.0 / bpm) * args.sampleRate) * 8.0;
 
+    bool reverse = (getReverse() >= 0.5);
+
     //
     // Calculate playback position and output sample audio
     //
@@ -638,7 +718,14 @@ struct AutobreakStudio : VoxglitchSamplerModule
       waveform_model[selected_sample_slot].playback_percentage = actual_playback_position / selected_sample->size();
 
       // Read the sample
-      selected_sample->read((int)actual_playback_position, &left_output, &right_output);
+      if (time_stretching)
+      {
+        time_stretch.process(selected_sample, &stretch_analyses[selected_sample_slot], actual_playback_position, reverse ? -1 : 1, &left_output, &right_output);
+      }
+      else
+      {
+        slice_crossfade.process(selected_sample, actual_playback_position, &left_output, &right_output);
+      }
 
       // Apply volume to output values
       left_output = getVolume() * left_output;
@@ -647,9 +734,6 @@ struct AutobreakStudio : VoxglitchSamplerModule
       // Apply pan
       stereo_pan.process(&left_output, &right_output, ((getPan() * 2.0) - 1.0));
 
-      // Handle smoothing
-      declick_filter.process(&left_output, &right_output);
-
       // Output audio
       outputs[AUDIO_OUTPUT_LEFT].setVoltage(left_output * GAIN);
       outputs[AUDIO_OUTPUT_RIGHT].setVoltage(right_output * GAIN);
@@ -660,7 +744,7 @@ struct AutobreakStudio : VoxglitchSamplerModule
     }
 
     // Step the theoretical playback position
-    if (getReverse() >= 0.5)
+    if (reverse)
     {
       theoretical_playback_position = theoretical_playback_position - 1;
     }
@@ -691,7 +775,7 @@ struct AutobreakStudio : VoxglitchSamplerModule
 
       if (breakbeat_location != -1)
       {
-        theoretical_playback_position = breakbeat_location * (samples_to_play_per_loop / 16.0f);
+        theoretical_playback_position = slicePosition(breakbeat_location, samples_to_play_per_loop);
       }
 
       ratchet_counter = 0;
@@ -706,7 +790,7 @@ struct AutobreakStudio : VoxglitchSamplerModule
 
         if (breakbeat_location != -1)
         {
-          theoretical_playback_position = breakbeat_location * (samples_to_play_per_loop / 16.0f);
+          theoretical_playback_position = slicePosition(breakbeat_location, samples_to_play_per_loop);
         }
         ratchet_triggered = false;
       }
@@ -719,12 +803,10 @@ struct AutobreakStudio : VoxglitchSamplerModule
     if (theoretical_playback_position >= samples_to_play_per_loop)
     {
       theoretical_playback_position = 0;
-      declick_filter.trigger();
     }
     else if (theoretical_playback_position < 0)
     {
       theoretical_playback_position = samples_to_play_per_loop;
-      declick_filter.trigger();
     }
 
     // Map the theoretical playback position to the actual sample playback position
@@ -39,8 +39,7 @@ struct AutobreakStudioLoadFolder : MenuItem
                 {
                     if (i < 8)
                     {
-                        module->samples[i].load(filename);
-                        module->loaded_filenames[i] = module->samples[i].filename;
+                        module->loadSample(i, filename);
                         module->setRoot(filename);
                         i++;
                     }
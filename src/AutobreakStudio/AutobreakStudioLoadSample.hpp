@@ -24,8 +24,8 @@ struct AutobreakStudioLoadSample : MenuItem
 	{
 		if (filename != "")
 		{
-			module->samples[sample_number].load(filename);
-			module->loaded_filenames[sample_number] = module->samples[sample_number].filename;
+			// The sample is loaded in the background and swapped in by process()
+			module->loadSample(sample_number, filename);
 			module->setRoot(filename);
 		}
 	}
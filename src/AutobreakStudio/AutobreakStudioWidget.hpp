@@ -158,6 +158,26 @@ struct AutobreakStudioWidget : VoxglitchSamplerModuleWidget
 		addOutput(createOutputCentered<VoxglitchOutputPort>(themePos("AUDIO_OUTPUT_RIGHT"), module, AutobreakStudio::AUDIO_OUTPUT_RIGHT));
 	}
 
+	struct TimeStretchingMenuItem : MenuItem
+	{
+		AutobreakStudio *module;
+
+		void onAction(const event::Action &e) override
+		{
+			module->time_stretching ^= true;
+		}
+	};
+
+	struct SnapToTransientsMenuItem : MenuItem
+	{
+		AutobreakStudio *module;
+
+		void onAction(const event::Action &e) override
+		{
+			module->snap_to_transients ^= true;
+		}
+	};
+
 	void appendContextMenu(Menu *menu) override
 	{
 		AutobreakStudio *module = dynamic_cast<AutobreakStudio *>(this->module);
@@ -176,7 +196,8 @@ struct AutobreakStudioWidget : VoxglitchSamplerModuleWidget
 		{
 			AutobreakStudioLoadSample *menu_item_load_sample = new AutobreakStudioLoadSample;
 			menu_item_load_sample->sample_number = i;
-			menu_item_load_sample->text = std::to_string(i + 1) + ": " + module->loaded_filenames[i];
+			std::string filename = system::getFilename(module->loaded_paths[i].path());
+			menu_item_load_sample->text = std::to_string(i + 1) + ": " + (filename == "" ? "[ EMPTY ]" : filename);
 			menu_item_load_sample->module = module;
 			menu->addChild(menu_item_load_sample);
 		}
@@ -193,6 +214,14 @@ struct AutobreakStudioWidget : VoxglitchSamplerModuleWidget
 		// Add interpolation menu
 		//
 		menu->addChild(new MenuEntry); // For spacing only
+		TimeStretchingMenuItem *time_stretching_menu_item = createMenuItem<TimeStretchingMenuItem>("Keep pitch when tempo changes", CHECKMARK(module->time_stretching));
+		time_stretching_menu_item->module = module;
+		menu->addChild(time_stretching_menu_item);
+
+		SnapToTransientsMenuItem *snap_to_transients_menu_item = createMenuItem<SnapToTransientsMenuItem>("Snap slices to drum hits", CHECKMARK(module->snap_to_transients));
+		snap_to_transients_menu_item->module = module;
+		menu->addChild(snap_to_transients_menu_item);
+
 		SampleInterpolationMenuItem *sample_interpolation_menu_item = createMenuItem<SampleInterpolationMenuItem>("Interpolation", RIGHT_ARROW);
 		sample_interpolation_menu_item->module = module;
 		menu->addChild(sample_interpolation_menu_item);
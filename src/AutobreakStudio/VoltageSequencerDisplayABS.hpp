@@ -14,6 +14,13 @@ struct VoltageSequencerDisplayABS : SequencerDisplayABS
     int control_sequence_column = 0;
     unsigned int sequencer_type = 0;
 
+    // The pattern is drawn into the cached layer, and only drawn again when
+    // the sequencer or the room brightness change.
+    CachedLayer *cached_layer = NULL;
+    VoltageSequencer *drawn_sequencer = NULL;
+    unsigned int drawn_revision = 0;
+    float drawn_brightness = -1.0;
+
     VoltageSequencerDisplayABS(VoltageSequencer **sequencer_instance, unsigned int sequencer_type)
     {
         this->sequencer_ptr_ptr = sequencer_instance;
@@ -24,95 +31,120 @@ struct VoltageSequencerDisplayABS : SequencerDisplayABS
         // which is why 16 is being added to the draw height to define the
         // bounding box.
         box.size = Vec(DRAW_AREA_WIDTH, DRAW_AREA_HEIGHT + 16);
+
+        cached_layer = new CachedLayer(box.size, [this](NVGcontext *vg) { drawPattern(vg); });
+        addChild(cached_layer);
+    }
+
+    void step() override
+    {
+        SequencerDisplayABS::step();
+
+        if (module)
+        {
+            VoltageSequencer *sequencer = *sequencer_ptr_ptr;
+
+            if (sequencer != drawn_sequencer || sequencer->revision != drawn_revision)
+            {
+                drawn_sequencer = sequencer;
+                drawn_revision = sequencer->revision;
+                cached_layer->setDirty();
+            }
+        }
+
+        if (settings::rackBrightness != drawn_brightness)
+        {
+            drawn_brightness = settings::rackBrightness;
+            cached_layer->setDirty();
+        }
     }
 
     void drawLayer(const DrawArgs &args, int layer) override
     {
         if (layer == 1)
         {
-            const auto vg = args.vg;
-            double value;
-            NVGcolor bar_color;
+            cached_layer->drawCached(args);
+        }
+    }
+
+    void drawPattern(NVGcontext *vg)
+    {
+        double value;
+        NVGcolor bar_color;
 
-            // Save the drawing context to restore later
-            nvgSave(vg);
+        if (module)
+        {
+            // Get a pointer to the Voltage Sequencer
+            VoltageSequencer *sequencer = *sequencer_ptr_ptr;
 
-            if (module)
+            //
+            // Display the pattern
+            //
+            for (unsigned int i = 0; i < MAX_SEQUENCER_STEPS; i++)
             {
-                // Get a pointer to the Voltage Sequencer
-                VoltageSequencer *sequencer = *sequencer_ptr_ptr;
+                value = sequencer->getValue(i);
 
-                //
-                // Display the pattern
-                //
-                for (unsigned int i = 0; i < MAX_SEQUENCER_STEPS; i++)
+                // Draw grey background bar
+                if (i < sequencer->getLength())
                 {
-                    value = sequencer->getValue(i);
-
-                    // Draw grey background bar
-                    if (i < sequencer->getLength())
-                    {
-                        bar_color = brightness(bright_background_color, settings::rackBrightness);
-                    }
-                    else
-                    {
-                        bar_color = brightness(dark_background_color, settings::rackBrightness);
-                    }
-
-                    drawBar(vg, i, BAR_HEIGHT, DRAW_AREA_HEIGHT, bar_color); // background
-
-                    if (i == sequencer->getPlaybackPosition())
-                    {
-                        bar_color = current_step_highlight_color;
-                    }
-                    else if (i < sequencer->getLength())
-                    {
-                        bar_color = lesser_step_highlight_color;
-                    }
-                    else
-                    {
-                        bar_color = default_step_highlight_color;
-                    }
-
-                    // Draw bars for the sequence values
-                    if (value > 0)
-                        drawBar(vg, i, (value * DRAW_AREA_HEIGHT), DRAW_AREA_HEIGHT, bar_color);
-
-                    // Highlight the sequence playback column
-                    if (i == sequencer->getPlaybackPosition())
-                    {
-                        drawBar(vg, i, DRAW_AREA_HEIGHT, DRAW_AREA_HEIGHT, sequence_position_highlight_color);
-                    }
+                    bar_color = brightness(bright_background_color, settings::rackBrightness);
                 }
-            }
-            else // Draw a demo sequence so that the sequencer looks nice in the library selector
-            {
-                double demo_sequence[16] = {0.0, 0.0, 0.25, 0.75, 0.50, 0.50, 0.25, 0.75, 0.0, 0.0, 0.25, 0.75, 0.0, 0.0, 0.25, .75};
-
-                for (unsigned int i = 0; i < MAX_SEQUENCER_STEPS; i++)
+                else
                 {
-                    float value = demo_sequence[i];
+                    bar_color = brightness(dark_background_color, settings::rackBrightness);
+                }
+
+                drawBar(vg, i, BAR_HEIGHT, DRAW_AREA_HEIGHT, bar_color); // background
 
-                    // Draw blue background bars
-                    drawBar(vg, i, BAR_HEIGHT, DRAW_AREA_HEIGHT, bright_background_color);
+                if (i == sequencer->getPlaybackPosition())
+                {
+                    bar_color = current_step_highlight_color;
+                }
+                else if (i < sequencer->getLength())
+                {
+                    bar_color = lesser_step_highlight_color;
+                }
+                else
+                {
+                    bar_color = default_step_highlight_color;
+                }
 
-                    // Draw bar for value at i
-                    if (value > 0)
-                        drawBar(vg, i, (value * DRAW_AREA_HEIGHT), DRAW_AREA_HEIGHT, lesser_step_highlight_color);
+                // Draw bars for the sequence values
+                if (value > 0)
+                    drawBar(vg, i, (value * DRAW_AREA_HEIGHT), DRAW_AREA_HEIGHT, bar_color);
 
-                    // Highlight active step
-                    if (i == 3)
-                        drawBar(vg, i, DRAW_AREA_HEIGHT, DRAW_AREA_HEIGHT, nvgRGBA(255, 255, 255, 150));
+                // Highlight the sequence playback column
+                if (i == sequencer->getPlaybackPosition())
+                {
+                    drawBar(vg, i, DRAW_AREA_HEIGHT, DRAW_AREA_HEIGHT, sequence_position_highlight_color);
                 }
             }
+        }
+        else // Draw a demo sequence so that the sequencer looks nice in the library selector
+        {
+            double demo_sequence[16] = {0.0, 0.0, 0.25, 0.75, 0.50, 0.50, 0.25, 0.75, 0.0, 0.0, 0.25, 0.75, 0.0, 0.0, 0.25, .75};
 
-            drawVerticalGuildes(vg, DRAW_AREA_HEIGHT, 4);
-            drawOverlay(vg, OVERLAY_WIDTH, DRAW_AREA_HEIGHT);
-            if (draw_horizontal_guide)
-                drawHorizontalGuide(vg);
+            for (unsigned int i = 0; i < MAX_SEQUENCER_STEPS; i++)
+            {
+                float value = demo_sequence[i];
+
+                // Draw blue background bars
+                drawBar(vg, i, BAR_HEIGHT, DRAW_AREA_HEIGHT, bright_background_color);
+
+                // Draw bar for value at i
+                if (value > 0)
+                    drawBar(vg, i, (value * DRAW_AREA_HEIGHT), DRAW_AREA_HEIGHT, lesser_step_highlight_color);
 
-            nvgRestore(vg);
+                // Highlight active step
+                if (i == 3)
+                    drawBar(vg, i, DRAW_AREA_HEIGHT, DRAW_AREA_HEIGHT, nvgRGBA(255, 255, 255, 150));
+            }
         }
+
+        drawVerticalGuildes(vg, DRAW_AREA_HEIGHT, 4);
+        drawOverlay(vg, OVERLAY_WIDTH, DRAW_AREA_HEIGHT);
+        if (draw_horizontal_guide)
+            drawHorizontalGuide(vg);
     }
 
     void drawHorizontalGuide(NVGcontext *vg)
@@ -11,6 +11,7 @@
 
 // #include "ByteBeat/calculator.hpp"
 #include "ByteBeat/defines.h"
+#include "ByteBeat/ByteBeatEquations.hpp"
 #include "ByteBeat/ByteBeat.hpp"
 #include "ByteBeat/ByteBeatWidget.hpp"
 
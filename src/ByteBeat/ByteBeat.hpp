@@ -9,7 +9,8 @@
 //   new knob, input, or output, you'll need to make updates in this document
 //   as well as in ByteBeatWidget.hpp
 // - The main "process" loop, whic reads all the inputs and outputs audio
-// - A "compute" function which contains all of the bytebeat equations
+// - A call to the "compute" function in ByteBeatEquations.hpp, which contains
+//   all of the bytebeat equations
 // - A number of "expression" functions which provide more variance for the
 //   equations.
 // - A few helper functions
@@ -20,7 +21,7 @@
 
 struct ByteBeat : Module
 {
-  uint8_t w = 0;     // w is the output of the equations
+  ByteBeatEquations equations;
   float output = 0;  // output is the audio output
   uint32_t t;  // t is the time counter used in the equations
 
@@ -185,98 +186,10 @@ struct ByteBeat : Module
     // function.  The output of the "compute" function will be a float representing
     // the audio generated by one of the bytebeat equations.
     // Output ranges from -5 to +5
-    outputs[AUDIO_OUTPUT].setVoltage((compute(equation, t, p1, p2, p3) * 10.0) - 5.0);
+    outputs[AUDIO_OUTPUT].setVoltage((equations.compute(equation, t, p1, p2, p3) * 10.0) - 5.0);
 
     // outputs[DEBUG_OUTPUT].setVoltage(e1); // << for difficult debugging
 
 
   }
-
-  //
-  // compute(...)
-  //
-  // This equation takes in an equation number and a bunch of parameters and outputs
-  // audio in the form of a floating point number.
-  //
-  // * The equation number is used  in a switch statement for deciding which equation to evaluate.
-  // * Parameters p1, p2, and p3 are used as variables in the equation.  P1, p3, and p3 have
-  //   both a knob and CV input on the front panel to allow the user to jazz up the equation.
-  //
-  // I'm using a rating system while this module is in development.  Equations
-  // are rated from 1 to 10 based on how much I like them.  This'll help me later
-  // to decide which equations should be included in the final release.
-  //
-  // If you want to add a new equation, you'll need to:
-  //  1. Add the equation in the switch statement in the compute function below
-  //  2. Increment the constant NUMBER_OF_EQUATIONS in defines.h
-  //
-  // Why is "w" defined as a class variable instead of inside of this function?
-  // It's because you may want to use the previous value for "w" when calcuating the next "w".  :-)
-  //
-
-  float compute(uint32_t equation_number, uint32_t t, uint32_t p1, uint32_t p2, uint32_t p3)
-  {
-    switch(equation_number) {
-
-      case 0: // Exploratorium
-        w = ((mod(t,(p1+(mod(t,p2)))))^(t>>(p3>>5)))*2;
-        break;
-
-      case 1: // Toner
-        w = ((t>>( mod((t>>12), (p3>>4)) ))+( mod((p1|t),p2)))<<2;
-        break;
-
-      case 2: // widerange
-        w = (((p1^(t>>(p2>>3)))-(t>>(p3>>2))-mod(t,(t&p2))));
-        break;
-
-      case 3: // Landing gear
-        w = (((p1&t)^mod((t>>2), p2))&(w+1393+p3));
-        break;
-
-      case 4: // rampcode (https://github.com/gabochi/rampcode/blob/master/tutorial)
-        w = div((t*((t>>10&p1)+1)),((-t>>12&p2)+1))<<((t*p3>>(t>>14&3)&7)|3);
-        break;
-
-      case 5:
-        w = t << (t>> (0xb1a7529>>(t>>p1&7)*4&15) &7) & t>>(p3>>(t>>p2&3)*4&15);
-        break;
-
-      case 6: // Silent treatment
-        w = (t-t+t*p1)|(t&(p3+1))|div(t,p2);
-        break;
-
-      case 7: // BitWiz Transplant
-        w = (t-((t&p1)*p2-1668899)*(mod((t>>15),15)*t))>>( mod(t>>12,16))>>(p3%15);
-        break;
-
-      // Add next equation here.  Don't forget to increment NUMBER_OF_EQUATIONS in defines.h
-      case 8: // Decoherence
-        // w = ( (t>>6) & (t<<3) / (t*(t>>11)%(3+((t>>16)%22)))    );
-        w = ((t>>6) & div((t<<3),mod( (t*(t>>p1)),(p3+ mod((t>>16),p3) ))));
-        break;
-    }
-
-    // w is a 8-bit unsigned integer that ranges from 0 to 256. But
-    // this funtion is supposed to return a float between 0 and 1, so we divide
-    // w by 256.0.
-    return(w / 256.0);
-  }
-
-  //
-  // These are safe versions of / and %  that avoid division by 0 which crash VCV Rack
-  //
-
-  uint32_t div(uint32_t a, uint32_t b)
-  {
-    if(b == 0) return(0);
-    return(a / b);
-  }
-
-  uint32_t mod(uint32_t a, uint32_t b)
-  {
-    if(b == 0) return(0);
-    return(a % b);
-  }
-
 };
@@ -0,0 +1,51 @@
+/*
+  BreakbeatLoadRequest.hpp
+
+  Loads a Sample for Autobreak or Autobreak Studio on the SampleLoader's
+  worker threads (see SampleLoader.hpp), along with everything those modules
+  work out from it in advance:
+
+  - The TimeStretchAnalysis used to fit the loop to the tempo (see
+    TimeStretch.hpp).
+
+  - The SliceMap of the loop's drum hits (see SliceMap.hpp).  It's read from
+    the file saved next to the sample when there is one, and otherwise
+    detected and saved there for next time.
+*/
+
+#pragma once
+
+#include "TimeStretch.hpp"
+#include "SliceMap.hpp"
+
+struct BreakbeatLoadRequest : LoadRequest
+{
+  Sample sample;
+  TimeStretchAnalysis analysis;
+  SliceMap slice_map;
+
+  BreakbeatLoadRequest(std::string path) : LoadRequest(path)
+  {
+  }
+
+  bool decode() override
+  {
+    if(path == "") return(true);
+    if(! sample.load(path)) return(false);
+
+    analysis.build(sample.size(), [this](unsigned int index, float *left, float *right) {
+      sample.read(index, left, right);
+    });
+
+    if(! slice_map.load(path, sample.size()))
+    {
+      slice_map.detect(sample.size(), sample.sample_rate, [this](unsigned int index, float *left, float *right) {
+        sample.read(index, left, right);
+      });
+
+      slice_map.save(path, sample.size());
+    }
+
+    return(true);
+  }
+};
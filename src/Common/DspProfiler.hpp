@@ -0,0 +1,248 @@
+/*
+  DspProfiler.hpp
+
+  Lightweight instrumentation for finding out where a module's audio time
+  goes.  A module owns a DspProfiler, registers a few named stages with it,
+  and wraps each stage of its process() code in a DspProfileScope:
+
+    DspProfileScope scope(profiler, STAGE_FILTER);
+    filter.process(&left, &right);
+
+  Profiling is switched on and off at runtime (see DspProfilerMenu.hpp).  When
+  it's off, a scope costs a single relaxed atomic load and a branch.  When it's
+  on, a scope reads the CPU's cycle counter twice and adds the difference to
+  its stage's running totals and histogram.
+
+  Timings are kept in cycles (rdtsc) on x86.  Elsewhere, they're kept in
+  nanoseconds from std::chrono::steady_clock.  Either way, the numbers are
+  mostly useful for comparing stages with each other.
+
+  Each stage is only ever written to by the thread running the module's
+  process() method, so updates are plain relaxed loads and stores rather than
+  locked read-modify-write operations.  The UI thread reads the same atomics
+  to build a report.  A report may mix numbers from two neighbouring frames,
+  which doesn't matter for averages over thousands of calls.  Resets are
+  requested by the UI thread and carried out by the audio thread in poll().
+*/
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#if defined ARCH_X64
+  #if defined _MSC_VER
+    #include <intrin.h>
+  #else
+    #include <x86intrin.h>
+  #endif
+#endif
+
+struct DspProfilerStage
+{
+  // Bucket i counts the calls which took between 2^i and 2^(i+1) ticks
+  static const unsigned int HISTOGRAM_BUCKETS = 32;
+
+  std::string name;
+  std::atomic<uint64_t> total_ticks {0};
+  std::atomic<uint64_t> calls {0};
+  std::atomic<uint32_t> histogram[HISTOGRAM_BUCKETS];
+
+  DspProfilerStage()
+  {
+    clear();
+  }
+
+  void clear()
+  {
+    total_ticks.store(0, std::memory_order_relaxed);
+    calls.store(0, std::memory_order_relaxed);
+    for(unsigned int i = 0; i < HISTOGRAM_BUCKETS; i++) histogram[i].store(0, std::memory_order_relaxed);
+  }
+
+  static unsigned int bucket(uint64_t ticks)
+  {
+    unsigned int index = 0;
+    while((ticks >>= 1) && index < (HISTOGRAM_BUCKETS - 1)) index++;
+    return(index);
+  }
+
+  // Called from the audio thread only
+  void record(uint64_t ticks)
+  {
+    total_ticks.store(total_ticks.load(std::memory_order_relaxed) + ticks, std::memory_order_relaxed);
+    calls.store(calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    std::atomic<uint32_t> &count = histogram[bucket(ticks)];
+    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  }
+
+  double averageTicks() const
+  {
+    uint64_t number_of_calls = calls.load(std::memory_order_relaxed);
+    if(number_of_calls == 0) return(0);
+    return((double) total_ticks.load(std::memory_order_relaxed) / number_of_calls);
+  }
+
+  // Returns the upper bound of the histogram bucket containing the given
+  // percentile (0 to 1), which is accurate to within a factor of two.
+  uint64_t percentileTicks(double percentile) const
+  {
+    uint64_t number_of_calls = 0;
+    for(unsigned int i = 0; i < HISTOGRAM_BUCKETS; i++) number_of_calls += histogram[i].load(std::memory_order_relaxed);
+    if(number_of_calls == 0) return(0);
+
+    uint64_t target = (uint64_t) (percentile * number_of_calls);
+    uint64_t running_total = 0;
+
+    for(unsigned int i = 0; i < HISTOGRAM_BUCKETS; i++)
+    {
+      running_total += histogram[i].load(std::memory_order_relaxed);
+      if(running_total > target) return((uint64_t) 1 << (i + 1));
+    }
+
+    return((uint64_t) 1 << HISTOGRAM_BUCKETS);
+  }
+};
+
+struct DspProfiler
+{
+  static const unsigned int MAX_STAGES = 16;
+
+  DspProfilerStage stages[MAX_STAGES];
+  unsigned int number_of_stages = 0;
+
+  std::atomic<bool> enabled {false};
+  std::atomic<bool> reset_requested {false};
+
+  // Stages are registered once, before processing starts.  The first stage
+  // is treated as the total that the other stages are compared against.
+  unsigned int addStage(std::string name)
+  {
+    if(number_of_stages == MAX_STAGES) return(MAX_STAGES - 1);
+
+    stages[number_of_stages].name = name;
+    return(number_of_stages++);
+  }
+
+  bool isEnabled() const
+  {
+    return(enabled.load(std::memory_order_relaxed));
+  }
+
+  void setEnabled(bool value)
+  {
+    if(value && ! isEnabled()) reset();
+    enabled.store(value, std::memory_order_relaxed);
+  }
+
+  // Called from any thread
+  void reset()
+  {
+    reset_requested.store(true, std::memory_order_relaxed);
+  }
+
+  // Called from the audio thread, once per process() call
+  void poll()
+  {
+    if(reset_requested.load(std::memory_order_relaxed))
+    {
+      for(unsigned int i = 0; i < number_of_stages; i++) stages[i].clear();
+      reset_requested.store(false, std::memory_order_relaxed);
+    }
+  }
+
+  static inline uint64_t now()
+  {
+#if defined ARCH_X64
+    return(__rdtsc());
+#else
+    return(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+  }
+
+  static const char *unit()
+  {
+#if defined ARCH_X64
+    return("cycles");
+#else
+    return("ns");
+#endif
+  }
+
+  // One line per stage, for menus and for the report file
+  std::string describeStage(unsigned int stage_index) const
+  {
+    const DspProfilerStage &stage = stages[stage_index];
+    double total = stages[0].total_ticks.load(std::memory_order_relaxed);
+    double share = (total > 0) ? (100.0 * stage.total_ticks.load(std::memory_order_relaxed) / total) : 0;
+
+    char line[256];
+    snprintf(line, sizeof(line), "%s: %.0f %s avg, 99%% < %llu, %.1f%%",
+      stage.name.c_str(),
+      stage.averageTicks(),
+      unit(),
+      (unsigned long long) stage.percentileTicks(0.99),
+      share);
+
+    return(line);
+  }
+
+  std::string report() const
+  {
+    std::string text;
+
+    for(unsigned int i = 0; i < number_of_stages; i++)
+    {
+      char calls[64];
+      snprintf(calls, sizeof(calls), " (%llu calls)", (unsigned long long) stages[i].calls.load(std::memory_order_relaxed));
+      text += describeStage(i) + calls + "\n";
+    }
+
+    return(text);
+  }
+
+  bool dump(std::string path) const
+  {
+    FILE *file = std::fopen(path.c_str(), "w");
+    if(! file) return(false);
+
+    std::string text = report();
+    std::fwrite(text.data(), 1, text.size(), file);
+    std::fclose(file);
+
+    return(true);
+  }
+};
+
+//
+// DspProfileScope
+//
+// Times the enclosing block and records it against one stage.  _profiler_ may
+// be NULL, in which case nothing is recorded.
+//
+
+struct DspProfileScope
+{
+  DspProfiler *profiler = NULL;
+  unsigned int stage_index = 0;
+  uint64_t start = 0;
+
+  DspProfileScope(DspProfiler *profiler, unsigned int stage_index)
+  {
+    if(profiler && profiler->isEnabled())
+    {
+      this->profiler = profiler;
+      this->stage_index = stage_index;
+      this->start = DspProfiler::now();
+    }
+  }
+
+  ~DspProfileScope()
+  {
+    if(profiler) profiler->stages[stage_index].record(DspProfiler::now() - start);
+  }
+};
@@ -0,0 +1,108 @@
+/*
+  ExpanderChannel.hpp
+
+  A one-way stream of messages from a module to the expander next to it (or
+  from the expander to the module).
+
+  Rack's own expander messages are a pair of buffers which the engine swaps
+  once per frame.  Only one message can be in flight, so the modules used to
+  hand it back and forth with a message_received flag, and anything sent
+  while the other side hadn't yet read the last message was lost.
+
+  An ExpanderChannel is a lock-free queue (see SpscQueue.hpp) owned by the
+  receiving module.  Several messages can be waiting at once, and they are
+  read in the order they were sent.  Messages must be plain data: they are
+  copied into the queue, and nothing in them may own memory, so that sending
+  and receiving never allocate on the audio thread.  File paths are sent as
+  handles from the PathTable (see PathTable.hpp).  The one exception is a
+  SampleLoader request, which may be sent as a pointer.  The receiver then
+  owns it, and must post it to a LoadSlot or release it, even when it throws
+  the message away.
+
+  Usage:
+
+  1. The receiver calls attach() in its constructor, with the expander on the
+     side where the sender sits.
+
+  2. The sender finds the channel with find(), passing the __receiver's__
+     expander which faces it, after checking the receiver's model.  For
+     example, from the left module:
+
+       channel = Channel::find(rightExpander.module->leftExpander);
+
+  3. The sender calls send(), and the receiver calls receive() (for events,
+     read all of them) or receiveLatest() (for messages which describe the
+     sender's state, where only the newest one matters).
+
+  The engine's buffer swapping isn't used: both of the expander's message
+  pointers point at the same channel, and messageFlipRequested is never set.
+*/
+
+#pragma once
+
+#include <type_traits>
+
+#include "SpscQueue.hpp"
+
+template <typename T, unsigned int CAPACITY>
+struct ExpanderChannel
+{
+  static_assert(std::is_trivially_copyable<T>::value, "ExpanderChannel messages must be plain data");
+
+  SpscQueue<T, CAPACITY> queue;
+
+  //
+  // Receiver
+  //
+
+  void attach(Module::Expander &expander)
+  {
+    expander.producerMessage = this;
+    expander.consumerMessage = this;
+  }
+
+  // Returns true, and fills in _message_, if a message was waiting
+  bool receive(T &message)
+  {
+    return(queue.pop(message));
+  }
+
+  // Reads every waiting message, and fills in _message_ with the newest one
+  bool receiveLatest(T &message)
+  {
+    bool received = false;
+    while(queue.pop(message)) received = true;
+    return(received);
+  }
+
+  // Throws away any waiting messages, such as those left by an expander
+  // which has since been removed
+  void clear()
+  {
+    T message;
+    while(queue.pop(message)) {}
+  }
+
+  //
+  // Sender
+  //
+
+  // Returns the channel attached to _expander_, which belongs to the
+  // receiving module, or NULL if there isn't one
+  static ExpanderChannel *find(Module::Expander &expander)
+  {
+    return((ExpanderChannel *) expander.producerMessage);
+  }
+
+  // Returns false if the channel is full.  The message isn't sent, and the
+  // sender may try again on a later frame.
+  bool send(const T &message)
+  {
+    return(queue.push(message));
+  }
+
+  bool full()
+  {
+    return(queue.size() == CAPACITY);
+  }
+};
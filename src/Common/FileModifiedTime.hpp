@@ -0,0 +1,27 @@
+/*
+  FileModifiedTime.hpp
+
+  The time a file was last modified, in nanoseconds, for caches which need
+  to notice that a file has changed (see SampleCache.hpp and SliceMap.hpp).
+
+  st_mtime only counts whole seconds, so a file which is saved, read, and
+  then saved again within the same second looks unchanged.  Linux and macOS
+  keep the nanoseconds as well, under different names.  Windows doesn't
+  have them, so there it falls back to whole seconds.
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <sys/stat.h>
+
+inline int64_t fileModifiedTime(const struct stat &file_stats)
+{
+#if defined ARCH_WIN
+  return((int64_t) file_stats.st_mtime * 1000000000);
+#elif defined ARCH_MAC
+  return(((int64_t) file_stats.st_mtimespec.tv_sec * 1000000000) + file_stats.st_mtimespec.tv_nsec);
+#else
+  return(((int64_t) file_stats.st_mtim.tv_sec * 1000000000) + file_stats.st_mtim.tv_nsec);
+#endif
+}
@@ -1,9 +1,13 @@
 #pragma once
 
+// Sent by the Grain Engine MK2 Expander once a recording has been saved.
+// _request_ is the SampleLoader's request for the recording, which the
+// WavRecorder submitted on its writer thread.  The receiver owns it, and
+// must post it to a sample player or release it.
 struct GrainEngineExpanderMessage
 {
   unsigned int sample_slot = 0;
-  bool message_received = true;
-  std::string path = "";
-  std::string filename = "";
+  SampleLoadRequest *request = NULL;
 };
+
+typedef ExpanderChannel<GrainEngineExpanderMessage, 16> GrainEngineExpanderChannel;
@@ -0,0 +1,179 @@
+/*
+  InterleavedAudioBuffer.hpp
+
+  Storage for decoded stereo audio.  Frames are stored interleaved
+  (L0 R0 L1 R1 ...) so that the left and right values of a frame, and the
+  frame after it, share a single cache line and can be fetched with one SIMD
+  load.  Mono files are stored as a single channel, which takes half the
+  memory.  The kernels below are for stereo buffers; SampleAudioBuffer reads
+  mono buffers itself.
+
+  The first frame is aligned to 32 bytes, and the audio is surrounded by
+  GUARD_FRAMES frames of silence on each side.  Everything past the last
+  frame is kept at zero, so interpolation kernels can read a few frames
+  beyond either end of the audio without checking bounds first.
+
+  The interpolation kernels use Rack's float_4 type, which maps to SSE on
+  x86 and to NEON on ARM.  Rack plugins are compiled for SSE4.2, so there's
+  no AVX version.  A stereo frame pair is only four floats wide anyway.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+struct InterleavedAudioBuffer
+{
+  static const unsigned int GUARD_FRAMES = 4;
+  static const unsigned int ALIGNMENT = 32;
+
+  float *memory = NULL;   // The allocation itself, which may not be aligned
+  float *frames = NULL;   // The first (aligned) frame, after the leading guard
+  unsigned int length = 0;
+  unsigned int capacity = 0;
+  unsigned int channels = 2;   // 1 or 2.  Set before the buffer is first sized.
+
+  InterleavedAudioBuffer()
+  {
+  }
+
+  InterleavedAudioBuffer(const InterleavedAudioBuffer &other) = delete;
+  InterleavedAudioBuffer& operator=(const InterleavedAudioBuffer &other) = delete;
+
+  ~InterleavedAudioBuffer()
+  {
+    clear();
+  }
+
+  void clear()
+  {
+    std::free(memory);
+    memory = NULL;
+    frames = NULL;
+    length = 0;
+    capacity = 0;
+  }
+
+  unsigned int size() const
+  {
+    return(length);
+  }
+
+  const float *data() const
+  {
+    return(frames);
+  }
+
+  void reserve(unsigned int new_capacity)
+  {
+    if(new_capacity <= capacity) return;
+
+    std::size_t number_of_floats = ((std::size_t) new_capacity + (2 * GUARD_FRAMES)) * channels;
+    float *new_memory = (float *) std::malloc((number_of_floats * sizeof(float)) + ALIGNMENT);
+    if(new_memory == NULL) throw std::bad_alloc();
+
+    float *aligned = (float *) (((uintptr_t) new_memory + ALIGNMENT - 1) & ~((uintptr_t) ALIGNMENT - 1));
+    std::memset(aligned, 0, number_of_floats * sizeof(float));
+
+    float *new_frames = aligned + (GUARD_FRAMES * channels);
+    if(length > 0) std::memcpy(new_frames, frames, (std::size_t) length * channels * sizeof(float));
+
+    std::free(memory);
+    memory = new_memory;
+    frames = new_frames;
+    capacity = new_capacity;
+  }
+
+  // New frames are silent
+  void resize(unsigned int new_length)
+  {
+    reserve(new_length);
+
+    // Frames past the end must stay at zero for the guard to work
+    if(new_length < length)
+    {
+      std::memset(frames + ((std::size_t) new_length * channels), 0, (std::size_t) (length - new_length) * channels * sizeof(float));
+    }
+
+    length = new_length;
+  }
+
+  // Only for stereo buffers, such as recordings
+  void push_back(float left, float right)
+  {
+    if(length == capacity) reserve(std::max(capacity * 2, 4096u));
+
+    frames[length * 2] = left;
+    frames[(length * 2) + 1] = right;
+    length++;
+  }
+
+  // Mono buffers keep _left_ only
+  void set(unsigned int index, float left, float right)
+  {
+    if(channels == 1)
+    {
+      frames[index] = left;
+      return;
+    }
+
+    frames[index * 2] = left;
+    frames[(index * 2) + 1] = right;
+  }
+
+  // Mono buffers return the same value on both sides
+  void read(unsigned int index, float *left_audio_ptr, float *right_audio_ptr) const
+  {
+    if(channels == 1)
+    {
+      *left_audio_ptr = frames[index];
+      *right_audio_ptr = frames[index];
+      return;
+    }
+
+    readFrame(frames + (index * 2), left_audio_ptr, right_audio_ptr);
+  }
+
+  //
+  // Kernels
+  //
+  // These take a pointer to a frame inside of an InterleavedAudioBuffer and
+  // don't check bounds.  The guard frames make it safe to read the frame
+  // after the last one.
+  //
+
+  static inline void readFrame(const float *frame, float *left_audio_ptr, float *right_audio_ptr)
+  {
+    *left_audio_ptr = frame[0];
+    *right_audio_ptr = frame[1];
+  }
+
+  // Linear interpolation between _frame_ and the frame after it
+  static inline void interpolateFrame(const float *frame, float distance, float *left_audio_ptr, float *right_audio_ptr)
+  {
+    simd::float_4 current = simd::float_4::load(frame);                 // L0 R0 L1 R1
+    simd::float_4 next = _mm_movehl_ps(current.v, current.v);           // L1 R1 L1 R1
+    simd::float_4 result = current + ((next - current) * distance);
+
+    *left_audio_ptr = result[0];
+    *right_audio_ptr = result[1];
+  }
+
+  // (frame_a * gain_a) + (frame_b * gain_b), for crossfading two voices.  The
+  // frames may come from different buffers.  Both are fetched into a single
+  // register, so mixing two voices costs little more than reading one.
+  static inline void mixFrames(const float *frame_a, float gain_a, const float *frame_b, float gain_b, float *left_audio_ptr, float *right_audio_ptr)
+  {
+    simd::float_4 frames = _mm_loadl_pi(_mm_setzero_ps(), (const __m64 *) frame_a);   // La Ra 0  0
+    frames = _mm_loadh_pi(frames.v, (const __m64 *) frame_b);                          // La Ra Lb Rb
+    simd::float_4 mixed = frames * simd::float_4(gain_a, gain_a, gain_b, gain_b);
+    mixed = mixed + simd::float_4(_mm_movehl_ps(mixed.v, mixed.v));
+
+    *left_audio_ptr = mixed[0];
+    *right_audio_ptr = mixed[1];
+  }
+};
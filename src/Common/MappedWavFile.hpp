@@ -0,0 +1,340 @@
+/*
+  MappedWavFile.hpp
+
+  AudioFile.h reads an entire .wav file into memory and then decodes every
+  frame into floating point vectors.  For multi-gigabyte field recordings
+  that means a long wait and several copies of the audio in memory.
+
+  A MappedWavFile instead maps the .wav file into the address space of the
+  process and converts frames to floats as they're read.  Opening a file only
+  parses the header, so it's nearly instant, and the operating system pages
+  audio in (and back out) as it's played.  Resident memory tracks the part
+  of the file which is actually being played.
+
+  Supported formats are 16 and 24 bit PCM, 32 bit PCM and 32 bit float.
+  Anything else (compressed formats, 8 bit, 64 bit float, etc.) fails to
+  open, and the caller should fall back to decoding with AudioFile.h.
+
+  The very first read of a page which isn't in memory yet has to go to disk.
+  Files are mapped with a sequential access hint so that the OS reads ahead
+  of the playback position.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#if defined ARCH_WIN
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+// Files smaller than this are decoded into memory as usual
+#define MAPPED_WAV_MIN_FILE_SIZE (32 * 1024 * 1024)
+
+struct MappedWavFile
+{
+  enum Formats
+  {
+    PCM_16,
+    PCM_24,
+    PCM_32,
+    FLOAT_32
+  };
+
+  const uint8_t *file_data = NULL;   // The entire mapped file
+  uint64_t file_size = 0;
+  const uint8_t *audio_data = NULL;  // Points to the first frame of the data chunk
+  unsigned int frames = 0;
+  unsigned int channels = 0;
+  unsigned int bytes_per_sample = 0;
+  unsigned int bytes_per_frame = 0;
+  float sample_rate = 44100.0;
+  int format = PCM_16;
+
+#if defined ARCH_WIN
+  HANDLE file_handle = INVALID_HANDLE_VALUE;
+  HANDLE mapping_handle = NULL;
+#endif
+
+  MappedWavFile()
+  {
+  }
+
+  // The mapping can't be shared between two objects
+  MappedWavFile(const MappedWavFile &other) = delete;
+  MappedWavFile& operator=(const MappedWavFile &other) = delete;
+
+  ~MappedWavFile()
+  {
+    close();
+  }
+
+  bool isOpen() const
+  {
+    return(audio_data != NULL);
+  }
+
+  bool open(std::string path)
+  {
+    close();
+
+    if(! map(path)) return(false);
+
+    if(! parseHeader())
+    {
+      close();
+      return(false);
+    }
+
+    return(true);
+  }
+
+  void close()
+  {
+    unmap();
+
+    file_data = NULL;
+    file_size = 0;
+    audio_data = NULL;
+    frames = 0;
+    channels = 0;
+  }
+
+  // Read stereo audio at frame _index_.  Mono files return the same value on
+  // both sides and files with more than two channels return the first two.
+  // The caller is responsible for checking that _index_ is less than _frames_.
+  void read(unsigned int index, float *left_audio_ptr, float *right_audio_ptr) const
+  {
+    const uint8_t *frame = audio_data + ((uint64_t) index * bytes_per_frame);
+
+    *left_audio_ptr = decode(frame);
+    *right_audio_ptr = (channels > 1) ? decode(frame + bytes_per_sample) : *left_audio_ptr;
+  }
+
+  // .wav files are little endian, as are all platforms that VCV Rack runs on.
+  // memcpy is used because frames aren't guaranteed to be aligned.
+  float decode(const uint8_t *bytes) const
+  {
+    switch(format)
+    {
+      case PCM_16:
+      {
+        int16_t value;
+        std::memcpy(&value, bytes, 2);
+        return(value / 32768.0f);
+      }
+
+      case PCM_24:
+      {
+        int32_t value = (int32_t) (((uint32_t) bytes[0] << 8) | ((uint32_t) bytes[1] << 16) | ((uint32_t) bytes[2] << 24)) >> 8;
+        return(value / 8388608.0f);
+      }
+
+      case PCM_32:
+      {
+        int32_t value;
+        std::memcpy(&value, bytes, 4);
+        return(value / 2147483648.0f);
+      }
+
+      case FLOAT_32:
+      {
+        float value;
+        std::memcpy(&value, bytes, 4);
+        return(value);
+      }
+    }
+
+    return(0);
+  }
+
+  //
+  // Header parsing
+  //
+
+  static uint32_t readUInt32(const uint8_t *bytes)
+  {
+    return((uint32_t) bytes[0] | ((uint32_t) bytes[1] << 8) | ((uint32_t) bytes[2] << 16) | ((uint32_t) bytes[3] << 24));
+  }
+
+  static uint16_t readUInt16(const uint8_t *bytes)
+  {
+    return((uint16_t) (bytes[0] | (bytes[1] << 8)));
+  }
+
+  bool parseHeader()
+  {
+    if(file_size < 12) return(false);
+    if(std::memcmp(file_data, "RIFF", 4) != 0 || std::memcmp(file_data + 8, "WAVE", 4) != 0) return(false);
+
+    bool found_format = false;
+    uint16_t audio_format = 0;
+    uint16_t bits_per_sample = 0;
+    uint16_t block_align = 0;
+
+    uint64_t position = 12;
+
+    // Walk through the chunks looking for "fmt " and "data"
+    while(position + 8 <= file_size)
+    {
+      const uint8_t *chunk = file_data + position;
+      uint64_t chunk_size = readUInt32(chunk + 4);
+      uint64_t chunk_start = position + 8;
+
+      if(std::memcmp(chunk, "fmt ", 4) == 0)
+      {
+        if(chunk_size < 16 || chunk_start + 16 > file_size) return(false);
+
+        const uint8_t *fmt = file_data + chunk_start;
+        audio_format = readUInt16(fmt);
+        channels = readUInt16(fmt + 2);
+        sample_rate = readUInt32(fmt + 4);
+        block_align = readUInt16(fmt + 12);
+        bits_per_sample = readUInt16(fmt + 14);
+
+        // WAVE_FORMAT_EXTENSIBLE stores the real format in the sub-format GUID
+        if(audio_format == 0xFFFE)
+        {
+          if(chunk_size < 26 || chunk_start + 26 > file_size) return(false);
+          audio_format = readUInt16(fmt + 24);
+        }
+
+        found_format = true;
+      }
+      else if(std::memcmp(chunk, "data", 4) == 0)
+      {
+        if(! found_format) return(false);
+        if(! setFormat(audio_format, bits_per_sample, block_align)) return(false);
+
+        // Recordings which were cut short often have a bogus data size
+        uint64_t data_size = std::min(chunk_size, file_size - chunk_start);
+        uint64_t number_of_frames = data_size / bytes_per_frame;
+
+        if(number_of_frames == 0 || number_of_frames > 0xFFFFFFFF) return(false);
+
+        audio_data = file_data + chunk_start;
+        frames = number_of_frames;
+        return(true);
+      }
+
+      // Chunks are padded to an even number of bytes
+      position = chunk_start + chunk_size + (chunk_size & 1);
+    }
+
+    return(false);
+  }
+
+  bool setFormat(uint16_t audio_format, uint16_t bits_per_sample, uint16_t block_align)
+  {
+    if(channels == 0 || sample_rate <= 0) return(false);
+
+    if(audio_format == 1 && bits_per_sample == 16) format = PCM_16;
+    else if(audio_format == 1 && bits_per_sample == 24) format = PCM_24;
+    else if(audio_format == 1 && bits_per_sample == 32) format = PCM_32;
+    else if(audio_format == 3 && bits_per_sample == 32) format = FLOAT_32;
+    else return(false);
+
+    bytes_per_sample = bits_per_sample / 8;
+    bytes_per_frame = bytes_per_sample * channels;
+
+    if(block_align != 0 && block_align != bytes_per_frame) return(false);
+
+    return(true);
+  }
+
+  //
+  // Platform specific mapping
+  //
+
+#if defined ARCH_WIN
+
+  bool map(std::string path)
+  {
+    std::wstring path_w = rack::string::UTF8toUTF16(path);
+
+    file_handle = CreateFileW(path_w.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if(file_handle == INVALID_HANDLE_VALUE) return(false);
+
+    LARGE_INTEGER size;
+    if(! GetFileSizeEx(file_handle, &size) || size.QuadPart == 0)
+    {
+      unmap();
+      return(false);
+    }
+
+    mapping_handle = CreateFileMappingW(file_handle, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(mapping_handle == NULL)
+    {
+      unmap();
+      return(false);
+    }
+
+    file_data = (const uint8_t *) MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+    if(file_data == NULL)
+    {
+      unmap();
+      return(false);
+    }
+
+    file_size = size.QuadPart;
+    return(true);
+  }
+
+  void unmap()
+  {
+    if(file_data) UnmapViewOfFile(file_data);
+    if(mapping_handle) CloseHandle(mapping_handle);
+    if(file_handle != INVALID_HANDLE_VALUE) CloseHandle(file_handle);
+
+    file_data = NULL;
+    mapping_handle = NULL;
+    file_handle = INVALID_HANDLE_VALUE;
+  }
+
+#else
+
+  bool map(std::string path)
+  {
+    int file_descriptor = ::open(path.c_str(), O_RDONLY);
+    if(file_descriptor < 0) return(false);
+
+    struct stat file_stats;
+    if(fstat(file_descriptor, &file_stats) != 0 || file_stats.st_size == 0)
+    {
+      ::close(file_descriptor);
+      return(false);
+    }
+
+    void *mapping = mmap(NULL, file_stats.st_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+
+    // The mapping keeps its own reference to the file
+    ::close(file_descriptor);
+
+    if(mapping == MAP_FAILED) return(false);
+
+    posix_madvise(mapping, file_stats.st_size, POSIX_MADV_SEQUENTIAL);
+
+    file_data = (const uint8_t *) mapping;
+    file_size = file_stats.st_size;
+    return(true);
+  }
+
+  void unmap()
+  {
+    if(file_data) munmap((void *) file_data, file_size);
+    file_data = NULL;
+  }
+
+#endif
+};
@@ -0,0 +1,43 @@
+/*
+  OverviewLoadRequest.hpp
+
+  Fetches the SampleOverview of a sample which is already loaded, for a
+  waveform display (see WaveformWidget.hpp), on the SampleLoader's worker
+  threads.
+
+  The overview is built the first time that any display asks for it (see
+  SampleAudioData::getOverview()), which means reading every frame of the
+  sample.  For a large memory mapped file that's a long read from disk, so
+  it's never done on the GUI thread.  Once built, it's shared by every
+  display showing the same file.
+
+  The display holds on to the overview through a shared pointer, so it stays
+  valid even after the module has swapped in another sample and the audio
+  it summarizes has been freed.
+*/
+
+#pragma once
+
+#include "SampleCache.hpp"
+
+struct OverviewLoadRequest : LoadRequest
+{
+  std::shared_ptr<const SampleOverview> overview;
+
+  OverviewLoadRequest(std::string path) : LoadRequest(path)
+  {
+  }
+
+  // Only looks in the SampleCache, as the module has already loaded the
+  // file.  If it has been unloaded since, there's nothing to display.
+  bool decode() override
+  {
+    if(path == "") return(true);
+
+    std::shared_ptr<const SampleAudioData> data = SampleCache::instance().find(path);
+    if(! data) return(false);
+
+    overview = data->getOverview();
+    return(true);
+  }
+};
@@ -0,0 +1,146 @@
+/*
+  PathTable.hpp
+
+  Turns file paths into small numbers (handles) which can be passed around
+  the audio thread as freely as any other number.
+
+  Messages between modules, such as the one the Grain Engine MK2 Expander
+  sends when a recording has been saved, used to carry the path as a string.
+  Copying or comparing those strings on the audio thread can allocate memory.
+  Instead, the path is interned once, on a background thread, and only the
+  handle is sent.  The receiving module looks the path up again with get().
+
+  Samples are published the same way.  The SampleLoader interns the path of
+  each file it loads on its worker thread (see SampleLoader.hpp), and the
+  module only stores the handle when it swaps the sample in, so the GUI can
+  show the file name without process() ever copying a string.
+
+  There is a single table shared by every module (see shared()).  Paths are
+  never removed, so a handle stays valid for as long as the plugin is
+  loaded, even if the module which interned it is deleted.  Interning the
+  same path twice returns the same handle, so the table only grows with the
+  number of different paths.  Paths are stored in chunks which are allocated
+  as the table grows and never move, so that get() can return a pointer
+  into the table while intern() adds to it.
+
+  intern() locks a mutex and may allocate, so it must not be called from the
+  audio thread.  get() is lock-free and may be called from any thread.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+struct PathTable
+{
+  static const unsigned int CHUNK_SIZE = 256;
+  static const unsigned int NUMBER_OF_CHUNKS = 256;
+  static const unsigned int CAPACITY = CHUNK_SIZE * NUMBER_OF_CHUNKS;
+  static const unsigned int NONE = 0xFFFFFFFF;
+
+  std::atomic<std::string *> chunks[NUMBER_OF_CHUNKS];
+  std::atomic<unsigned int> count {0};
+  std::unordered_map<std::string, unsigned int> handles;  // Only touched with the mutex locked
+  std::mutex mutex;
+
+  PathTable()
+  {
+    for(unsigned int i = 0; i < NUMBER_OF_CHUNKS; i++) chunks[i].store(NULL, std::memory_order_relaxed);
+  }
+
+  ~PathTable()
+  {
+    for(unsigned int i = 0; i < NUMBER_OF_CHUNKS; i++) delete [] chunks[i].load(std::memory_order_relaxed);
+  }
+
+  static PathTable &shared()
+  {
+    static PathTable table;
+    return(table);
+  }
+
+  // Returns the handle for _path_, or NONE if the table is full
+  unsigned int intern(const std::string &path)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::unordered_map<std::string, unsigned int>::const_iterator existing = handles.find(path);
+    if(existing != handles.end()) return(existing->second);
+
+    unsigned int number_of_paths = count.load(std::memory_order_relaxed);
+    if(number_of_paths == CAPACITY) return(NONE);
+
+    std::string *chunk = chunks[number_of_paths / CHUNK_SIZE].load(std::memory_order_relaxed);
+
+    if(chunk == NULL)
+    {
+      chunk = new std::string[CHUNK_SIZE];
+      chunks[number_of_paths / CHUNK_SIZE].store(chunk, std::memory_order_relaxed);
+    }
+
+    // The path is written before the count is increased, so readers never
+    // see a handle before its path (and its chunk) is complete
+    chunk[number_of_paths % CHUNK_SIZE] = path;
+    handles[path] = number_of_paths;
+    count.store(number_of_paths + 1, std::memory_order_release);
+
+    return(number_of_paths);
+  }
+
+  // Returns the path for _handle_, or NULL if the handle isn't valid
+  const std::string *get(unsigned int handle)
+  {
+    if(handle >= count.load(std::memory_order_acquire)) return(NULL);
+    return(&chunks[handle / CHUNK_SIZE].load(std::memory_order_relaxed)[handle % CHUNK_SIZE]);
+  }
+};
+
+//
+// PathHandle
+//
+// A handle which one thread sets while others read it, such as the path of
+// the sample a module is playing.  Copies take the current value, so that
+// structs holding one can still be stored in std::vectors.
+//
+
+struct PathHandle
+{
+  std::atomic<unsigned int> handle {PathTable::NONE};
+
+  PathHandle()
+  {
+  }
+
+  PathHandle(const PathHandle &other)
+  {
+    handle.store(other.load(), std::memory_order_relaxed);
+  }
+
+  PathHandle &operator=(const PathHandle &other)
+  {
+    store(other.load());
+    return(*this);
+  }
+
+  // Doesn't allocate, so it's safe on the audio thread
+  void store(unsigned int value)
+  {
+    handle.store(value, std::memory_order_release);
+  }
+
+  unsigned int load() const
+  {
+    return(handle.load(std::memory_order_acquire));
+  }
+
+  // Returns a copy of the path, or "" if there isn't one.  Copying the string
+  // allocates, so this is for the GUI and for saving patches.
+  std::string path() const
+  {
+    const std::string *path = PathTable::shared().get(load());
+    return((path == NULL) ? std::string("") : *path);
+  }
+};
@@ -0,0 +1,459 @@
+/*
+  SampleBankResidency.hpp
+
+  Keeps track of which slots of a sample bank (WavBank, WavBankMC) are
+  loaded, or on their way to being loaded.
+
+  By default, every file in the bank's folder is requested as soon as the
+  folder is chosen.  The files are decoded in parallel by the SampleLoader,
+  and each slot can be played as soon as its own file is ready.
+
+  With load_on_demand turned on, only the selected slot and its neighbours
+  are requested.  The others are requested when the WAV selector reaches
+  them.  Once more than resident_limit slots are loaded, the least recently
+  selected slots are unloaded again.  This makes very large banks practical,
+  as the whole folder never has to sit in memory.
+
+  Each module keeps the samples of one folder in a SampleBank, which knows
+  how to load and unload its slots.  update() decides what needs to happen
+  and calls back into the bank for each slot.  Requesting a file allocates
+  memory, so this is never done on the audio thread, and it can't be left to
+  the module widget either, as there isn't one when Rack runs headless.
+  Instead, the SampleBankWorker thread (see below) keeps every bank up to
+  date with the slot that its module's process() last selected.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct SampleBankResidency
+{
+  std::vector<std::string> paths;
+  std::vector<std::string> display_names;
+  std::unique_ptr<std::atomic<bool>[]> resident;   // Requested, and not unloaded since.  Read by the GUI.
+  std::vector<unsigned int> last_used;    // Value of use_counter when last selected
+  unsigned int use_counter = 0;
+
+  // update() only has work to do when the selection or settings change
+  unsigned int updated_slot = 0;
+  bool stale = true;
+
+  bool load_on_demand = false;
+  unsigned int resident_limit = 32;
+
+  // Slots on either side of the selected slot to load ahead of time, so that
+  // stepping through the bank doesn't have to wait for the loader
+  unsigned int neighbours = 1;
+
+  // Starts a new bank.  Nothing is requested until update() is called.
+  void assign(const std::vector<std::string> &new_paths)
+  {
+    paths = new_paths;
+    display_names.clear();
+
+    for(const std::string &path : paths)
+    {
+      std::string display_name = system::getFilename(path);
+      display_name.erase(display_name.length() - 4); // remove the .wav extension
+      display_names.push_back(display_name);
+    }
+
+    resident.reset(new std::atomic<bool>[paths.size()]);
+    for(unsigned int slot = 0; slot < paths.size(); slot++) resident[slot].store(false);
+
+    last_used.assign(paths.size(), 0);
+    use_counter = 0;
+    stale = true;
+  }
+
+  // Call after changing load_on_demand or resident_limit
+  void invalidate()
+  {
+    stale = true;
+  }
+
+  unsigned int size()
+  {
+    return(paths.size());
+  }
+
+  bool isResident(unsigned int slot)
+  {
+    return(slot < paths.size() && resident[slot].load(std::memory_order_relaxed));
+  }
+
+  //
+  // load(slot, urgent) is called for each slot that should be requested, and
+  // unload(slot) for each slot that should be freed.  The selected slot is
+  // requested with urgent set to true.  Returns false if there was nothing
+  // to do.
+  //
+  template <typename LoadFunction, typename UnloadFunction>
+  bool update(unsigned int selected_slot, LoadFunction load, UnloadFunction unload)
+  {
+    unsigned int number_of_slots = paths.size();
+    if(number_of_slots == 0) return(false);
+
+    if(selected_slot >= number_of_slots) selected_slot = number_of_slots - 1;
+
+    if(! stale && selected_slot == updated_slot) return(false);
+
+    stale = false;
+    updated_slot = selected_slot;
+
+    if(! load_on_demand)
+    {
+      if(! resident[selected_slot]) request(selected_slot, true, load);
+
+      for(unsigned int slot = 0; slot < number_of_slots; slot++)
+      {
+        if(! resident[slot]) request(slot, false, load);
+      }
+
+      return(true);
+    }
+
+    // Touch the neighbours first, so that the selected slot is the most
+    // recently used
+    unsigned int reach = std::min(neighbours, (number_of_slots - 1) / 2);
+
+    for(unsigned int distance = reach; distance > 0; distance--)
+    {
+      touch((selected_slot + distance) % number_of_slots, false, load);
+      touch((selected_slot + number_of_slots - distance) % number_of_slots, false, load);
+    }
+
+    touch(selected_slot, true, load);
+
+    evict(std::max(resident_limit, (reach * 2) + 1), unload);
+
+    return(true);
+  }
+
+  template <typename LoadFunction>
+  void touch(unsigned int slot, bool urgent, LoadFunction load)
+  {
+    if(! resident[slot]) request(slot, urgent, load);
+    last_used[slot] = ++use_counter;
+  }
+
+  template <typename LoadFunction>
+  void request(unsigned int slot, bool urgent, LoadFunction load)
+  {
+    load(slot, urgent);
+    resident[slot] = true;
+  }
+
+  // Unloads the least recently used slots until no more than _limit_ remain
+  template <typename UnloadFunction>
+  void evict(unsigned int limit, UnloadFunction unload)
+  {
+    unsigned int number_of_resident_slots = 0;
+    for(unsigned int slot = 0; slot < paths.size(); slot++) if(resident[slot]) number_of_resident_slots++;
+
+    while(number_of_resident_slots > limit)
+    {
+      unsigned int oldest_slot = 0;
+      bool found = false;
+
+      for(unsigned int slot = 0; slot < paths.size(); slot++)
+      {
+        if(resident[slot] && (! found || last_used[slot] < last_used[oldest_slot]))
+        {
+          oldest_slot = slot;
+          found = true;
+        }
+      }
+
+      unload(oldest_slot);
+      resident[oldest_slot] = false;
+      number_of_resident_slots--;
+    }
+  }
+};
+
+//
+// SampleBank
+//
+// The samples of one folder.  Each module derives its own, holding whatever
+// it plays the samples from, and the SampleBankWorker calls load(), unload()
+// and prioritize() on it.  Once the module's process() has the bank, only
+// the samples themselves change, so the GUI can keep a reference to the same
+// bank for showing the file names.
+//
+
+struct SampleBank
+{
+  SampleBankResidency residency;
+
+  SampleBank(const std::vector<std::string> &paths)
+  {
+    residency.assign(paths);
+  }
+
+  virtual ~SampleBank()
+  {
+  }
+
+  unsigned int size()
+  {
+    return(residency.size());
+  }
+
+  // Requests the sample for _slot_, or the loader's next free slot if
+  // _urgent_ is set
+  virtual void load(unsigned int slot, bool urgent) = 0;
+
+  // Requests that the sample in _slot_ be freed
+  virtual void unload(unsigned int slot) = 0;
+
+  // Asks the loader to load _slot_ next, if it's still waiting
+  virtual void prioritize(unsigned int slot) = 0;
+
+  // Called after SampleBankHost::reload(), so that a setting which changes
+  // how the samples are loaded takes effect
+  virtual void reload()
+  {
+  }
+};
+
+//
+// SampleBankHost
+//
+// What a module shares with the SampleBankWorker.  The module owns it, and
+// the worker only holds a weak reference, so it's dropped from the worker's
+// list once the module is removed.
+//
+// New banks are built off the audio thread and passed to process() through
+// _incoming_.  process() swaps the bank in and passes the old one back
+// through _outgoing_, for the worker to free.  Each is a shared pointer
+// allocated by the worker, so that passing a bank over is a single atomic
+// exchange, and process() never frees memory.
+//
+
+struct SampleBankHost
+{
+  // Written by process() through select(), read by the worker.  Only the
+  // latest selection matters, so it's a single value rather than a queue.
+  std::atomic<unsigned int> selected_slot {0};
+
+  // Written by the GUI thread (or dataFromJson) through configure()
+  std::atomic<bool> load_on_demand {false};
+  std::atomic<unsigned int> resident_limit {32};
+  std::atomic<unsigned int> revision {0};
+
+  std::atomic<std::shared_ptr<SampleBank> *> incoming {NULL};
+  std::atomic<std::shared_ptr<SampleBank> *> outgoing {NULL};
+
+  // Only used by the SampleBankWorker.  assigned_bank is guarded by its
+  // mutex.
+  std::shared_ptr<SampleBank> assigned_bank;
+  std::shared_ptr<SampleBank> serviced_bank;
+  unsigned int serviced_revision = 0;
+
+  ~SampleBankHost()
+  {
+    delete incoming.load();
+    delete outgoing.load();
+  }
+
+  void configure(bool new_load_on_demand, unsigned int new_resident_limit)
+  {
+    load_on_demand.store(new_load_on_demand);
+    resident_limit.store(new_resident_limit);
+    revision++;
+  }
+
+  // Has the worker call the bank's reload()
+  void reload()
+  {
+    revision++;
+  }
+
+  // Called from process() with the selected slot
+  void select(unsigned int slot);
+
+  // Called from process().  Swaps a newly built bank into _bank_, if there is
+  // one, and returns true.  The old bank is passed back to the worker.
+  bool accept(std::shared_ptr<SampleBank> &bank)
+  {
+    // Wait until the worker has collected the last one
+    if(outgoing.load(std::memory_order_acquire) != NULL) return(false);
+
+    std::shared_ptr<SampleBank> *new_bank = incoming.exchange(NULL, std::memory_order_acq_rel);
+    if(new_bank == NULL) return(false);
+
+    bank.swap(*new_bank);
+    outgoing.store(new_bank, std::memory_order_release);
+
+    return(true);
+  }
+};
+
+//
+// SampleBankWorker
+//
+// One thread services the banks of every WavBank and WavBankMC.  Like the
+// SampleStreamer, it polls rather than being signalled by the audio thread.
+// A few milliseconds is quick enough to follow the WAV selector, as the
+// selected sample has to be decoded after that anyway.
+//
+
+struct SampleBankWorker
+{
+  std::vector<std::weak_ptr<SampleBankHost>> hosts;
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::thread worker;
+  bool running = false;
+
+  static SampleBankWorker &instance()
+  {
+    static SampleBankWorker sample_bank_worker;
+    return(sample_bank_worker);
+  }
+
+  ~SampleBankWorker()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if(! running) return;
+      running = false;
+    }
+
+    condition.notify_one();
+    worker.join();
+  }
+
+  // Hands a newly built bank to _host_.  Called from the GUI thread (or
+  // dataFromJson).
+  void assign(std::shared_ptr<SampleBankHost> host, std::shared_ptr<SampleBank> bank)
+  {
+#ifdef VOXGLITCH_OFFLINE_RENDER
+    // The offline renderer has no worker thread.  See SampleBankHost::select().
+    service(host.get(), bank);
+    return;
+#endif
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if(! running)
+    {
+      running = true;
+      worker = std::thread(&SampleBankWorker::run, this);
+    }
+
+    bool found = false;
+    for(std::weak_ptr<SampleBankHost> &registered_host : hosts)
+    {
+      if(registered_host.lock() == host) found = true;
+    }
+
+    if(! found) hosts.push_back(host);
+
+    host->assigned_bank = bank;
+  }
+
+  void run()
+  {
+    std::vector<std::shared_ptr<SampleBankHost>> active_hosts;
+    std::vector<std::shared_ptr<SampleBank>> assigned_banks;
+
+    while(true)
+    {
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        condition.wait_for(lock, std::chrono::milliseconds(5), [this] { return(! running); });
+
+        if(! running) return;
+
+        active_hosts.clear();
+        assigned_banks.clear();
+
+        for(auto it = hosts.begin(); it != hosts.end();)
+        {
+          std::shared_ptr<SampleBankHost> host = it->lock();
+
+          if(host)
+          {
+            active_hosts.push_back(host);
+            assigned_banks.push_back(std::move(host->assigned_bank));
+            it++;
+          }
+          else
+          {
+            it = hosts.erase(it);
+          }
+        }
+      }
+
+      for(unsigned int i = 0; i < active_hosts.size(); i++)
+      {
+        service(active_hosts[i].get(), assigned_banks[i]);
+      }
+
+      // Let go of the hosts here, so that a module's bank is never freed
+      // while the mutex is held
+      active_hosts.clear();
+      assigned_banks.clear();
+    }
+  }
+
+  void service(SampleBankHost *host, std::shared_ptr<SampleBank> new_bank)
+  {
+    if(new_bank)
+    {
+      // A bank which process() never picked up is replaced
+      delete host->incoming.exchange(new std::shared_ptr<SampleBank>(new_bank), std::memory_order_acq_rel);
+      host->serviced_bank = new_bank;
+    }
+
+    delete host->outgoing.exchange(NULL, std::memory_order_acq_rel);
+
+    SampleBank *bank = host->serviced_bank.get();
+    if(bank == NULL) return;
+
+    unsigned int revision = host->revision.load();
+
+    if(new_bank || revision != host->serviced_revision)
+    {
+      bank->residency.load_on_demand = host->load_on_demand.load();
+      bank->residency.resident_limit = host->resident_limit.load();
+      bank->residency.invalidate();
+      if(! new_bank) bank->reload();
+      host->serviced_revision = revision;
+    }
+
+    unsigned int selected_slot = std::min(host->selected_slot.load(std::memory_order_relaxed), bank->size() - 1);
+
+    bool updated = bank->residency.update(selected_slot,
+      [bank](unsigned int slot, bool urgent) { bank->load(slot, urgent); },
+      [bank](unsigned int slot) { bank->unload(slot); });
+
+    // If the selected sample is still waiting behind others, load it next
+    if(updated) bank->prioritize(selected_slot);
+  }
+};
+
+inline void SampleBankHost::select(unsigned int slot)
+{
+  selected_slot.store(slot, std::memory_order_relaxed);
+
+#ifdef VOXGLITCH_OFFLINE_RENDER
+  // Offline renders have to come out the same every time, which they can't if
+  // the samples are requested a few frames sooner or later depending on the
+  // worker thread.  Instead, the bank is serviced here, and the SampleLoader
+  // loads each sample as soon as it's requested (see SampleLoader.hpp).
+  SampleBankWorker::instance().service(this, NULL);
+#endif
+}
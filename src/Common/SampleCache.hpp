@@ -0,0 +1,286 @@
+/*
+  SampleCache.hpp
+
+  Many patches load the same .wav file into several modules, for example a
+  drum loop used by both Groovebox and SamplerX8.  Before the SampleCache,
+  each Sample decoded and stored its own copy of the audio.
+
+  The SampleCache is shared by every module in the plugin.  It decodes a file
+  once and hands out the decoded audio as a reference counted, read-only
+  SampleAudioData object.  Files are identified by their canonical path, and
+  the file's modification time and size are used to detect when a file has
+  been changed on disk, in which case it's decoded again.
+
+  The cache only holds weak references.  Once the last Sample using a file
+  lets go of it, the memory is freed and the cache entry expires.
+
+  Large files can be memory mapped instead of decoded (see MappedWavFile.hpp)
+  when the caller allows it.  Mapped audio is shared in exactly the same way,
+  but only with other callers which allow mapping.  The rest jump around in
+  the audio from process(), where reading a mapped file could wait on the
+  disk, so they get their own decoded copy.
+
+  A SampleOverview of the audio, for waveform displays, is built the first
+  time it's asked for, and shared along with it.
+*/
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sys/stat.h>
+#include "FileModifiedTime.hpp"
+#include "InterleavedAudioBuffer.hpp"
+#include "MappedWavFile.hpp"
+#include "SampleOverview.hpp"
+
+struct SampleAudioData
+{
+  InterleavedAudioBuffer audio;
+  MappedWavFile mapped_file;         // used instead of _audio_ when the file is memory mapped
+  float sample_rate = 44100.0;
+  unsigned int channels = 0;
+
+  // Built by getOverview()
+  mutable std::shared_ptr<const SampleOverview> overview;
+  mutable std::mutex overview_mutex;
+
+  unsigned int size() const
+  {
+    if(mapped_file.isOpen()) return(mapped_file.frames);
+    return(audio.size());
+  }
+
+  const MappedWavFile *mapped() const
+  {
+    return(mapped_file.isOpen() ? &mapped_file : NULL);
+  }
+
+  // Returns the overview, building it the first time it's asked for.  That
+  // reads every frame, which for a memory mapped file means reading it from
+  // disk, so this is only called on the SampleLoader's worker threads (see
+  // OverviewLoadRequest.hpp).
+  std::shared_ptr<const SampleOverview> getOverview() const
+  {
+    std::lock_guard<std::mutex> lock(overview_mutex);
+
+    if(! overview)
+    {
+      std::shared_ptr<SampleOverview> new_overview = std::make_shared<SampleOverview>();
+
+      if(mapped_file.isOpen())
+      {
+        new_overview->build(mapped_file.frames, [this](unsigned int index, float *left, float *right) {
+          mapped_file.read(index, left, right);
+        });
+      }
+      else
+      {
+        new_overview->build(audio.size(), [this](unsigned int index, float *left, float *right) {
+          audio.read(index, left, right);
+        });
+      }
+
+      overview = new_overview;
+    }
+
+    return(overview);
+  }
+};
+
+struct SampleCache
+{
+  struct Entry
+  {
+    int64_t modified_time = 0;
+    int64_t file_size = 0;
+    std::weak_ptr<const SampleAudioData> decoded;
+    std::weak_ptr<const SampleAudioData> mapped;
+  };
+
+  std::map<std::string, Entry> entries;
+  std::mutex mutex;
+
+  // All modules share one cache
+  static SampleCache &instance()
+  {
+    static SampleCache sample_cache;
+    return(sample_cache);
+  }
+
+  // Returns the decoded audio for the file at _path_, decoding it only if
+  // it's not already in memory.  Returns an empty pointer on failure.
+  // This is called from the SampleLoader's worker thread or the GUI thread,
+  // never from the audio thread.
+  //
+  // If _allow_mapping_ is true, files of at least MAPPED_WAV_MIN_FILE_SIZE
+  // bytes are memory mapped instead of decoded, and a copy which is already
+  // in the cache is shared whether it was mapped or decoded.  Otherwise, only
+  // a decoded copy is ever returned.
+  std::shared_ptr<const SampleAudioData> load(std::string path, bool allow_mapping = false)
+  {
+    std::string key = rack::system::getCanonical(path);
+    if(key == "") key = path;
+
+    struct stat file_stats;
+    if(stat(key.c_str(), &file_stats) != 0) return(NULL);
+
+    int64_t modified_time = fileModifiedTime(file_stats);
+    int64_t file_size = file_stats.st_size;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+
+      auto entry = entries.find(key);
+
+      if(entry != entries.end() && entry->second.modified_time == modified_time && entry->second.file_size == file_size)
+      {
+        std::shared_ptr<const SampleAudioData> data;
+        if(allow_mapping) data = entry->second.mapped.lock();
+        if(! data) data = entry->second.decoded.lock();
+        if(data) return(data);
+      }
+    }
+
+    // Decode outside of the lock so that other files can be looked up in
+    // the meantime.  If two threads decode the same file at once, the last
+    // one to finish replaces the other's cache entry.  Both results are valid.
+    std::shared_ptr<const SampleAudioData> data;
+    if(allow_mapping && file_size >= MAPPED_WAV_MIN_FILE_SIZE) data = map(key);
+    if(! data) data = decode(key);
+    if(! data) return(NULL);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+
+      removeExpiredEntries();
+
+      Entry &entry = entries[key];
+
+      // Copies of an older version of the file are forgotten
+      if(entry.modified_time != modified_time || entry.file_size != file_size)
+      {
+        entry = Entry();
+        entry.modified_time = modified_time;
+        entry.file_size = file_size;
+      }
+
+      if(data->mapped()) entry.mapped = data;
+      else entry.decoded = data;
+    }
+
+    return(data);
+  }
+
+  // Returns the audio for the file at _path_ if it's already in memory,
+  // without decoding it or checking whether the file has changed.  Returns
+  // an empty pointer if it isn't.
+  std::shared_ptr<const SampleAudioData> find(std::string path)
+  {
+    std::string key = rack::system::getCanonical(path);
+    if(key == "") key = path;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto entry = entries.find(key);
+    if(entry == entries.end()) return(NULL);
+
+    std::shared_ptr<const SampleAudioData> data = entry->second.decoded.lock();
+    if(! data) data = entry->second.mapped.lock();
+
+    return(data);
+  }
+
+  // Mono files are decoded as a single channel, and files with more than two
+  // channels keep the first two.
+  std::shared_ptr<const SampleAudioData> decode(std::string path)
+  {
+    std::shared_ptr<SampleAudioData> data = std::make_shared<SampleAudioData>();
+
+    if(! decodeWav(path, data.get()) && ! decodeAudioFile(path, data.get())) return(NULL);
+
+    return(data);
+  }
+
+  // Most .wav files are converted straight from the file into the
+  // InterleavedAudioBuffer, by mapping the file (see MappedWavFile.hpp) just
+  // long enough to read it.  No other copy of the audio is ever held in
+  // memory.  Returns false for formats which MappedWavFile can't read.
+  bool decodeWav(std::string path, SampleAudioData *data)
+  {
+    MappedWavFile wav_file;
+    if(! wav_file.open(path)) return(false);
+
+    data->sample_rate = wav_file.sample_rate;
+    data->channels = wav_file.channels;
+    data->audio.channels = std::min(wav_file.channels, 2u);
+    data->audio.resize(wav_file.frames);
+
+    for(unsigned int i = 0; i < wav_file.frames; i++)
+    {
+      float left, right;
+      wav_file.read(i, &left, &right);
+      data->audio.set(i, left, right);
+    }
+
+    return(true);
+  }
+
+  // Everything else goes through AudioFile.h, which decodes into one vector
+  // per channel.  Those have to be copied to interleave them.  They're taken
+  // out of the AudioFile, and any channels which aren't used are freed before
+  // the copy is made.
+  bool decodeAudioFile(std::string path, SampleAudioData *data)
+  {
+    AudioFile<float> audio_file;
+
+    if(! audio_file.load(path)) return(false);
+
+    int number_of_channels = audio_file.getNumChannels();
+    if(number_of_channels < 1) return(false);
+
+    std::vector<std::vector<float>> channels;
+    channels.swap(audio_file.samples);
+
+    data->sample_rate = audio_file.getSampleRate();
+    data->channels = number_of_channels;
+    data->audio.channels = std::min(number_of_channels, 2);
+
+    // Channels past the first two are never used
+    channels.resize(data->audio.channels);
+
+    unsigned int length = channels[0].size();
+    data->audio.resize(length);
+
+    for(unsigned int i = 0; i < length; i++)
+    {
+      data->audio.set(i, channels[0][i], channels.back()[i]);
+    }
+
+    return(true);
+  }
+
+  // Returns NULL if the file isn't in a format that MappedWavFile supports
+  std::shared_ptr<const SampleAudioData> map(std::string path)
+  {
+    std::shared_ptr<SampleAudioData> data = std::make_shared<SampleAudioData>();
+
+    if(! data->mapped_file.open(path)) return(NULL);
+
+    data->sample_rate = data->mapped_file.sample_rate;
+    data->channels = data->mapped_file.channels;
+
+    return(data);
+  }
+
+  // Called with the mutex held
+  void removeExpiredEntries()
+  {
+    for(auto it = entries.begin(); it != entries.end();)
+    {
+      if(it->second.decoded.expired() && it->second.mapped.expired()) it = entries.erase(it);
+      else it++;
+    }
+  }
+};
@@ -0,0 +1,403 @@
+/*
+  SampleLoader.hpp
+
+  The SampleLoader is a single, shared service that reads and decodes .wav
+  files on a small pool of background worker threads.  Before this existed, every module
+  called Sample::load() directly, which meant that loading a long sample
+  from within process() would stall the audio engine until the entire file
+  had been read and decoded.
+
+  How it works:
+
+  1. A module (usually through SamplePlayer::loadSampleAsync) asks the loader
+     for a file by calling SampleLoader::instance().request(path).  This
+     returns a SampleLoadRequest, which is owned by the loader.
+
+  2. The request is handed to a SampleLoadSlot, which lives next to the
+     sample that will eventually receive the audio.  Posting and taking
+     requests from the slot is lock-free.
+
+  3. A worker thread decodes the file into a brand new Sample and flags
+     the request as ready.  Several files are decoded at once, one on each
+     worker, and each request is ready as soon as its own file is done.  A
+     bank of many files doesn't wait for the slowest one.
+
+  4. At a safe point in process(), the module takes the finished request out
+     of its slot and swaps the decoded sample into place.  Swapping only
+     exchanges vector and string internals, so it never allocates, reads
+     files, or decodes audio on the audio thread.
+
+  5. After the swap, the request is holding the _old_ sample data.  It's
+     released back to the loader, which frees it on a worker thread.
+
+  Requests for other kinds of samples, such as SampleMC, derive from
+  LoadRequest and implement decode().  A request with an empty path decodes
+  to an empty sample.  Modules use these to unload a sample without freeing
+  memory on the audio thread.
+
+  The offline renderer (bench/offline_render.cpp) builds the plugin with
+  VOXGLITCH_OFFLINE_RENDER defined.  Renders have to come out the same every
+  time, which they can't if a sample turns up a few frames sooner or later
+  depending on the worker threads, so there each request is decoded as soon
+  as it's submitted, on the thread which submits it.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "PathTable.hpp"
+
+// Decoding is mostly spent reading and converting audio, so a few workers
+// are enough to keep a disk busy without competing with the audio engine.
+#define SAMPLE_LOADER_MAX_WORKERS 4
+
+struct LoadRequest
+{
+  enum States
+  {
+    QUEUED,   // Waiting for a worker thread
+    READY,    // Decoded (or failed to decode) and waiting to be taken
+    RELEASED  // Taken or cancelled.  The loader may delete the request.
+  };
+
+  std::string path = "";
+  bool success = false;
+
+  // The path as a PathTable handle, set by the worker thread once the file
+  // has been decoded.  Modules store this when they take the request, so that
+  // the GUI can show the file name without process() copying strings.
+  // NONE for requests with an empty path.
+  unsigned int path_handle = PathTable::NONE;
+  std::atomic<int> state {QUEUED};
+
+  // Set while a worker is decoding the request, so that it isn't deleted
+  // if it's cancelled in the meantime.  Only touched with the loader locked.
+  bool decoding = false;
+
+  LoadRequest(std::string path)
+  {
+    this->path = path;
+  }
+
+  virtual ~LoadRequest()
+  {
+  }
+
+  // Called on a worker thread.  Returns true on success.
+  virtual bool decode() = 0;
+
+  bool isReady()
+  {
+    return(state.load(std::memory_order_acquire) == READY);
+  }
+
+  // Hand the request back to the loader.  This is safe to call from the
+  // audio thread, as the memory is freed later by the worker thread.
+  void release()
+  {
+    state.store(RELEASED, std::memory_order_release);
+  }
+};
+
+struct SampleLoadRequest : LoadRequest
+{
+  bool allow_mapping = false;
+  unsigned int stream_read_ahead_ms = 0;
+  Sample sample;
+
+  SampleLoadRequest(std::string path, bool allow_mapping, unsigned int stream_read_ahead_ms) : LoadRequest(path)
+  {
+    this->allow_mapping = allow_mapping;
+    this->stream_read_ahead_ms = stream_read_ahead_ms;
+  }
+
+  bool decode() override
+  {
+    if(path == "") return(true);
+    return(sample.load(path, allow_mapping, stream_read_ahead_ms));
+  }
+};
+
+//
+// LoadSlot
+//
+// A SampleLoadSlot holds at most one pending request.  Posting a new request
+// replaces (and cancels) any request which hasn't been taken yet.  Slots are
+// intentionally not copied along with their owner, because SamplePlayers are
+// often stored in std::vectors which copy their contents when they grow.
+//
+
+template <typename Request>
+struct LoadSlot
+{
+  std::atomic<Request *> request {NULL};
+
+  LoadSlot()
+  {
+  }
+
+  LoadSlot(const LoadSlot &other)
+  {
+  }
+
+  LoadSlot& operator=(const LoadSlot &other)
+  {
+    return(*this);
+  }
+
+  ~LoadSlot()
+  {
+    cancel();
+  }
+
+  // Marks the slot while take() is looking at the request it took out.  It's
+  // only ever compared against, never dereferenced.
+  static Request *claimed()
+  {
+    static char marker;
+    return(reinterpret_cast<Request *>(&marker));
+  }
+
+  // Called from the GUI thread (or dataFromJson)
+  void post(Request *new_request)
+  {
+    Request *old_request = request.exchange(new_request, std::memory_order_acq_rel);
+
+    // A claimed request belongs to take(), which releases it once it sees
+    // that the slot has changed
+    if(old_request && old_request != claimed()) old_request->release();
+  }
+
+  void cancel()
+  {
+    post(NULL);
+  }
+
+  // Called from the audio thread.  Returns NULL unless a finished request
+  // is waiting.  The caller is responsible for calling release() on it.
+  //
+  // Whoever takes a request out of the slot owns it.  The request is claimed
+  // before it's looked at, as otherwise post() could release it, and the
+  // loader delete it, in the meantime.  The slot holds claimed() until the
+  // request is put back, so a post() or cancel() made in the meantime isn't
+  // lost.  It replaces claimed(), which makes putting the request back fail,
+  // and the request is released instead.  Unfinished requests are put back.
+  Request *take()
+  {
+    Request *pending_request = request.load(std::memory_order_acquire);
+    if(pending_request == NULL) return(NULL);
+
+    pending_request = request.exchange(claimed(), std::memory_order_acq_rel);
+
+    Request *expected = claimed();
+
+    // Cancelled since it was checked above
+    if(pending_request == NULL)
+    {
+      request.compare_exchange_strong(expected, NULL, std::memory_order_acq_rel);
+      return(NULL);
+    }
+
+    if(pending_request->isReady())
+    {
+      // If the GUI posted a newer request in the meantime, it stays
+      request.compare_exchange_strong(expected, NULL, std::memory_order_acq_rel);
+      return(pending_request);
+    }
+
+    // If the GUI posted a newer request, or cancelled, while this one was out
+    // of the slot, this one is no longer wanted
+    if(! request.compare_exchange_strong(expected, pending_request, std::memory_order_acq_rel)) pending_request->release();
+
+    return(NULL);
+  }
+
+  bool pending()
+  {
+    return(request.load(std::memory_order_acquire) != NULL);
+  }
+
+  // The waiting request, or NULL, for SampleLoader::prioritize().  It may be
+  // taken or released at any moment, so it's only good for comparing.
+  Request *peek()
+  {
+    Request *pending_request = request.load(std::memory_order_acquire);
+    return((pending_request == claimed()) ? NULL : pending_request);
+  }
+};
+
+typedef LoadSlot<SampleLoadRequest> SampleLoadSlot;
+
+struct SampleLoader
+{
+  std::deque<LoadRequest *> queue;
+  std::vector<LoadRequest *> requests;
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::vector<std::thread> workers;
+  bool running = false;
+
+  // All modules share one loader
+  static SampleLoader &instance()
+  {
+    static SampleLoader sample_loader;
+    return(sample_loader);
+  }
+
+  ~SampleLoader()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      running = false;
+    }
+
+    condition.notify_all();
+    for(std::thread &worker : workers) worker.join();
+
+    for(LoadRequest *request : requests) delete request;
+    requests.clear();
+  }
+
+  SampleLoadRequest *request(std::string path, bool allow_mapping = false, unsigned int stream_read_ahead_ms = 0, bool urgent = false)
+  {
+    return(submit(new SampleLoadRequest(path, allow_mapping, stream_read_ahead_ms), urgent));
+  }
+
+  // Queues any kind of request.  Urgent requests, such as the sample that a
+  // module is about to play, go to the front of the queue.
+  template <typename Request>
+  Request *submit(Request *new_request, bool urgent = false)
+  {
+#ifdef VOXGLITCH_OFFLINE_RENDER
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      requests.push_back(new_request);
+      new_request->decoding = true;
+    }
+
+    load(new_request);
+    collectGarbage();
+#else
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+
+      // The workers are started the first time that they're needed
+      if(! running)
+      {
+        running = true;
+
+        unsigned int number_of_workers = std::thread::hardware_concurrency();
+        number_of_workers = (number_of_workers > 1) ? std::min(number_of_workers - 1, (unsigned int) SAMPLE_LOADER_MAX_WORKERS) : 1;
+
+        for(unsigned int i = 0; i < number_of_workers; i++)
+        {
+          workers.push_back(std::thread(&SampleLoader::run, this));
+        }
+      }
+
+      requests.push_back(new_request);
+
+      if(urgent) queue.push_front(new_request);
+      else queue.push_back(new_request);
+    }
+
+    condition.notify_one();
+#endif
+
+    return(new_request);
+  }
+
+  // Moves a queued request to the front of the queue.  It's fine if the
+  // request has already been decoded, or even deleted, as it's only compared
+  // with the requests in the queue.
+  void prioritize(LoadRequest *queued_request)
+  {
+    if(queued_request == NULL) return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = std::find(queue.begin(), queue.end(), queued_request);
+    if(it == queue.end() || it == queue.begin()) return;
+
+    queue.erase(it);
+    queue.push_front(queued_request);
+  }
+
+  void run()
+  {
+    while(true)
+    {
+      LoadRequest *next_request = NULL;
+
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        // Wake up every now and then, even when idle, to free released requests
+        condition.wait_for(lock, std::chrono::milliseconds(500), [this] { return(! queue.empty() || ! running); });
+
+        if(! running) return;
+
+        if(! queue.empty())
+        {
+          next_request = queue.front();
+          next_request->decoding = true;
+          queue.pop_front();
+        }
+      }
+
+      if(next_request) load(next_request);
+
+      collectGarbage();
+    }
+  }
+
+  void load(LoadRequest *load_request)
+  {
+    // Don't bother reading files that nobody is waiting for anymore
+    if(load_request->state.load(std::memory_order_acquire) == LoadRequest::QUEUED)
+    {
+      load_request->success = load_request->decode();
+      if(load_request->success && load_request->path != "") load_request->path_handle = PathTable::shared().intern(load_request->path);
+
+      // If the request was cancelled while loading, it stays RELEASED
+      int expected = LoadRequest::QUEUED;
+      load_request->state.compare_exchange_strong(expected, LoadRequest::READY, std::memory_order_acq_rel);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    load_request->decoding = false;
+  }
+
+  void collectGarbage()
+  {
+    std::vector<LoadRequest *> released_requests;
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+
+      // Requests which another worker is still decoding are left for later
+      auto first_released = std::stable_partition(requests.begin(), requests.end(), [](LoadRequest *request) {
+        return(request->decoding || request->state.load(std::memory_order_acquire) != LoadRequest::RELEASED);
+      });
+
+      // Released requests still sitting in the queue are skipped by load(),
+      // but they must be removed from the queue before being deleted.
+      for(auto it = first_released; it != requests.end(); it++)
+      {
+        queue.erase(std::remove(queue.begin(), queue.end(), *it), queue.end());
+        released_requests.push_back(*it);
+      }
+
+      requests.erase(first_released, requests.end());
+    }
+
+    // Free the memory outside of the lock
+    for(LoadRequest *request : released_requests) delete request;
+  }
+};
@@ -0,0 +1,181 @@
+/*
+  SampleOverview.hpp
+
+  A multi-resolution summary of a sample's audio, for waveform displays.
+
+  Drawing a waveform used to mean reading every frame of the sample on the
+  GUI thread, once for each column of pixels.  For long files this froze the
+  interface for a noticeable amount of time.
+
+  The SampleOverview is built on one of the SampleLoader's worker threads,
+  the first time a display asks for it (see OverviewLoadRequest.hpp), and is
+  then shared along with the audio (see SampleCache.hpp).  Samples which are
+  never displayed never have one.  Level 0 holds the minimum, maximum, sum
+  of absolute values and sum of squares of every block of BLOCK_SIZE frames.
+  Each following level combines pairs of bins from the level below it, until
+  a single bin covers the whole sample.
+
+  getRange() summarizes any range of frames by combining at most two bins
+  from each level, so a display of any width and zoom level can be drawn with
+  a small, fixed amount of work per pixel.  Ranges are rounded out to whole
+  blocks of BLOCK_SIZE frames, which is fine for drawing, but means that the
+  results for ranges of only a few blocks are approximate.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+struct SampleOverview
+{
+  static const unsigned int BLOCK_SIZE = 64;
+
+  struct Bin
+  {
+    float minimum = 0.0;
+    float maximum = 0.0;
+    float sum_of_absolutes = 0.0;   // of the left and right channels together
+    float sum_of_squares = 0.0;     // likewise
+    unsigned int frames = 0;
+
+    void add(const Bin &other)
+    {
+      if(other.frames == 0) return;
+
+      if(frames == 0)
+      {
+        *this = other;
+        return;
+      }
+
+      minimum = std::min(minimum, other.minimum);
+      maximum = std::max(maximum, other.maximum);
+      sum_of_absolutes += other.sum_of_absolutes;
+      sum_of_squares += other.sum_of_squares;
+      frames += other.frames;
+    }
+
+    // Average absolute value of both channels
+    float average() const
+    {
+      if(frames == 0) return(0.0);
+      return(sum_of_absolutes / (frames * 2));
+    }
+
+    // Root mean square of both channels
+    float rms() const
+    {
+      if(frames == 0) return(0.0);
+      return(std::sqrt(sum_of_squares / (frames * 2)));
+    }
+
+    // Largest absolute value
+    float peak() const
+    {
+      return(std::max(std::abs(minimum), std::abs(maximum)));
+    }
+  };
+
+  std::vector< std::vector<Bin> > levels;
+  unsigned int length = 0;
+
+  bool empty() const
+  {
+    return(levels.empty());
+  }
+
+  void clear()
+  {
+    levels.clear();
+    length = 0;
+  }
+
+  // Builds the overview for _length_ frames.  read_frame(index, &left, &right)
+  // is called once for each frame, in order.
+  template <typename FrameReader>
+  void build(unsigned int length, FrameReader read_frame)
+  {
+    clear();
+    if(length == 0) return;
+
+    this->length = length;
+
+    std::vector<Bin> bins((length + BLOCK_SIZE - 1) / BLOCK_SIZE);
+
+    for(unsigned int b = 0; b < bins.size(); b++)
+    {
+      Bin &bin = bins[b];
+      unsigned int start = b * BLOCK_SIZE;
+      unsigned int end = std::min(start + BLOCK_SIZE, length);
+
+      float left, right;
+      read_frame(start, &left, &right);
+
+      bin.minimum = std::min(left, right);
+      bin.maximum = std::max(left, right);
+      bin.sum_of_absolutes = std::abs(left) + std::abs(right);
+      bin.sum_of_squares = (left * left) + (right * right);
+
+      for(unsigned int i = start + 1; i < end; i++)
+      {
+        read_frame(i, &left, &right);
+
+        bin.minimum = std::min(bin.minimum, std::min(left, right));
+        bin.maximum = std::max(bin.maximum, std::max(left, right));
+        bin.sum_of_absolutes += std::abs(left) + std::abs(right);
+        bin.sum_of_squares += (left * left) + (right * right);
+      }
+
+      bin.frames = end - start;
+    }
+
+    levels.push_back(std::move(bins));
+
+    while(levels.back().size() > 1)
+    {
+      const std::vector<Bin> &below = levels.back();
+      std::vector<Bin> above((below.size() + 1) / 2);
+
+      for(unsigned int b = 0; b < below.size(); b++)
+      {
+        above[b / 2].add(below[b]);
+      }
+
+      levels.push_back(std::move(above));
+    }
+  }
+
+  // Summarizes the frames from _start_ up to, but not including, _end_
+  Bin getRange(unsigned int start, unsigned int end) const
+  {
+    Bin result;
+
+    if(levels.empty()) return(result);
+
+    end = std::min(end, length);
+    if(start >= end) return(result);
+
+    // Cover the range with the fewest bins, like a segment tree: at each
+    // level, bins at the ends of the range which don't pair up with a
+    // neighbour inside the range are added, and the rest are left to the
+    // level above.  This visits two bins per level at most.
+    unsigned int first_bin = start / BLOCK_SIZE;
+    unsigned int end_bin = ((end - 1) / BLOCK_SIZE) + 1;
+
+    for(unsigned int level = 0; level < levels.size() && first_bin < end_bin; level++)
+    {
+      const std::vector<Bin> &bins = levels[level];
+
+      if(first_bin & 1) result.add(bins[first_bin++]);
+      if(end_bin & 1) result.add(bins[--end_bin]);
+
+      first_bin >>= 1;
+      end_bin >>= 1;
+    }
+
+    return(result);
+  }
+};
@@ -17,6 +17,18 @@
   SamplePlayer is not multi-timbral, and that might be something that could
   improve it in the future.
 
+  Samples can either be loaded immediately using loadSample(), or in the
+  background using loadSampleAsync().  When loading in the background, the
+  module must call acceptLoadedSample() from process() so that the new
+  sample can be swapped in once it's ready.  See SampleLoader.hpp.
+
+  Modules with many voices can use renderFrame() instead of calling
+  getStereoOutput() and step() for every frame.  It reads the pitch and loop
+  settings on every frame, like step(), but skips the work which only
+  depends on them when they haven't changed, such as converting the pitch
+  to a step size.  renderBlock() does the same for a whole block of frames
+  at a fixed pitch.
+
 */
 
 struct SamplePlayer
@@ -25,6 +37,27 @@ struct SamplePlayer
   double playback_position = 0.0f;
   bool playing = false;
   double step_amount = 0.0;
+  SampleLoadSlot load_slot;
+
+  // The path of the sample, as a PathTable handle.  The GUI reads the file
+  // name through this (see getFilename()) rather than from the sample, which
+  // the audio thread may be swapping at the same time.
+  PathHandle loaded_path;
+
+  // Modules which play long recordings from start to end, such as Looper
+  // and WavBank, set this so that large files are memory mapped rather than
+  // decoded into memory.  See MappedWavFile.hpp.
+  bool map_large_files = false;
+
+  // The step size for the last pitch passed to renderFrame(), or negative
+  // when it has to be worked out again
+  float cached_pitch = 0.0;
+  double cached_increment = -1.0;
+
+  // When set (in milliseconds), mapped files are streamed from disk through
+  // a small read-ahead buffer instead of being read directly.  See
+  // SampleStream.hpp.  Zero turns streaming off.
+  unsigned int stream_read_ahead_ms = 0;
 
   // Trigger restarts sample playback by setting the playback position and
   // setting the "playing" boolean to true.
@@ -137,6 +170,117 @@ struct SamplePlayer
     }
   }
 
+  //
+  // renderBlock
+  //
+  // Renders _n_ frames into _left_output_ and _right_output_, with the same
+  // result as calling getStereoOutput() followed by step() (or stepReverse())
+  // _n_ times.  The pitch is only converted to a step size once per block,
+  // and the playing/loaded checks are done up front.
+  //
+
+  void renderBlock(float *left_output, float *right_output, unsigned int n, float pitch = 0.0, float sample_start = 0.0, float sample_end = 1.0, bool loop = false, unsigned int interpolation = 1, bool reverse = false)
+  {
+    renderFrames(left_output, right_output, n, getSampleIncrement(pitch), sample_start, sample_end, loop, interpolation, reverse);
+  }
+
+  // renderBlock(), with the pitch already converted to a step size
+  void renderFrames(float *left_output, float *right_output, unsigned int n, double sample_increment, float sample_start, float sample_end, bool loop, unsigned int interpolation, bool reverse)
+  {
+    unsigned int i = 0;
+
+    if(this->playing && this->sample.loaded)
+    {
+      unsigned int sample_length = sample.size();
+      unsigned int sample_size = sample_length * sample_end;
+
+      if(! reverse)
+      {
+        float loop_position = (sample_start * sample_size) + ((sample_size - sample_start) * loop);
+        double loop_start = sample_start * sample_size;
+
+        for(; i < n && playing; i++)
+        {
+          readFrame(&left_output[i], &right_output[i], sample_length, interpolation);
+
+          playback_position += sample_increment;
+
+          if(loop > 0)
+          {
+            if(playback_position >= loop_position) playback_position = loop_start;
+          }
+          else if(playback_position >= sample_size) playing = false;
+        }
+      }
+      else
+      {
+        float playback_start = (1.0 - sample_start) * sample_size;
+        float loop_position = playback_start - (loop * (sample_size - playback_start));
+
+        for(; i < n && playing; i++)
+        {
+          readFrame(&left_output[i], &right_output[i], sample_length, interpolation);
+
+          playback_position -= sample_increment;
+
+          if(loop > 0)
+          {
+            if(playback_position <= loop_position) playback_position = playback_start;
+          }
+          else if(playback_position <= 0) playing = false;
+        }
+      }
+    }
+
+    // Silence for the rest of the block once playback has stopped
+    for(; i < n; i++)
+    {
+      left_output[i] = 0;
+      right_output[i] = 0;
+    }
+  }
+
+  // Read the frame at the playback position, as getStereoOutput() does
+  void readFrame(float *left_output, float *right_output, unsigned int sample_length, unsigned int interpolation)
+  {
+    unsigned int sample_index = playback_position;
+
+    if(sample_index >= sample_length)
+    {
+      *left_output = 0;
+      *right_output = 0;
+    }
+    else if(interpolation == 0)
+    {
+      this->sample.read(sample_index, left_output, right_output);
+    }
+    else
+    {
+      this->sample.readLI(playback_position, left_output, right_output);
+    }
+  }
+
+  //
+  // renderFrame
+  //
+  // Replaces a call to getStereoOutput() followed by step() (or stepReverse()
+  // when _reverse_ is true), and renders exactly one frame, so that pitch
+  // modulation is followed frame by frame and playback_position always
+  // belongs to the next frame.  The pitch is only converted to a step size
+  // again when it changes.
+  //
+
+  void renderFrame(float *left_output, float *right_output, unsigned int interpolation, float pitch = 0.0, float sample_start = 0.0, float sample_end = 1.0, bool loop = false, bool reverse = false)
+  {
+    if(pitch != cached_pitch || cached_increment < 0.0)
+    {
+      cached_pitch = pitch;
+      cached_increment = getSampleIncrement(pitch);
+    }
+
+    renderFrames(left_output, right_output, 1, cached_increment, sample_start, sample_end, loop, interpolation, reverse);
+  }
+
   double getSampleIncrement(float pitch_cv_input)
   {
     return(this->step_amount * rack::dsp::approxExp2_taylor5(pitch_cv_input));
@@ -149,8 +293,9 @@ struct SamplePlayer
 
   bool loadSample(std::string path)
   {
-    if(sample.load(path))
+    if(sample.load(path, map_large_files, stream_read_ahead_ms))
     {
+      loaded_path.store(PathTable::shared().intern(path));
       updateStepAmount();
       return(true);
     }
@@ -160,33 +305,84 @@ struct SamplePlayer
     }
   }
 
-  void releaseSample()
+  // Ask the shared SampleLoader to load the sample on its worker thread.  The
+  // currently loaded sample (if any) keeps playing until acceptLoadedSample()
+  // swaps in the new one.  Urgent requests are loaded before any others
+  // which are waiting.
+  void loadSampleAsync(std::string path, bool urgent = false)
   {
-    sample.unload();
-    this->playback_position = 0.0f;
-    this->playing = false;
-    this->setFilename("");
-    this->setPath("");
+    load_slot.post(SampleLoader::instance().request(path, map_large_files, stream_read_ahead_ms, urgent));
   }
 
-  std::string getFilename()
+  // Like loadSampleAsync(), but with a request which was submitted to the
+  // SampleLoader elsewhere, such as on a recorder's writer thread.  This
+  // doesn't allocate, so it may be called from process().
+  void postLoadRequest(SampleLoadRequest *load_request)
   {
-    return(sample.filename);
+    load_slot.post(load_request);
   }
 
-  void setFilename(std::string filename)
+  // Frees the sample in the background.  Like loadSampleAsync(), the sample
+  // keeps playing until acceptLoadedSample() swaps in the (empty) result.
+  void unloadSampleAsync()
   {
-    sample.filename = filename;
+    load_slot.post(SampleLoader::instance().request(""));
   }
 
-  std::string getPath()
+  // Asks the loader to load this sample next, if it's still waiting
+  void prioritizeLoad()
   {
-    return(sample.path);
+    SampleLoader::instance().prioritize(load_slot.peek());
   }
 
-  void setPath(std::string path)
+  // acceptLoadedSample() should be called from the module's process() method.
+  // It returns true if a sample, which was requested using loadSampleAsync(),
+  // has finished loading and was swapped into this sample player.
+  bool acceptLoadedSample()
+  {
+    SampleLoadRequest *load_request = load_slot.take();
+    if(load_request == NULL) return(false);
+
+    bool success = load_request->success;
+
+    if(success)
+    {
+      sample.swap(load_request->sample);
+      loaded_path.store(load_request->path_handle);
+      updateStepAmount();
+    }
+
+    // The request now holds the old sample data, which the loader will free
+    load_request->release();
+
+    return(success);
+  }
+
+  bool isLoading()
+  {
+    return(load_slot.pending());
+  }
+
+  void releaseSample()
+  {
+    load_slot.cancel();
+    sample.unload();
+    this->playback_position = 0.0f;
+    this->playing = false;
+    loaded_path.store(PathTable::NONE);
+  }
+
+  // The file name and path of the loaded sample, or "" if there isn't one.
+  // These copy strings, so they're meant for the GUI and for saving patches,
+  // not for process().
+  std::string getFilename()
+  {
+    return(system::getFilename(getPath()));
+  }
+
+  std::string getPath()
   {
-    sample.path = path;
+    return(loaded_path.path());
   }
 
   void updateSampleRate()
@@ -197,6 +393,7 @@ struct SamplePlayer
   void updateStepAmount()
   {
     step_amount = (sample.sample_rate / APP->engine->getSampleRate());
+    cached_increment = -1.0;
   }
 
   unsigned int getSampleRate()
@@ -211,10 +408,10 @@ struct SamplePlayer
 
   void initialize()
   {
+    load_slot.cancel();
     sample.unload();
     this->playback_position = 0.0f;
     this->playing = false;
-    this->setFilename("");
-    this->setPath("");
+    loaded_path.store(PathTable::NONE);
   }
 };
@@ -0,0 +1,357 @@
+/*
+  SampleStream.hpp
+
+  A memory mapped file (see MappedWavFile.hpp) opens instantly, but the first
+  read of every page still has to go to disk, and that would happen on the
+  audio thread.  A SampleStream moves that work to a background thread.
+
+  Each stream keeps two small buffers:
+
+  1. The head: the first _read_ahead_ milliseconds of the file, which are
+     read once when the stream is created.  Looper and WavBank always start
+     and loop from the beginning of the sample, so triggers and loop points
+     play out of the head while the ring buffer catches up.
+
+  2. The ring: a power-of-two sized ring buffer which the SampleStreamer's
+     worker thread keeps filled _read_ahead_ milliseconds either side of
+     the current playback position, so that reverse playback streams as
+     well as forward playback.  Frames in the direction of playback are
+     read first.
+
+  The playback position isn't passed in explicitly.  Each read() publishes
+  the frame it's reading, and the worker follows along.  When playback jumps
+  somewhere that isn't buffered, the worker starts over from there.
+
+  The audio thread never reads the source itself, as that could wait on the
+  disk.  A frame which isn't buffered yet (because playback jumped, or the
+  disk fell behind) plays as the last frame which was, until the worker has
+  caught up.  A miss also makes the worker check back sooner than usual.
+
+  Memory use is fixed at (head + ring) frames, no matter how long the file
+  is.  An hour long backing track needs less than a megabyte.
+
+  The window of valid ring frames is published as a single 64 bit atomic
+  (start in the upper 32 bits, end in the lower 32 bits).  The worker always
+  moves the start of the window past a frame before overwriting its slot, and
+  the audio thread checks the window again after reading a slot, so a frame
+  that was overwritten during a read is never used.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct SampleStream
+{
+  std::shared_ptr<const SampleAudioData> source;
+
+  std::vector<float> head_left;
+  std::vector<float> head_right;
+  unsigned int head_frames = 0;
+
+  std::vector<float> ring_left;
+  std::vector<float> ring_right;
+  unsigned int ring_mask = 0;
+  unsigned int read_ahead_frames = 0;
+
+  std::atomic<uint64_t> window {0};
+  std::atomic<unsigned int> playback_frame {0};
+  std::atomic<bool> missed {false};
+
+  // The last frame read by the audio thread, held when a frame is missing
+  float last_left = 0.0;
+  float last_right = 0.0;
+
+  // Only used by the worker, to work out which way playback is going
+  unsigned int previous_from = 0;
+
+  SampleStream(std::shared_ptr<const SampleAudioData> source, unsigned int read_ahead_ms)
+  {
+    this->source = source;
+
+    unsigned int length = source->size();
+
+    read_ahead_frames = std::max(1.0f, source->sample_rate * read_ahead_ms / 1000.0f);
+    head_frames = std::min(read_ahead_frames, length);
+
+    // The ring holds twice the read ahead, so that the worker can stay a
+    // full read ahead in front of playback without overwriting the frames
+    // just behind it.
+    unsigned int ring_size = 1;
+    while(ring_size < (read_ahead_frames * 2)) ring_size <<= 1;
+    ring_mask = ring_size - 1;
+
+    head_left.resize(head_frames);
+    head_right.resize(head_frames);
+    ring_left.resize(ring_size);
+    ring_right.resize(ring_size);
+
+    for(unsigned int i = 0; i < head_frames; i++)
+    {
+      readSource(i, &head_left[i], &head_right[i]);
+    }
+
+    window.store(pack(head_frames, head_frames));
+
+    // Have the first read ahead ready before playback starts
+    fill();
+  }
+
+  static uint64_t pack(unsigned int start, unsigned int end)
+  {
+    return(((uint64_t) start << 32) | end);
+  }
+
+  void readSource(unsigned int index, float *left_audio_ptr, float *right_audio_ptr) const
+  {
+    const MappedWavFile *mapped_file = source->mapped();
+
+    if(mapped_file)
+    {
+      mapped_file->read(index, left_audio_ptr, right_audio_ptr);
+    }
+    else
+    {
+      source->audio.read(index, left_audio_ptr, right_audio_ptr);
+    }
+  }
+
+  // Called from the audio thread.  _index_ must be less than the length of
+  // the source, which SampleAudioBuffer checks.  Never touches the source.
+  void read(unsigned int index, float *left_audio_ptr, float *right_audio_ptr)
+  {
+    playback_frame.store(index, std::memory_order_relaxed);
+
+    if(index < head_frames)
+    {
+      last_left = head_left[index];
+      last_right = head_right[index];
+    }
+    else if(! readRing(index, &last_left, &last_right))
+    {
+      // Not buffered (yet).  Hold the last frame and hurry the worker along.
+      missed.store(true, std::memory_order_relaxed);
+    }
+
+    *left_audio_ptr = last_left;
+    *right_audio_ptr = last_right;
+  }
+
+  bool readRing(unsigned int index, float *left_audio_ptr, float *right_audio_ptr)
+  {
+    uint64_t current_window = window.load(std::memory_order_acquire);
+    if(! contains(current_window, index)) return(false);
+
+    unsigned int slot = index & ring_mask;
+    float left = ring_left[slot];
+    float right = ring_right[slot];
+
+    // Make sure that the slot wasn't recycled while it was being read
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if(! contains(window.load(std::memory_order_relaxed), index)) return(false);
+
+    *left_audio_ptr = left;
+    *right_audio_ptr = right;
+    return(true);
+  }
+
+  static bool contains(uint64_t packed_window, unsigned int index)
+  {
+    return(index >= (packed_window >> 32) && index < (packed_window & 0xFFFFFFFF));
+  }
+
+  // Called from the SampleStreamer's worker thread, which is the only
+  // thread that writes to the ring.
+  void fill()
+  {
+    unsigned int length = source->size();
+
+    // Frames in the head never need to be streamed
+    unsigned int from = std::max(playback_frame.load(std::memory_order_relaxed), head_frames);
+    bool reverse = (from < previous_from);
+    previous_from = from;
+
+    uint64_t current_window = window.load(std::memory_order_relaxed);
+    unsigned int start = current_window >> 32;
+    unsigned int end = current_window & 0xFFFFFFFF;
+
+    // Playback jumped outside of the buffered window, so start over
+    if(from < start || from > end)
+    {
+      start = from;
+      end = from;
+      window.store(pack(start, end), std::memory_order_release);
+    }
+
+    unsigned int ahead = std::min(from + read_ahead_frames, length);
+    unsigned int behind = std::max(from - std::min(from, read_ahead_frames), head_frames);
+
+    if(reverse)
+    {
+      fillBackward(start, end, behind);
+      fillForward(start, end, ahead);
+    }
+    else
+    {
+      fillForward(start, end, ahead);
+      fillBackward(start, end, behind);
+    }
+  }
+
+  // Extends the window forward until it ends at _target_
+  void fillForward(unsigned int &start, unsigned int &end, unsigned int target)
+  {
+    unsigned int ring_size = ring_mask + 1;
+
+    while(end < target)
+    {
+      unsigned int count = std::min(target - end, 1024u);
+
+      // Drop the oldest frames from the window before recycling their slots
+      if((end + count - start) > ring_size)
+      {
+        start = end + count - ring_size;
+        window.store(pack(start, end), std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+      }
+
+      for(unsigned int i = end; i < end + count; i++)
+      {
+        readSource(i, &ring_left[i & ring_mask], &ring_right[i & ring_mask]);
+      }
+
+      end += count;
+      window.store(pack(start, end), std::memory_order_release);
+    }
+  }
+
+  // Extends the window backward until it starts at _target_
+  void fillBackward(unsigned int &start, unsigned int &end, unsigned int target)
+  {
+    unsigned int ring_size = ring_mask + 1;
+
+    while(start > target)
+    {
+      unsigned int count = std::min(start - target, 1024u);
+
+      // Drop the frames furthest ahead before recycling their slots
+      if((end - (start - count)) > ring_size)
+      {
+        end = start - count + ring_size;
+        window.store(pack(start, end), std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+      }
+
+      for(unsigned int i = start - count; i < start; i++)
+      {
+        readSource(i, &ring_left[i & ring_mask], &ring_right[i & ring_mask]);
+      }
+
+      start -= count;
+      window.store(pack(start, end), std::memory_order_release);
+    }
+  }
+};
+
+//
+// SampleStreamer
+//
+// One worker thread keeps every SampleStream in the plugin filled.  Streams
+// are registered when they're created and are held by weak references, so
+// they drop out of the list once the sample using them is unloaded.
+//
+
+struct SampleStreamer
+{
+  std::vector<std::weak_ptr<SampleStream>> streams;
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::thread worker;
+  bool running = false;
+  bool catching_up = false;   // Only touched by the worker
+
+  static SampleStreamer &instance()
+  {
+    static SampleStreamer sample_streamer;
+    return(sample_streamer);
+  }
+
+  ~SampleStreamer()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      if(! running) return;
+      running = false;
+    }
+
+    condition.notify_one();
+    worker.join();
+  }
+
+  void add(std::shared_ptr<SampleStream> stream)
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if(! running)
+    {
+      running = true;
+      worker = std::thread(&SampleStreamer::run, this);
+    }
+
+    streams.push_back(stream);
+  }
+
+  void run()
+  {
+    std::vector<std::shared_ptr<SampleStream>> active_streams;
+
+    while(true)
+    {
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        // The audio thread never signals the worker, so poll often enough to
+        // stay well within the shortest read ahead, and more often while a
+        // stream is catching up after a miss.
+        condition.wait_for(lock, std::chrono::milliseconds(catching_up ? 1 : 5), [this] { return(! running); });
+
+        if(! running) return;
+
+        active_streams.clear();
+
+        for(auto it = streams.begin(); it != streams.end();)
+        {
+          std::shared_ptr<SampleStream> stream = it->lock();
+
+          if(stream)
+          {
+            active_streams.push_back(stream);
+            it++;
+          }
+          else
+          {
+            it = streams.erase(it);
+          }
+        }
+      }
+
+      catching_up = false;
+
+      for(std::shared_ptr<SampleStream> &stream : active_streams)
+      {
+        if(stream->missed.exchange(false, std::memory_order_relaxed)) catching_up = true;
+        stream->fill();
+      }
+
+      // Let go of the streams here, so that they're never freed while the
+      // mutex is held.
+      active_streams.clear();
+    }
+  }
+};
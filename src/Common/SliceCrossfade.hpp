@@ -0,0 +1,178 @@
+/*
+  SliceCrossfade.hpp
+
+  Lets Autobreak and Autobreak Studio jump around a loop without clicks.
+
+  Those modules used to pass their output through a DeclickFilter after each
+  jump, which blends from the last frame played before the jump, held still,
+  into the new audio.  That smears the first few milliseconds of the new
+  slice, which is where the drum hit is, and still clicks when the two
+  frames are far apart.
+
+  Instead, playback uses a pair of voices.  When the playback position
+  jumps, the voice which was playing keeps going, past the point where the
+  jump happened, while the other voice starts at the new position.  Both play
+  for EqualPowerFade::LENGTH frames (about 3 ms), one fading out while the
+  other fades in.  The two are unrelated pieces of audio, so their gains
+  follow a cosine and a sine, which keeps the overall power, rather than the
+  amplitude, constant.
+
+  Both voices are read and mixed by a single kernel (see mixVoices() below),
+  so a crossfade costs little more than playing one voice, and ratchets at
+  1/16 and faster stay clean.
+
+  process() notices jumps by itself: the position moving by more than
+  JUMP_THRESHOLD frames at once, or a different sample being passed in.
+  Modules call jump() when the audio changes without either of those, such
+  as when a newly loaded sample is swapped into the one playing.
+
+  SliceCrossfade plays the sample like a record, following the module's
+  playback position at whatever speed fits the tempo.  TimeStretch (see
+  TimeStretch.hpp) crossfades its grains the same way when the position
+  jumps.
+*/
+
+#pragma once
+
+#include <cmath>
+
+struct EqualPowerFade
+{
+  static const int LENGTH = 128;
+
+  float fade_in[LENGTH];
+  float fade_out[LENGTH];
+
+  EqualPowerFade()
+  {
+    // Neither end of the fade is silent, so that the incoming voice starts
+    // on its very first frame
+    for(int i = 0; i < LENGTH; i++)
+    {
+      float x = (M_PI / 2.0) * ((i + 1.0) / (LENGTH + 1.0));
+      fade_in[i] = std::sin(x);
+      fade_out[i] = std::cos(x);
+    }
+  }
+};
+
+struct SliceCrossfade
+{
+  // Even at the slowest tempos, playback moves a few frames per frame at
+  // most, so anything further is a jump
+  static const int JUMP_THRESHOLD = 64;
+
+  struct Voice
+  {
+    Sample *sample = NULL;
+    double position = 0.0;
+  };
+
+  Voice incoming;     // Follows the module's playback position
+  Voice outgoing;     // Carries on from where the position jumped away, while it fades out
+  double speed = 0.0; // How far the position moves each frame, between jumps
+  int fade_phase = EqualPowerFade::LENGTH;   // Frames into the crossfade, or LENGTH when there isn't one
+  bool playing = false;
+  bool jump_requested = false;
+
+  EqualPowerFade fade;
+
+  // The next frame starts at full volume, without a crossfade
+  void reset()
+  {
+    playing = false;
+  }
+
+  // The next frame crossfades, even if the position hasn't jumped
+  void jump()
+  {
+    jump_requested = true;
+  }
+
+  // Renders one frame of _sample_ at _position_
+  void process(Sample *sample, double position, float *left, float *right)
+  {
+    if(sample->size() == 0)
+    {
+      *left = 0;
+      *right = 0;
+      return;
+    }
+
+    bool jumped = jump_requested || (sample != incoming.sample) || (std::abs(position - incoming.position) > JUMP_THRESHOLD);
+    jump_requested = false;
+
+    if(! playing)
+    {
+      fade_phase = EqualPowerFade::LENGTH;
+      speed = 0.0;
+      playing = true;
+    }
+    else if(jumped)
+    {
+      // If the last jump is still fading in, whichever voice is louder at
+      // this moment is the one which fades out
+      if(fade_phase == EqualPowerFade::LENGTH || fade.fade_in[fade_phase] >= fade.fade_out[fade_phase]) outgoing = incoming;
+      fade_phase = 0;
+    }
+    else
+    {
+      speed = position - incoming.position;
+    }
+
+    incoming.sample = sample;
+    incoming.position = position;
+
+    if(fade_phase < EqualPowerFade::LENGTH)
+    {
+      outgoing.position += speed;
+
+      mixVoices(
+        incoming.sample, (unsigned int) position, fade.fade_in[fade_phase],
+        outgoing.sample, wrap(std::floor(outgoing.position), outgoing.sample->size()), fade.fade_out[fade_phase],
+        left, right);
+
+      fade_phase++;
+    }
+    else
+    {
+      sample->read((unsigned int) position, left, right);
+    }
+  }
+
+  //
+  // Reads frame _index_a_ of _sample_a_ and frame _index_b_ of _sample_b_,
+  // and mixes them using the gains given.  Frames outside of either sample
+  // are silent.
+  //
+  static void mixVoices(Sample *sample_a, unsigned int index_a, float gain_a, Sample *sample_b, unsigned int index_b, float gain_b, float *left, float *right)
+  {
+    const SampleAudioBuffer &buffer_a = sample_a->sample_audio_buffer;
+    const SampleAudioBuffer &buffer_b = sample_b->sample_audio_buffer;
+
+    // Decoded stereo audio, which is what the breakbeat modules usually load,
+    // is mixed straight from memory
+    if(buffer_a.frames && buffer_b.frames && (buffer_a.channels == 2) && (buffer_b.channels == 2) && (index_a < buffer_a.length) && (index_b < buffer_b.length))
+    {
+      InterleavedAudioBuffer::mixFrames(buffer_a.frames + (index_a * 2), gain_a, buffer_b.frames + (index_b * 2), gain_b, left, right);
+      return;
+    }
+
+    float left_a, right_a, left_b, right_b;
+    sample_a->read(index_a, &left_a, &right_a);
+    sample_b->read(index_b, &left_b, &right_b);
+
+    *left = (left_a * gain_a) + (left_b * gain_b);
+    *right = (right_a * gain_a) + (right_b * gain_b);
+  }
+
+  // Voices which run past either end of the sample wrap around, as the
+  // samples are loops
+  static int wrap(int index, int length)
+  {
+    if(length == 0) return(0);
+
+    index = index % length;
+    return((index < 0) ? index + length : index);
+  }
+};
@@ -0,0 +1,307 @@
+/*
+  SliceMap.hpp
+
+  A list of the drum hits (onsets) in a sample, so that a breakbeat module
+  can jump straight to a hit instead of to an equal division of the loop.
+
+  Autobreak and Autobreak Studio cut every loop into 16 equal slices.  That
+  only lands on the hits when the loop was played exactly in time and
+  trimmed exactly to its first beat, which few loops are.  With a SliceMap,
+  the start of each slice is moved to the nearest onset, as long as there's
+  one within half a slice (see snap()).
+
+  Onsets are found by detect(), which looks for sudden rises in the energy of
+  the sample's high frequencies, where drum hits start.  It reads the whole
+  sample, so it's run once, on the SampleLoader's worker thread (see
+  BreakbeatLoadRequest.hpp), and never while the sample is playing.
+
+  The result is saved next to the sample, as <sample>.slices, and is loaded
+  instead of detected again the next time the sample is used, such as when
+  a patch is reopened.  The file records the sample's size and modification
+  time, and is ignored if the sample has changed since.  If the file can't
+  be written, for example because the sample is in a read-only folder, the
+  onsets are simply detected again next time.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+#include "FileModifiedTime.hpp"
+
+// Tuning for SliceMap::detect(), in seconds
+#define SLICE_MAP_AVERAGE_WINDOW 0.1     // A rise in energy must stand out from the average over this long either side
+#define SLICE_MAP_PEAK_WINDOW 0.03       // ...and be the largest within this long either side
+#define SLICE_MAP_MINIMUM_GAP 0.05       // Flams and rolls closer together than this count as one hit
+
+struct SliceMap
+{
+  static const unsigned int VERSION = 1;   // Increase when detect() changes, so that old files are ignored
+
+  static const unsigned int HOP = 256;     // Frames per step of the energy curve (about 6 ms at 44.1 kHz)
+  static const unsigned int PRE_ROLL = 32; // Onsets are moved this many frames earlier, so that they never cut into the hit
+
+  // Start of each hit in frames, in ascending order
+  std::vector<unsigned int> onsets;
+
+  // Finds the onsets in _length_ frames of audio.  read_frame(index, &left, &right)
+  // is called once for each frame, in order.
+  template <typename FrameReader>
+  void detect(unsigned int length, float sample_rate, FrameReader read_frame)
+  {
+    onsets.clear();
+
+    unsigned int number_of_hops = length / HOP;
+    if(number_of_hops < 3 || sample_rate <= 0) return;
+
+    // The first difference of the mono signal acts as a high pass filter.
+    // Kicks have most of their energy at low frequencies, but even they start
+    // with a click.
+    std::vector<float> difference(number_of_hops * HOP);
+    float previous = 0.0;
+
+    for(unsigned int i = 0; i < difference.size(); i++)
+    {
+      float left, right;
+      read_frame(i, &left, &right);
+
+      float mono = (left + right) * 0.5f;
+      difference[i] = mono - previous;
+      previous = mono;
+    }
+
+    // The energy of each hop, compressed logarithmically so that a hit after
+    // a loud one is found as easily as a hit after silence
+    std::vector<float> energy(number_of_hops);
+
+    for(unsigned int hop = 0; hop < number_of_hops; hop++)
+    {
+      float sum = 0.0;
+      for(unsigned int i = hop * HOP; i < (hop + 1) * HOP; i++) sum += difference[i] * difference[i];
+      energy[hop] = std::log(1.0f + (1000.0f * sum / HOP));
+    }
+
+    // How much the energy rose at each hop
+    std::vector<float> novelty(number_of_hops, 0.0f);
+    float largest_novelty = 0.0;
+
+    for(unsigned int hop = 1; hop < number_of_hops; hop++)
+    {
+      novelty[hop] = std::max(0.0f, energy[hop] - energy[hop - 1]);
+      largest_novelty = std::max(largest_novelty, novelty[hop]);
+    }
+
+    if(largest_novelty <= 0.0) return;
+
+    int average_window = std::max(1, (int) ((SLICE_MAP_AVERAGE_WINDOW * sample_rate) / HOP));
+    int peak_window = std::max(1, (int) ((SLICE_MAP_PEAK_WINDOW * sample_rate) / HOP));
+    int minimum_gap = std::max(1, (int) ((SLICE_MAP_MINIMUM_GAP * sample_rate) / HOP));
+    float threshold = largest_novelty * 0.1f;
+
+    int last_onset_hop = -minimum_gap;
+
+    for(int hop = 1; hop < (int) number_of_hops; hop++)
+    {
+      float value = novelty[hop];
+      if(value < threshold) continue;
+      if(hop - last_onset_hop < minimum_gap) continue;
+
+      bool is_peak = true;
+      float sum = 0.0;
+      int count = 0;
+
+      for(int other = std::max(0, hop - average_window); other <= std::min((int) number_of_hops - 1, hop + average_window); other++)
+      {
+        if(std::abs(other - hop) <= peak_window && novelty[other] > value) is_peak = false;
+        sum += novelty[other];
+        count++;
+      }
+
+      if(! is_peak || value < (sum / count) + threshold) continue;
+
+      onsets.push_back(locateOnset(difference, hop));
+      last_onset_hop = hop;
+    }
+  }
+
+  // The energy rose at _hop_, but the hit may have started anywhere in that
+  // hop or late in the one before.  It starts where the level (averaged over
+  // ENVELOPE frames) first gets halfway from the quietest point of the
+  // earlier hop, which may still hold the tail of an earlier hit, to the
+  // loudest point of the two.
+  static unsigned int locateOnset(const std::vector<float> &difference, unsigned int hop)
+  {
+    static const unsigned int ENVELOPE = 16;
+
+    unsigned int start = (hop - 1) * HOP;
+    unsigned int end = (hop + 1) * HOP;
+
+    float envelope[2 * HOP];
+    float sum = 0.0;
+    float loudest = 0.0;
+
+    for(unsigned int i = start; i < end; i++)
+    {
+      sum += std::fabs(difference[i]);
+      if(i >= start + ENVELOPE) sum -= std::fabs(difference[i - ENVELOPE]);
+
+      envelope[i - start] = sum;
+      loudest = std::max(loudest, sum);
+    }
+
+    float quietest = loudest;
+    for(unsigned int i = ENVELOPE; i < HOP; i++) quietest = std::min(quietest, envelope[i]);
+
+    // The envelope at each frame covers the ENVELOPE frames leading up to it
+    unsigned int offset = ENVELOPE;
+    while(offset < (2 * HOP) && envelope[offset] < (quietest + loudest) * 0.5f) offset++;
+
+    unsigned int onset = start + ((offset > ENVELOPE) ? offset - ENVELOPE : 0);
+
+    return((onset > PRE_ROLL) ? onset - PRE_ROLL : 0);
+  }
+
+  //
+  // Returns the onset closest to _position_ (in frames), or _position_
+  // itself if there's no onset within _range_ frames of it.  Doesn't
+  // allocate, so it may be called from the audio thread.
+  //
+  float snap(float position, float range) const
+  {
+    if(onsets.empty()) return(position);
+
+    std::vector<unsigned int>::const_iterator after = std::lower_bound(onsets.begin(), onsets.end(), (unsigned int) std::max(0.0f, position));
+
+    float closest = position;
+    float closest_distance = range;
+
+    if(after != onsets.end() && std::fabs(*after - position) <= closest_distance)
+    {
+      closest = *after;
+      closest_distance = std::fabs(*after - position);
+    }
+
+    if(after != onsets.begin() && std::fabs(*(after - 1) - position) <= closest_distance)
+    {
+      closest = *(after - 1);
+    }
+
+    return(closest);
+  }
+
+  void clear()
+  {
+    std::vector<unsigned int>().swap(onsets);
+  }
+
+  bool empty() const
+  {
+    return(onsets.empty());
+  }
+
+  void swap(SliceMap &other)
+  {
+    onsets.swap(other.onsets);
+  }
+
+  //
+  // Cache files
+  //
+
+  static std::string cachePath(const std::string &sample_path)
+  {
+    return(sample_path + ".slices");
+  }
+
+  // Loads the slice map saved for the sample at _sample_path_, which is
+  // _length_ frames long.  Returns false if there isn't one, or if the
+  // sample has changed since it was saved.
+  bool load(const std::string &sample_path, unsigned int length)
+  {
+    struct stat file_stats;
+    if(stat(sample_path.c_str(), &file_stats) != 0) return(false);
+
+    json_error_t error;
+    json_t *json_root = json_load_file(cachePath(sample_path).c_str(), 0, &error);
+    if(! json_root) return(false);
+
+    bool valid =
+      (json_integer_value(json_object_get(json_root, "version")) == VERSION) &&
+      (json_integer_value(json_object_get(json_root, "frames")) == length) &&
+      (json_integer_value(json_object_get(json_root, "file_size")) == (int64_t) file_stats.st_size) &&
+      (json_integer_value(json_object_get(json_root, "modified_time")) == fileModifiedTime(file_stats));
+
+    json_t *onsets_json = json_object_get(json_root, "onsets");
+    if(! json_is_array(onsets_json)) valid = false;
+
+    if(valid)
+    {
+      onsets.clear();
+
+      size_t index;
+      json_t *onset_json;
+      json_array_foreach(onsets_json, index, onset_json)
+      {
+        json_int_t onset = json_integer_value(onset_json);
+
+        // Anything out of order or out of range means that the file was
+        // edited by hand, or damaged
+        if(onset < 0 || onset >= length || (! onsets.empty() && onset <= onsets.back()))
+        {
+          valid = false;
+          break;
+        }
+
+        onsets.push_back(onset);
+      }
+
+      if(! valid) onsets.clear();
+    }
+
+    json_decref(json_root);
+    return(valid);
+  }
+
+  // Saves the slice map next to the sample at _sample_path_.  It's written to
+  // a temporary file first, so that a module loading the same sample at the
+  // same time never reads half a file.
+  bool save(const std::string &sample_path, unsigned int length)
+  {
+    struct stat file_stats;
+    if(stat(sample_path.c_str(), &file_stats) != 0) return(false);
+
+    json_t *json_root = json_object();
+    json_object_set_new(json_root, "version", json_integer(VERSION));
+    json_object_set_new(json_root, "frames", json_integer(length));
+    json_object_set_new(json_root, "file_size", json_integer(file_stats.st_size));
+    json_object_set_new(json_root, "modified_time", json_integer(fileModifiedTime(file_stats)));
+
+    json_t *onsets_json = json_array();
+    for(unsigned int onset : onsets) json_array_append_new(onsets_json, json_integer(onset));
+    json_object_set_new(json_root, "onsets", onsets_json);
+
+    std::string path = cachePath(sample_path);
+    std::string temporary_path = path + ".tmp" + std::to_string((uintptr_t) this);
+
+    bool saved = (json_dump_file(json_root, temporary_path.c_str(), JSON_COMPACT) == 0);
+    json_decref(json_root);
+
+    if(saved)
+    {
+      // Renaming over an existing file doesn't work on every platform
+      std::remove(path.c_str());
+      saved = (std::rename(temporary_path.c_str(), path.c_str()) == 0);
+    }
+
+    if(! saved) std::remove(temporary_path.c_str());
+
+    return(saved);
+  }
+};
@@ -0,0 +1,73 @@
+/*
+  SpscQueue.hpp
+
+  A fixed size, lock-free queue for passing items from exactly one producer
+  thread to exactly one consumer thread.  Neither side ever blocks, locks a
+  mutex, or allocates memory, so either side may be the audio thread.
+
+  The queue holds up to CAPACITY items, which must be a power of two.  push()
+  returns false when the queue is full, and pop() returns false when it's
+  empty.  Callers decide what to do in those cases (usually, try again on
+  the next frame).
+
+  pop() swaps the item out of the queue instead of copying it.  For items
+  which own memory, such as strings, this means that the consumer never
+  allocates when receiving an item.  Whatever the consumer passed in is left
+  in the queue, and is overwritten by a later push().
+*/
+
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+template <typename T, unsigned int CAPACITY>
+struct SpscQueue
+{
+  static_assert((CAPACITY & (CAPACITY - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+  T items[CAPACITY];
+
+  // Both counters only ever increase, and wrap around naturally.  The number
+  // of items in the queue is (tail - head).
+  std::atomic<unsigned int> head {0};   // Next item to pop.  Written by the consumer.
+  std::atomic<unsigned int> tail {0};   // Next slot to push.  Written by the producer.
+
+  // Called by the producer only
+  bool push(const T &item)
+  {
+    unsigned int current_tail = tail.load(std::memory_order_relaxed);
+
+    if(current_tail - head.load(std::memory_order_acquire) == CAPACITY) return(false);
+
+    items[current_tail & (CAPACITY - 1)] = item;
+    tail.store(current_tail + 1, std::memory_order_release);
+
+    return(true);
+  }
+
+  // Called by the consumer only
+  bool pop(T &item)
+  {
+    unsigned int current_head = head.load(std::memory_order_relaxed);
+
+    if(current_head == tail.load(std::memory_order_acquire)) return(false);
+
+    std::swap(item, items[current_head & (CAPACITY - 1)]);
+    head.store(current_head + 1, std::memory_order_release);
+
+    return(true);
+  }
+
+  // The number of items waiting.  Exact when called by the producer or the
+  // consumer while the other side is idle, and otherwise a snapshot.
+  unsigned int size()
+  {
+    return(tail.load(std::memory_order_acquire) - head.load(std::memory_order_acquire));
+  }
+
+  bool empty()
+  {
+    return(size() == 0);
+  }
+};
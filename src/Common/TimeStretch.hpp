@@ -0,0 +1,372 @@
+/*
+  TimeStretch.hpp
+
+  Plays a sample faster or slower without changing its pitch.  Autobreak and
+  Autobreak Studio use it to fit a drum loop to the incoming clock.
+
+  Those modules used to play the loop faster or slower like a record, so the
+  pitch followed the tempo, and frames were skipped or repeated, which
+  aliased.
+
+  TimeStretch uses WSOLA (waveform similarity overlap-add).  The output is
+  made of grains of the sample, each played at its original speed and
+  crossfaded into the next.  A new grain starts every HOP frames, at the
+  point in the sample that the module's playback position has reached, so
+  the loop as a whole keeps time with the clock.  Crossfading unrelated audio
+  would sound phasey, so each grain's start is moved, by up to TOLERANCE
+  frames, to wherever the audio best matches the continuation of the
+  previous grain.
+
+  Finding the best match is the expensive part, and is done in two steps:
+
+  1. A coarse search over the whole tolerance, using a TimeStretchAnalysis
+     of the sample.  This is a mono copy of the sample at a quarter of the
+     sample rate, built once when the sample is loaded, on the SampleLoader's
+     worker thread (see BreakbeatLoadRequest.hpp).
+
+  2. A fine search, at full resolution, of the few frames around the best
+     coarse match.
+
+  Together these cost about a hundred multiply-adds per output frame, so
+  several instances can run at once.  At the loop's original tempo, the
+  best match is always the previous grain's continuation, and the sample
+  plays back unchanged.
+
+  When the playback position jumps by more than TOLERANCE frames (to a new
+  slice, for example), or the module switches to a different sample, the
+  next grain starts exactly where it's asked to, so that drum hits land on
+  the clock.  The grain which was playing carries on for a few milliseconds
+  and is crossfaded into it, the same way SliceCrossfade does when time
+  stretching is turned off (see SliceCrossfade.hpp).
+*/
+
+#pragma once
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "SliceCrossfade.hpp"
+
+struct TimeStretchAnalysis
+{
+  static const unsigned int DECIMATION = 4;
+
+  // The average of both channels over each block of DECIMATION frames
+  std::vector<float> signal;
+
+  // Builds the analysis for _length_ frames.  read_frame(index, &left, &right)
+  // is called once for each frame, in order.
+  template <typename FrameReader>
+  void build(unsigned int length, FrameReader read_frame)
+  {
+    signal.assign(length / DECIMATION, 0.0);
+
+    for(unsigned int block = 0; block < signal.size(); block++)
+    {
+      float sum = 0.0;
+
+      for(unsigned int i = 0; i < DECIMATION; i++)
+      {
+        float left, right;
+        read_frame((block * DECIMATION) + i, &left, &right);
+        sum += left + right;
+      }
+
+      signal[block] = sum / (DECIMATION * 2);
+    }
+  }
+
+  void clear()
+  {
+    std::vector<float>().swap(signal);
+  }
+
+  bool empty() const
+  {
+    return(signal.empty());
+  }
+
+  void swap(TimeStretchAnalysis &other)
+  {
+    signal.swap(other.signal);
+  }
+};
+
+struct TimeStretch
+{
+  static const int HOP = 512;         // Frames between grains.  Each grain is two hops long.
+  static const int TOLERANCE = 256;   // How far a grain's start may be moved, in frames
+
+  static const int DECIMATION = TimeStretchAnalysis::DECIMATION;
+  static const int COARSE_LENGTH = HOP / DECIMATION;
+  static const int COARSE_CANDIDATES = ((2 * TOLERANCE) / DECIMATION) + 1;
+  static const int FINE_RANGE = DECIMATION - 1;
+
+  struct Grain
+  {
+    Sample *sample = NULL;
+    int position = 0;   // The next frame to play
+    int direction = 1;
+  };
+
+  Grain fading_in;    // The newest grain
+  Grain fading_out;   // The previous grain, while it fades out
+  bool playing = false;
+  bool jump_requested = false;
+  int phase = 0;      // Frames since fading_in started
+  double last_position = 0.0;
+
+  // The crossfade from fading_out to fading_in, which lasts _fade_length_
+  // frames.  When fade_phase reaches fade_length, only fading_in is played.
+  const float *fade_in_gains = NULL;
+  const float *fade_out_gains = NULL;
+  int fade_length = 0;
+  int fade_phase = 0;
+
+  // Gains for the crossfade between one grain and the next, over a hop.
+  // The search makes sure that the two grains play matching audio, so
+  // their gains add up to one.
+  float hop_fade_in[HOP];
+  float hop_fade_out[HOP];
+
+  // Gains for the shorter crossfade after a jump, between unrelated audio
+  EqualPowerFade jump_fade;
+
+  // Scratch space for the search, so that it doesn't allocate
+  float coarse_reference[COARSE_LENGTH];
+  float coarse_window[COARSE_LENGTH + COARSE_CANDIDATES];
+  float fine_reference[HOP];
+  float fine_window[HOP + (2 * FINE_RANGE)];
+
+  TimeStretch()
+  {
+    for(int i = 0; i < HOP; i++)
+    {
+      float x = std::sin((M_PI / 2.0) * ((float) i / HOP));
+      hop_fade_in[i] = x * x;
+      hop_fade_out[i] = 1.0f - (x * x);
+    }
+  }
+
+  // The next frame starts a new grain at full volume, without a crossfade
+  void reset()
+  {
+    playing = false;
+  }
+
+  // The next frame starts a new grain, crossfaded from the current one, even
+  // if the position hasn't jumped
+  void jump()
+  {
+    jump_requested = true;
+  }
+
+  //
+  // Renders one frame.  _position_ is where the module would be reading
+  // _sample_ without time stretching, and moves forward (or backward, when
+  // _direction_ is -1) at whatever speed fits the tempo.  _analysis_ may be
+  // NULL or empty, in which case only the fine search is done.
+  //
+  void process(Sample *sample, const TimeStretchAnalysis *analysis, double position, int direction, float *left, float *right)
+  {
+    int length = sample->size();
+
+    if(length == 0)
+    {
+      *left = 0;
+      *right = 0;
+      return;
+    }
+
+    bool jumped = jump_requested || (sample != fading_in.sample) || (std::abs(position - last_position) > TOLERANCE);
+    jump_requested = false;
+    last_position = position;
+
+    if(! playing)
+    {
+      startGrain(sample, std::floor(position), direction);
+      fade_length = 0;
+      fade_phase = 0;
+      playing = true;
+    }
+    else if(jumped)
+    {
+      // If the last jump is still fading in, whichever grain is louder at
+      // this moment is the one which fades out
+      if(fade_phase == fade_length || fade_in_gains[fade_phase] >= fade_out_gains[fade_phase]) fading_out = fading_in;
+
+      startGrain(sample, std::floor(position), direction);
+      startFade(jump_fade.fade_in, jump_fade.fade_out, EqualPowerFade::LENGTH);
+    }
+    else if(phase == HOP)
+    {
+      fading_out = fading_in;
+
+      startGrain(sample, findGrainStart(sample, analysis, std::floor(position), direction), direction);
+      startFade(hop_fade_in, hop_fade_out, HOP);
+    }
+
+    if(fade_phase < fade_length)
+    {
+      SliceCrossfade::mixVoices(
+        fading_in.sample, wrap(fading_in.position, fading_in.sample->size()), fade_in_gains[fade_phase],
+        fading_out.sample, wrap(fading_out.position, fading_out.sample->size()), fade_out_gains[fade_phase],
+        left, right);
+
+      fading_out.position += fading_out.direction;
+      fade_phase++;
+    }
+    else
+    {
+      fading_in.sample->read(wrap(fading_in.position, fading_in.sample->size()), left, right);
+    }
+
+    fading_in.position += fading_in.direction;
+    phase++;
+  }
+
+  void startGrain(Sample *sample, int start, int direction)
+  {
+    fading_in.sample = sample;
+    fading_in.position = start;
+    fading_in.direction = direction;
+    phase = 0;
+  }
+
+  void startFade(const float *fade_in, const float *fade_out, int length)
+  {
+    fade_in_gains = fade_in;
+    fade_out_gains = fade_out;
+    fade_length = length;
+    fade_phase = 0;
+  }
+
+  // Grains which run past either end of the sample wrap around, as the
+  // samples are loops
+  static int wrap(int index, int length)
+  {
+    return(SliceCrossfade::wrap(index, length));
+  }
+
+  float readMono(Sample *sample, int index)
+  {
+    float left, right;
+    sample->read(wrap(index, sample->size()), &left, &right);
+    return((left + right) * 0.5f);
+  }
+
+  //
+  // Returns where the next grain should start: the position within
+  // TOLERANCE frames of _target_ where the audio best matches what the
+  // grain which is about to fade out will play next.
+  //
+  int findGrainStart(Sample *sample, const TimeStretchAnalysis *analysis, int target, int direction)
+  {
+    // Matching audio played in opposite directions doesn't mean much
+    if(direction != fading_in.direction) return(target);
+
+    // fading_in has played for a hop, so it's now at the continuation
+    int continuation = fading_in.position;
+
+    // Both grains are compared over the hop during which they overlap.  When
+    // playing in reverse, that's the hop which ends at the grain's start.
+    int block_offset = (direction > 0) ? 0 : -(HOP - 1);
+    int reference_start = continuation + block_offset;
+
+    int best_start = target;
+
+    if(analysis && ! analysis->empty())
+    {
+      best_start = coarseSearch(analysis, reference_start, target + block_offset) - block_offset;
+    }
+
+    return(fineSearch(sample, reference_start, best_start + block_offset) - block_offset);
+  }
+
+  // Searches the analysis for the block which best matches the one at
+  // _reference_start_, within TOLERANCE frames of _target_start_.  Returns
+  // the start of the best match in frames.
+  int coarseSearch(const TimeStretchAnalysis *analysis, int reference_start, int target_start)
+  {
+    const std::vector<float> &signal = analysis->signal;
+    int analysis_length = signal.size();
+
+    // Candidates are whole blocks apart, and are aligned with the reference
+    // so that the continuation itself is one of them
+    int reference_block = floorDivide(reference_start, DECIMATION);
+    int alignment = reference_start - (reference_block * DECIMATION);
+    int first_block = floorDivide(target_start - TOLERANCE - alignment + (DECIMATION - 1), DECIMATION);
+
+    for(int i = 0; i < COARSE_LENGTH; i++)
+    {
+      coarse_reference[i] = signal[wrap(reference_block + i, analysis_length)];
+    }
+
+    for(int i = 0; i < COARSE_LENGTH + COARSE_CANDIDATES; i++)
+    {
+      coarse_window[i] = signal[wrap(first_block + i, analysis_length)];
+    }
+
+    int best_candidate = bestMatch(coarse_reference, coarse_window, COARSE_LENGTH, COARSE_CANDIDATES);
+
+    return(((first_block + best_candidate) * DECIMATION) + alignment);
+  }
+
+  // Searches the sample itself, within FINE_RANGE frames of _start_
+  int fineSearch(Sample *sample, int reference_start, int start)
+  {
+    for(int i = 0; i < HOP; i++)
+    {
+      fine_reference[i] = readMono(sample, reference_start + i);
+    }
+
+    for(int i = 0; i < HOP + (2 * FINE_RANGE); i++)
+    {
+      fine_window[i] = readMono(sample, start - FINE_RANGE + i);
+    }
+
+    return(start - FINE_RANGE + bestMatch(fine_reference, fine_window, HOP, (2 * FINE_RANGE) + 1));
+  }
+
+  // Returns the offset into _window_ where _reference_ fits best, using
+  // cross-correlation normalized by the energy of each candidate, so that
+  // louder parts of the sample aren't favoured.
+  static int bestMatch(const float *reference, const float *window, int length, int candidates)
+  {
+    int best_candidate = candidates / 2;
+    float best_score = 0.0;
+
+    for(int candidate = 0; candidate < candidates; candidate++)
+    {
+      const float *block = window + candidate;
+      float correlation = 0.0;
+      float energy = 0.0;
+
+      for(int i = 0; i < length; i++)
+      {
+        correlation += reference[i] * block[i];
+        energy += block[i] * block[i];
+      }
+
+      if(correlation <= 0.0) continue;
+
+      float score = correlation / std::sqrt(energy + 1e-9f);
+
+      if(score > best_score)
+      {
+        best_score = score;
+        best_candidate = candidate;
+      }
+    }
+
+    return(best_candidate);
+  }
+
+  static int floorDivide(int numerator, int denominator)
+  {
+    int quotient = numerator / denominator;
+    if((numerator % denominator != 0) && (numerator < 0)) quotient--;
+    return(quotient);
+  }
+};
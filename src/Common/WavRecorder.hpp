@@ -0,0 +1,375 @@
+/*
+  WavRecorder.hpp
+
+  Records stereo audio to a .wav file without touching the disk, or the
+  memory allocator, on the audio thread.
+
+  How it works:
+
+  1. All of the memory needed for recording is allocated up front, as
+     NUMBER_OF_CHUNKS chunks of CHUNK_FRAMES stereo frames each.
+
+  2. On the audio thread, record() copies each frame into the current chunk.
+     When the chunk is full, it's handed to the writer thread through a
+     lock-free queue (see SpscQueue.hpp), and an empty chunk is taken from
+     a second queue going the other way.
+
+  3. The writer thread streams each chunk to a temporary file as it arrives,
+     then hands the chunk back.  Only a few seconds of audio are ever held
+     in memory, however long the recording is.
+
+  4. stop() queues the rest of the current chunk, followed by the name of the
+     file to save.  The writer fills in the header of the temporary file and
+     renames it.  Only then is the recording reported as finished through
+     takeFinished(), so whoever loads the file never sees it half written.
+
+  5. The writer also asks the SampleLoader to load the finished file (see
+     SampleLoader.hpp), and reports the request rather than the path, so
+     that the module which plays the recording never has to submit a
+     request, and allocate memory, on the audio thread.  Whoever takes the
+     recording owns the request, and must post it to a LoadSlot or release
+     it.
+
+  If the writer falls far enough behind that no empty chunks are left, the
+  audio is dropped (and counted in dropped_frames) rather than making the
+  audio thread wait.
+
+  Files are saved as 16 bit PCM at the sample rate passed to start(), with
+  samples clamped to the range -1 to 1, like AudioFile.h does.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "SampleLoader.hpp"
+#include "SpscQueue.hpp"
+
+struct WavRecorder
+{
+  static const unsigned int CHUNK_FRAMES = 2048;
+  static const unsigned int NUMBER_OF_CHUNKS = 64;     // About three seconds at 44.1 kHz
+  static const unsigned int EVENT_QUEUE_SIZE = 128;    // Must hold every chunk, plus a start and stop
+  static const unsigned int FILENAME_LENGTH = 128;
+  static const unsigned int WAV_HEADER_SIZE = 44;
+
+  enum EventTypes
+  {
+    START,
+    AUDIO,
+    STOP
+  };
+
+  // Sent from the audio thread to the writer
+  struct Event
+  {
+    int type = AUDIO;
+    unsigned int chunk = 0;
+    unsigned int frames = 0;
+    unsigned int sample_rate = 0;
+    unsigned int tag = 0;
+    char filename[FILENAME_LENGTH] = {};
+  };
+
+  // Sent from the writer back to the audio thread once a file is complete
+  struct Recording
+  {
+    unsigned int tag = 0;
+    SampleLoadRequest *request = NULL;
+  };
+
+  std::string directory;
+  std::vector<float> chunks;
+
+  SpscQueue<Event, EVENT_QUEUE_SIZE> events;
+  SpscQueue<unsigned int, EVENT_QUEUE_SIZE> empty_chunks;
+  SpscQueue<Recording, 8> finished_recordings;
+
+  std::atomic<unsigned int> dropped_frames {0};
+
+  // Only used on the audio thread
+  bool recording = false;
+  bool has_chunk = false;
+  unsigned int current_chunk = 0;
+  unsigned int current_chunk_frames = 0;
+
+  // Only used on the writer thread
+  FILE *file = NULL;
+  std::string temporary_path = "";
+  uint32_t frames_written = 0;
+  unsigned int sample_rate = 44100;
+  std::vector<uint8_t> write_buffer;
+
+  std::thread writer;
+  std::mutex mutex;
+  std::condition_variable condition;
+  bool running = true;
+
+  // Recordings are saved in _directory_, which should already exist
+  WavRecorder(std::string directory)
+  {
+    this->directory = directory;
+
+    chunks.assign(NUMBER_OF_CHUNKS * CHUNK_FRAMES * 2, 0.0f);
+    for(unsigned int i = 0; i < NUMBER_OF_CHUNKS; i++) empty_chunks.push(i);
+
+    write_buffer.resize(CHUNK_FRAMES * 4);
+
+    writer = std::thread(&WavRecorder::run, this);
+  }
+
+  ~WavRecorder()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      running = false;
+    }
+
+    condition.notify_one();
+    writer.join();
+
+    // Nobody is left to take these
+    Recording recording;
+    while(finished_recordings.pop(recording)) recording.request->release();
+
+    // A recording which was never stopped isn't kept
+    if(file)
+    {
+      std::fclose(file);
+      std::remove(temporary_path.c_str());
+    }
+  }
+
+  //
+  // Audio thread
+  //
+
+  void start(unsigned int sample_rate)
+  {
+    if(recording) return;
+
+    // Only start if there's room in the queue for every chunk of this
+    // recording, as well as the stop event, so that stop() can't fail.
+    if(events.size() > EVENT_QUEUE_SIZE - NUMBER_OF_CHUNKS - 2) return;
+
+    Event event;
+    event.type = START;
+    event.sample_rate = sample_rate;
+    events.push(event);
+
+    recording = true;
+  }
+
+  void record(float left, float right)
+  {
+    if(! recording) return;
+
+    if(! has_chunk)
+    {
+      if(! empty_chunks.pop(current_chunk))
+      {
+        dropped_frames++;
+        return;
+      }
+
+      has_chunk = true;
+      current_chunk_frames = 0;
+    }
+
+    float *frame = &chunks[(((std::size_t) current_chunk * CHUNK_FRAMES) + current_chunk_frames) * 2];
+    frame[0] = left;
+    frame[1] = right;
+
+    current_chunk_frames++;
+
+    if(current_chunk_frames == CHUNK_FRAMES) sendChunk();
+  }
+
+  // Finishes the recording and saves it as _filename_ (in the directory
+  // passed to the constructor).  _tag_ is passed back with the finished
+  // recording, for the caller's own use.
+  void stop(const char *filename, unsigned int tag = 0)
+  {
+    if(! recording) return;
+
+    if(has_chunk) sendChunk();
+
+    Event event;
+    event.type = STOP;
+    event.tag = tag;
+    std::strncpy(event.filename, filename, FILENAME_LENGTH - 1);
+    events.push(event);
+
+    recording = false;
+  }
+
+  bool isRecording()
+  {
+    return(recording);
+  }
+
+  // Returns true, and fills in _recording_, when a recording has been saved
+  bool takeFinished(Recording &recording)
+  {
+    return(finished_recordings.pop(recording));
+  }
+
+  void sendChunk()
+  {
+    Event event;
+    event.type = AUDIO;
+    event.chunk = current_chunk;
+    event.frames = current_chunk_frames;
+    events.push(event);
+
+    has_chunk = false;
+  }
+
+  //
+  // Writer thread
+  //
+
+  void run()
+  {
+    bool keep_running = true;
+
+    while(keep_running)
+    {
+      // The audio thread doesn't wake the writer, as that could block.  It's
+      // enough to check every few milliseconds, as there's room for seconds
+      // of audio in the chunks.
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait_for(lock, std::chrono::milliseconds(10), [this] { return(! running); });
+        keep_running = running;
+      }
+
+      // This runs once more after the recorder is destroyed, so that a
+      // recording which was stopped just before is still saved
+      Event event;
+      while(events.pop(event)) handle(event);
+    }
+  }
+
+  void handle(Event &event)
+  {
+    if(event.type == START)
+    {
+      // A recording which was never stopped is abandoned
+      if(file)
+      {
+        std::fclose(file);
+        std::remove(temporary_path.c_str());
+      }
+
+      sample_rate = event.sample_rate;
+      frames_written = 0;
+
+      // Each recorder writes to its own temporary file
+      temporary_path = directory + "/recording_" + std::to_string((uintptr_t) this) + ".tmp";
+      file = std::fopen(temporary_path.c_str(), "wb");
+
+      if(file) writeHeader();
+    }
+    else if(event.type == AUDIO)
+    {
+      if(file) writeChunk(event.chunk, event.frames);
+      empty_chunks.push(event.chunk);
+    }
+    else if(event.type == STOP)
+    {
+      if(! file) return;
+
+      // Now that the length is known, fill in the header
+      writeHeader();
+      std::fclose(file);
+      file = NULL;
+
+      std::string filename = event.filename;
+      std::string path_to_file = directory + "/" + filename;
+
+      // Renaming over an existing file doesn't work on every platform
+      std::remove(path_to_file.c_str());
+
+      if(std::rename(temporary_path.c_str(), path_to_file.c_str()) == 0)
+      {
+        Recording recording;
+        recording.tag = event.tag;
+        recording.request = SampleLoader::instance().request(path_to_file);
+
+        if(! finished_recordings.push(recording)) recording.request->release();
+      }
+    }
+  }
+
+  void writeChunk(unsigned int chunk, unsigned int frames)
+  {
+    const float *audio = &chunks[(std::size_t) chunk * CHUNK_FRAMES * 2];
+    uint8_t *bytes = write_buffer.data();
+
+    for(unsigned int i = 0; i < frames * 2; i++)
+    {
+      float sample = std::max(-1.0f, std::min(1.0f, audio[i]));
+      int16_t value = (int16_t) (sample * 32767.0f);
+
+      bytes[(i * 2)] = value & 0xFF;
+      bytes[(i * 2) + 1] = (value >> 8) & 0xFF;
+    }
+
+    std::fwrite(bytes, 1, frames * 4, file);
+    frames_written += frames;
+  }
+
+  // Writes the header at the start of the file.  It's written once with a
+  // length of zero when the recording starts, and again when it stops.
+  void writeHeader()
+  {
+    uint32_t data_size = frames_written * 4;
+    uint8_t header[WAV_HEADER_SIZE];
+
+    std::memcpy(header, "RIFF", 4);
+    putInt32(header + 4, 36 + data_size);
+    std::memcpy(header + 8, "WAVE", 4);
+    std::memcpy(header + 12, "fmt ", 4);
+    putInt32(header + 16, 16);                // Format chunk size
+    putInt16(header + 20, 1);                 // PCM
+    putInt16(header + 22, 2);                 // Channels
+    putInt32(header + 24, sample_rate);
+    putInt32(header + 28, sample_rate * 4);   // Bytes per second
+    putInt16(header + 32, 4);                 // Bytes per frame
+    putInt16(header + 34, 16);                // Bits per sample
+    std::memcpy(header + 36, "data", 4);
+    putInt32(header + 40, data_size);
+
+    long position = std::ftell(file);
+
+    std::fseek(file, 0, SEEK_SET);
+    std::fwrite(header, 1, WAV_HEADER_SIZE, file);
+
+    if(position > (long) WAV_HEADER_SIZE) std::fseek(file, position, SEEK_SET);
+  }
+
+  static void putInt16(uint8_t *destination, uint16_t value)
+  {
+    destination[0] = value & 0xFF;
+    destination[1] = (value >> 8) & 0xFF;
+  }
+
+  static void putInt32(uint8_t *destination, uint32_t value)
+  {
+    destination[0] = value & 0xFF;
+    destination[1] = (value >> 8) & 0xFF;
+    destination[2] = (value >> 16) & 0xFF;
+    destination[3] = (value >> 24) & 0xFF;
+  }
+};
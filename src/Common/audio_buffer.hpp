@@ -1,56 +1,99 @@
 #pragma once
 
-#define MAX_BUFFER_SIZE 176400
+#include <vector>
+
+//
+// AudioBuffer
+//
+// The last few seconds of incoming stereo audio, for effects such as GrainFx
+// which play back grains from it.  Positions passed to getStereoOutput()
+// range from 0 (the oldest audio, getBufferSize() frames ago) up to
+// getBufferSize() - 1 (the newest).
+//
+// The buffer holds exactly BUFFER_SECONDS of audio at the sample rate given
+// to setSampleRate(), and wraps with a compare and subtract rather than a
+// mask, so it's no larger than it needs to be.  Nothing is allocated until
+// setSampleRate() is called, from the module's constructor with the engine's
+// sample rate, and from onSampleRateChange().  push() never allocates.
+//
 
 struct AudioBuffer
 {
-  int read_head = 0;
-  int write_head = 0;
+  static constexpr float BUFFER_SECONDS = 4.0;
+
+  unsigned int write_head = 0;
+  unsigned int read_head = 0;
+  unsigned int buffer_size = 0;
 
-	float leftPlayBuffer[MAX_BUFFER_SIZE];
-	float rightPlayBuffer[MAX_BUFFER_SIZE];
+  std::vector<float> left_buffer;
+  std::vector<float> right_buffer;
   bool frozen = false;
-  int sample_position = 0;
 
 	AudioBuffer()
 	{
-    for(unsigned int i=0; i<MAX_BUFFER_SIZE; i++)
-    {
-      leftPlayBuffer[i] = 0.0;
-      rightPlayBuffer[i] = 0.0;
-    }
 	}
 
 	virtual ~AudioBuffer() {}
 
 	virtual void push(float left_audio, float right_audio)
 	{
-    write_head++;
-    if(write_head >= MAX_BUFFER_SIZE) write_head = 0;
+    if(buffer_size == 0) return;
 
-    // I was fiddling this to see if I could get faster response time, but
-    // there's something fundamental that I think is keeping me from being
-    // able to get instant output.
-    //
-    // read_head = (write_head - 4000) % MAX_BUFFER_SIZE;
-
-    read_head = write_head;
+    write_head++;
+    if(write_head >= buffer_size) write_head -= buffer_size;
 
+    // While frozen, the write head keeps moving without writing, so the
+    // buffer loops over the same buffer_size frames
     if(! frozen)
     {
-      leftPlayBuffer[write_head] = left_audio;
-      rightPlayBuffer[write_head] = right_audio;
+      left_buffer[write_head] = left_audio;
+      right_buffer[write_head] = right_audio;
     }
+
+    // Position 0 is the oldest frame, just after the one written
+    read_head = write_head + 1;
+    if(read_head >= buffer_size) read_head -= buffer_size;
 	};
 
+  // _sample_position_ must be less than getBufferSize()
   std::pair<float, float> getStereoOutput(unsigned int sample_position)
   {
-    unsigned int index = (sample_position + read_head) % MAX_BUFFER_SIZE;
-    return {leftPlayBuffer[index], rightPlayBuffer[index]};
+    unsigned int index = read_head + sample_position;
+    if(index >= buffer_size) index -= buffer_size;
+
+    return {left_buffer[index], right_buffer[index]};
+  }
+
+  // Reads the frames at _frames_ positions at once, such as one for each of
+  // a group of grains.  Positions are the same as getStereoOutput().
+  void getStereoBlock(const double *sample_positions, unsigned int frames, float *left, float *right)
+  {
+    for(unsigned int i = 0; i < frames; i++)
+    {
+      unsigned int index = read_head + (unsigned int) sample_positions[i];
+      if(index >= buffer_size) index -= buffer_size;
+
+      left[i] = left_buffer[index];
+      right[i] = right_buffer[index];
+    }
+  }
+
+  // If the size changes, the buffers are allocated again, empty.
+  void setSampleRate(float sample_rate)
+  {
+    unsigned int new_buffer_size = sample_rate * BUFFER_SECONDS;
+    if(new_buffer_size == buffer_size) return;
+
+    std::vector<float>(new_buffer_size, 0.0f).swap(left_buffer);
+    std::vector<float>(new_buffer_size, 0.0f).swap(right_buffer);
+
+    buffer_size = new_buffer_size;
+    write_head = 0;
+    read_head = 0;
   }
 
   unsigned int getBufferSize()
   {
-    return(MAX_BUFFER_SIZE);
+    return(buffer_size);
   }
 };
@@ -1,7 +1,11 @@
 #pragma once
 
+#include "dsp/Random.hpp"
+
 struct Common
 {
+  Random random;
+
   float rescaleWithPadding(float t, float src_low, float src_high, float dst_low, float dst_high, float padding_at_start, float padding_at_end)
   {
     return (rescale(t, src_low, src_high, (dst_low + padding_at_start), (dst_high - padding_at_end)));
@@ -11,8 +15,7 @@ struct Common
   // From there, you can use rescale to map to a more useful range
   float randomFloat(float min, float max)
   {
-    float r = (float)rand() / (float)RAND_MAX;
-    return (min + r * (max - min));
+    return (random.uniform(min, max));
   }
 
   float CONTOURS[10][512] =
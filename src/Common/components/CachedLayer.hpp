@@ -0,0 +1,58 @@
+//
+// CachedLayer
+//
+// Keeps what a display draws in a framebuffer, so that it's only drawn again
+// when something it shows has changed.  Without this, displays such as the
+// sequencers redraw every bar or cell on every frame, which adds up when a
+// patch has many modules on screen.
+//
+// The display passes a function which draws the cached content, and calls
+// drawCached() from its own draw() or drawLayer() wherever the content should
+// appear.  Overlays which change often, like tooltips, are drawn by the
+// display as usual after calling drawCached().  When the display sees that
+// its model has changed (usually in step()), it calls setDirty() and the
+// content is drawn again on the next frame.
+//
+// Rack's FramebufferWidget only draws on the default layer.  The displays
+// draw on layer 1, above the "room brightness" dimming, so the framebuffer
+// isn't drawn automatically.  It is only drawn through drawCached().
+//
+
+struct CachedLayer : widget::FramebufferWidget
+{
+  struct Content : widget::Widget
+  {
+    std::function<void(NVGcontext *vg)> draw_function;
+
+    void draw(const DrawArgs &args) override
+    {
+      if(draw_function) draw_function(args.vg);
+    }
+  };
+
+  Content *content;
+
+  CachedLayer(Vec size, std::function<void(NVGcontext *vg)> draw_function)
+  {
+    box.size = size;
+
+    content = new Content();
+    content->box.size = size;
+    content->draw_function = draw_function;
+    addChild(content);
+  }
+
+  void drawCached(const DrawArgs &args)
+  {
+    FramebufferWidget::draw(args);
+  }
+
+  // The owner decides where the framebuffer is drawn, using drawCached()
+  void draw(const DrawArgs &args) override
+  {
+  }
+
+  void drawLayer(const DrawArgs &args, int layer) override
+  {
+  }
+};
@@ -0,0 +1,79 @@
+//
+// DspProfilerMenu
+//
+// A context menu readout for a module's DspProfiler (see Common/DspProfiler.hpp).
+// The numbers are a snapshot taken when the menu is opened.  Reopen the menu
+// to refresh them.
+//
+
+struct DspProfilerMenuItem : MenuItem
+{
+  DspProfiler *profiler;
+
+  struct EnableOption : MenuItem
+  {
+    DspProfiler *profiler;
+
+    void onAction(const event::Action &e) override
+    {
+      profiler->setEnabled(! profiler->isEnabled());
+    }
+  };
+
+  struct ResetOption : MenuItem
+  {
+    DspProfiler *profiler;
+
+    void onAction(const event::Action &e) override
+    {
+      profiler->reset();
+    }
+  };
+
+  struct SaveReportOption : MenuItem
+  {
+    DspProfiler *profiler;
+
+    void onAction(const event::Action &e) override
+    {
+      char *path_char_pointer = osdialog_file(OSDIALOG_SAVE, NULL, "dsp_profile.txt", NULL);
+      if (! path_char_pointer) return;
+
+      std::string path = path_char_pointer;
+      std::free(path_char_pointer);
+
+      profiler->dump(path);
+    }
+  };
+
+  Menu *createChildMenu() override
+  {
+    Menu *menu = new Menu;
+
+    EnableOption *enable_option = createMenuItem<EnableOption>("Enable profiling", CHECKMARK(profiler->isEnabled()));
+    enable_option->profiler = profiler;
+    menu->addChild(enable_option);
+
+    if (profiler->isEnabled())
+    {
+      menu->addChild(new MenuSeparator());
+
+      for (unsigned int i = 0; i < profiler->number_of_stages; i++)
+      {
+        menu->addChild(createMenuLabel(profiler->describeStage(i)));
+      }
+
+      menu->addChild(new MenuSeparator());
+
+      ResetOption *reset_option = createMenuItem<ResetOption>("Reset");
+      reset_option->profiler = profiler;
+      menu->addChild(reset_option);
+
+      SaveReportOption *save_report_option = createMenuItem<SaveReportOption>("Save report...");
+      save_report_option->profiler = profiler;
+      menu->addChild(save_report_option);
+    }
+
+    return menu;
+  }
+};
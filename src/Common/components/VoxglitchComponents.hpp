@@ -18,6 +18,7 @@
 #include "VoxglitchScrews.hpp"
 #include "VoxglitchSwitches.hpp"
 #include "VoxglitchWidget.hpp"
+#include "CachedLayer.hpp"
 
 // =========================================
 #endif
@@ -4,6 +4,10 @@ struct VoxglitchSamplerModule : VoxglitchModule
   float sample_rate = 44100;
   std::string samples_root_dir = "";
 
+  // Read-ahead for disk streaming in milliseconds, or zero when streaming is
+  // off.  Only modules that support streaming (Looper and WavBank) use this.
+  unsigned int stream_read_ahead_ms = 0;
+
   VoxglitchSamplerModule()
   {
     // required.  This ensures that the base class constructor is called
@@ -66,6 +70,13 @@ struct VoxglitchSamplerModule : VoxglitchModule
   }
 #endif
 
+  // Modules which support streaming override this to apply the new setting
+  // to their sample players.
+  virtual void setStreamReadAhead(unsigned int stream_read_ahead_ms)
+  {
+    this->stream_read_ahead_ms = stream_read_ahead_ms;
+  }
+
   void setSamplesRootDirectory(std::string samples_root_directory)
   {
     this->samples_root_dir = samples_root_directory;
@@ -33,4 +33,39 @@ struct VoxglitchSamplerModuleWidget : VoxglitchModuleWidget
       return menu;
     }
   };
+
+  struct StreamReadAheadOption : MenuItem {
+    VoxglitchSamplerModule *module;
+    unsigned int stream_read_ahead_ms = 0;
+
+    void onAction(const event::Action &e) override {
+      module->setStreamReadAhead(stream_read_ahead_ms);
+    }
+  };
+
+  struct DiskStreamingMenuItem : MenuItem {
+    VoxglitchSamplerModule *module;
+
+    Menu *createChildMenu() override {
+      Menu *menu = new Menu;
+
+      StreamReadAheadOption *off_option = createMenuItem<StreamReadAheadOption>("Off", CHECKMARK(module->stream_read_ahead_ms == 0));
+      off_option->module = module;
+      menu->addChild(off_option);
+
+      menu->addChild(createMenuLabel("Read-ahead for large files"));
+
+      unsigned int read_ahead_options[] = { 250, 500, 1000, 2000 };
+
+      for(unsigned int read_ahead_ms : read_ahead_options)
+      {
+        StreamReadAheadOption *option = createMenuItem<StreamReadAheadOption>(std::to_string(read_ahead_ms) + " ms", CHECKMARK(module->stream_read_ahead_ms == read_ahead_ms));
+        option->module = module;
+        option->stream_read_ahead_ms = read_ahead_ms;
+        menu->addChild(option);
+      }
+
+      return menu;
+    }
+  };
 };
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+//
+// DelayLine
+//
+// A mono ring buffer for delays and other effects which read back recent
+// audio.  The buffer is rounded up to a power of two in length, so wrapping
+// an index is a mask instead of a modulo.
+//
+// The buffer is allocated by setCapacity(), and never by write() or read(),
+// so they are safe on the audio thread.  Call setCapacity() from the module's
+// constructor and from onSampleRateChange(), not from process().  Until it has
+// been called, writes are ignored and reads return 0.
+//
+
+struct DelayLine
+{
+  std::vector<float> buffer;
+  unsigned int capacity = 1;     // Requested length, in samples
+  unsigned int mask = 0;
+  unsigned int write_index = 0;
+
+  // Allocates a silent buffer of at least _new_capacity_ samples.  The
+  // existing buffer, and the audio in it, is kept if it's already that size.
+  void setCapacity(unsigned int new_capacity)
+  {
+    capacity = std::max(new_capacity, 1u);
+
+    unsigned int size = 1;
+    while (size < capacity) size <<= 1;
+
+    if (buffer.size() == size) return;
+
+    std::vector<float>(size, 0.0f).swap(buffer);
+    mask = size - 1;
+    write_index = 0;
+  }
+
+  bool isAllocated()
+  {
+    return (! buffer.empty());
+  }
+
+  // Length of the allocated buffer, which may be longer than the capacity.
+  unsigned int size()
+  {
+    return (buffer.size());
+  }
+
+  void write(float value)
+  {
+    if (buffer.empty()) return;
+
+    write_index = (write_index + 1) & mask;
+    buffer[write_index] = value;
+  }
+
+  // Returns the sample written _delay_ writes ago.  read(0) is the most
+  // recent sample.
+  float read(unsigned int delay)
+  {
+    if (buffer.empty()) return (0.0f);
+    return (buffer[(write_index - delay) & mask]);
+  }
+
+  // Reads between samples with 4-point Hermite interpolation, so that the
+  // delay can be swept smoothly.  The delay is clamped to the range that has
+  // all four neighbouring samples available.
+  float readInterpolated(float delay)
+  {
+    if (buffer.empty()) return (0.0f);
+
+    delay = std::min(std::max(delay, 1.0f), (float) (mask - 2));
+
+    unsigned int whole = (unsigned int) delay;
+    float fraction = delay - whole;
+
+    if (fraction == 0.0f) return (buffer[(write_index - whole) & mask]);
+
+    // Sample y0 is the newer neighbour and y1 the older one, so moving from
+    // y0 towards y1 increases the delay.
+    float y_minus_1 = buffer[(write_index - whole + 1) & mask];
+    float y0 = buffer[(write_index - whole) & mask];
+    float y1 = buffer[(write_index - whole - 1) & mask];
+    float y2 = buffer[(write_index - whole - 2) & mask];
+
+    float c1 = 0.5f * (y1 - y_minus_1);
+    float c2 = y_minus_1 - (2.5f * y0) + (2.0f * y1) - (0.5f * y2);
+    float c3 = (0.5f * (y2 - y_minus_1)) + (1.5f * (y0 - y1));
+
+    return (((((c3 * fraction) + c2) * fraction) + c1) * fraction + y0);
+  }
+
+  // Direct access to a position in the buffer, for effects which index the
+  // buffer themselves instead of reading relative to the write position.
+  // The buffer must already be allocated.
+  float &at(unsigned int index)
+  {
+    return (buffer[index & mask]);
+  }
+
+  void clear()
+  {
+    std::fill(buffer.begin(), buffer.end(), 0.0f);
+  }
+};
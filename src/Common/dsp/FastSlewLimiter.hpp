@@ -38,4 +38,13 @@ struct TFastSlewLimiter
     }
 };
 
+// Slews four values at once.  The early return above doesn't apply to
+// vectors, so this always clamps.
+template <>
+inline simd::float_4 TFastSlewLimiter<simd::float_4>::process(simd::float_4 in)
+{
+    out = simd::clamp(in, out - fallDelta, out + riseDelta);
+    return out;
+}
+
 typedef TFastSlewLimiter<> FastSlewLimiter;
\ No newline at end of file
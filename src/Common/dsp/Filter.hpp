@@ -1,5 +1,9 @@
 #pragma once
 
+#include <map>
+#include <memory>
+#include <mutex>
+
 // From: https://github.com/surge-synthesizer/clap-saw-demo/blob/main/src/saw-voice.cpp
 // Reformatted to fit my personal coding style.
 
@@ -13,12 +17,81 @@ enum Mode
     ALL
 };
 
+//
+// FilterCutoffTable
+//
+// The filter's "g" coefficient, tan(pi * frequency / sample rate), for
+// cutoff settings from 0 to 1 at one sample rate.  Looking it up and
+// interpolating is far cheaper than pow() and tan(), so a cutoff that is
+// modulated every sample costs about the same as a fixed one.
+//
+// Tables are built once per sample rate and shared by every filter in every
+// module.  They aren't changed or freed after being built.  Building or
+// finding one takes a lock, so it's done by Filter::setSampleRate(), outside
+// of process().
+//
+
+struct FilterCutoffTable
+{
+    static const unsigned int SIZE = 1024;
+
+    float sample_rate = 0;
+    float g[SIZE + 1];
+
+    // Maps the 0 to 1 cutoff setting to a frequency in Hz
+    static float cutoffToFrequency(float cutoff)
+    {
+        float key = 69 + (cutoff * 8.68);
+        float tuned_cutoff = 440.0 * (pow(2.0, key - 69.0) / 12);
+        return(clamp(tuned_cutoff, 10.0, 15000.0)); // just to be safe/lazy
+    }
+
+    static float computeG(float cutoff, float sample_rate)
+    {
+        return(std::tan(3.14159265358979323846 * cutoffToFrequency(cutoff) / sample_rate));
+    }
+
+    static const FilterCutoffTable *forSampleRate(float sample_rate)
+    {
+        static std::mutex mutex;
+        static std::map<float, std::unique_ptr<FilterCutoffTable>> tables;
+
+        std::lock_guard<std::mutex> lock(mutex);
+
+        std::unique_ptr<FilterCutoffTable> &table = tables[sample_rate];
+
+        if(! table)
+        {
+            table.reset(new FilterCutoffTable());
+            table->sample_rate = sample_rate;
+
+            for(unsigned int i = 0; i <= SIZE; i++)
+            {
+                table->g[i] = computeG((float) i / SIZE, sample_rate);
+            }
+        }
+
+        return(table.get());
+    }
+
+    float lookup(float cutoff) const
+    {
+        // Settings outside of the table's range are rare enough to compute
+        if(cutoff < 0.0 || cutoff > 1.0) return(computeG(cutoff, sample_rate));
+
+        float position = cutoff * SIZE;
+        unsigned int index = std::min((unsigned int) position, SIZE - 1);
+        float fraction = position - index;
+
+        return(g[index] + ((g[index + 1] - g[index]) * fraction));
+    }
+};
+
 struct Filter
 {
     int mode = LP;
     float cutoff = 1.0;
     float resonance = 0.7;
-    float pival = 3.14159265358979323846;
 
     float ic1eq[2] = {0.0, 0.0};
     float ic2eq[2] = {0.0, 0.0};
@@ -32,8 +105,18 @@ struct Filter
 
     bool dirty = true;
 
+    const FilterCutoffTable *cutoff_table = NULL;
+
     Filter()
     {
+        setSampleRate(APP->engine->getSampleRate());
+    }
+
+    // Takes a lock, and may build a new table, so call this from a module's
+    // constructor or onSampleRateChange(), never from process()
+    void setSampleRate(float sample_rate)
+    {
+        cutoff_table = FilterCutoffTable::forSampleRate(sample_rate);
         dirty = true;
     }
 
@@ -69,18 +152,18 @@ struct Filter
 
     void recalculate()
     {
-        float key = 69 + (cutoff * 8.68);
-        float tuned_cutoff = 440.0 * (pow(2.0, key - 69.0) / 12);
-        tuned_cutoff = clamp(tuned_cutoff, 10.0, 15000.0); // just to be safe/lazy
-
-        resonance = clamp(resonance, 0.01f, 0.99f);
-        g = std::tan(pival * tuned_cutoff * APP->engine->getSampleTime());
-        k = 2.0 - 2.0 * resonance;
+        // The clamped resonance isn't stored, so that setResonance() can
+        // still tell when the setting changes
+        float clamped_resonance = clamp(resonance, 0.01f, 0.99f);
+        g = cutoff_table->lookup(cutoff);
+        k = 2.0 - 2.0 * clamped_resonance;
         gk = g + k;
         a1 = 1.0 / (1.0 + g * gk);
         a2 = g * a1;
         a3 = g * a2;
         ak = gk * a1;
+
+        dirty = false;
     }
 
     void init()
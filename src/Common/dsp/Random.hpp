@@ -1,18 +1,118 @@
 #pragma once
+#include <cstdint>
 #include <random>
 
+#ifdef VOXGLITCH_OFFLINE_RENDER
+// Defined in bench/offline_render.cpp
+uint64_t offlineRenderSeed();
+#endif
+
+//
+// Random
+//
+// A small, fast random number generator for use on the audio thread.
+//
+// The engine is xoshiro128+ (Blackman & Vigna), which needs 16 bytes of state
+// and a handful of shifts and xors per number.  Its period is 2^128 - 1, so
+// it won't fall into an audible loop the way a short LCG can when it's
+// called at sample rate.  Each instance is seeded once from std::random_device
+// when it's constructed, so modules don't produce the same sequence as each
+// other, or from one session to the next.
+//
+// The offline renderer (bench/offline_render.cpp) needs the same output on
+// every run.  It builds the plugin with VOXGLITCH_OFFLINE_RENDER defined and
+// supplies offlineRenderSeed(), which hands out a fresh seed for each
+// instance.  Plugin builds don't have that hook.
+//
+// Numbers are generated BLOCK_SIZE at a time into a small buffer, which keeps
+// the per-call cost down to a load and an index increment.
+//
+
 struct Random
 {
-    std::uniform_real_distribution<float> dist = std::uniform_real_distribution<float>(0.0, 1.0);
-    std::random_device rd;
+    static const unsigned int BLOCK_SIZE = 32;
+
+    uint32_t state[4];
+    float block[BLOCK_SIZE];
+    unsigned int block_index = BLOCK_SIZE;
 
     Random()
     {
+#ifdef VOXGLITCH_OFFLINE_RENDER
+        seed(offlineRenderSeed());
+#else
+        std::random_device rd;
+        seed(((uint64_t) rd() << 32) | rd());
+#endif
+    }
+
+    Random(uint64_t seed_value)
+    {
+        seed(seed_value);
+    }
+
+    // Expand a 64 bit seed into the generator's state using splitmix64, as
+    // recommended by the authors of xoshiro.  The state can't be all zeros.
+    void seed(uint64_t seed_value)
+    {
+        for (unsigned int i = 0; i < 4; i += 2)
+        {
+            uint64_t z = (seed_value += 0x9E3779B97F4A7C15ULL);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            z = z ^ (z >> 31);
+
+            state[i] = (uint32_t) z;
+            state[i + 1] = (uint32_t) (z >> 32);
+        }
+
+        if ((state[0] | state[1] | state[2] | state[3]) == 0) state[0] = 1;
+
+        block_index = BLOCK_SIZE;
     }
 
+    static inline uint32_t rotl(const uint32_t x, int k)
+    {
+        return (x << k) | (x >> (32 - k));
+    }
+
+    inline uint32_t next()
+    {
+        const uint32_t result = state[0] + state[3];
+        const uint32_t t = state[1] << 9;
+
+        state[2] ^= state[0];
+        state[3] ^= state[1];
+        state[1] ^= state[2];
+        state[0] ^= state[3];
+        state[2] ^= t;
+        state[3] = rotl(state[3], 11);
+
+        return result;
+    }
+
+    void refill()
+    {
+        // The lowest bits of xoshiro128+ are its weakest, so only the upper
+        // 24 bits are used.  That's exactly a float's precision.
+        for (unsigned int i = 0; i < BLOCK_SIZE; i++)
+        {
+            block[i] = (next() >> 8) * (1.0f / 16777216.0f);
+        }
+
+        block_index = 0;
+    }
+
+    // Returns a random float in [0, 1)
     float gen()
     {
-        std::mt19937 gen(rd());
-        return dist(gen);
+        if (block_index == BLOCK_SIZE) refill();
+        return block[block_index++];
+    }
+
+    // Returns a random float in [min, max)
+    float uniform(float min, float max)
+    {
+        return min + gen() * (max - min);
     }
 };
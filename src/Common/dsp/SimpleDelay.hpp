@@ -1,69 +1,128 @@
 #pragma once
 
-#define MAX_BUFFER_SIZE 44100
-#define MIN_BUFFER_SIZE 10
+#include <atomic>
+#include <cmath>
+#include "DelayLine.hpp"
+
+//
+// SimpleDelay
+//
+// A stereo feedback delay, built on two DelayLines (see DelayLine.hpp).  The
+// longest delay is MAX_DELAY_SECONDS at the sample rate given to
+// setSampleRate().
+//
+// Most delays are never turned on, so the buffers aren't allocated until
+// allocate() is called, from the GUI thread or dataFromJson(), once the delay
+// is needed.  Until then, process() passes the audio through untouched.
+// setSampleRate() allocates the buffers again if they already exist, so call
+// it from the module's constructor or onSampleRateChange(), never from
+// process().
+//
+// When the buffer size changes, the delay glides to the new length over a few
+// milliseconds and reads between samples, which bends the pitch instead of
+// clicking.
+//
 
 struct SimpleDelay
 {
-  unsigned int write_head = 0;
+  static constexpr unsigned int MIN_BUFFER_SIZE = 10;
+  static constexpr float MAX_DELAY_SECONDS = 0.25;
 
-  float buffer_left[MAX_BUFFER_SIZE];
-  float buffer_right[MAX_BUFFER_SIZE];
+  DelayLine delay_line_left;
+  DelayLine delay_line_right;
 
   float feedback = 0.9;
   float mix = 0.5;
-  uint32_t buffer_size = 44100;
+  uint32_t buffer_size = MIN_BUFFER_SIZE;
+  uint32_t max_buffer_size = MIN_BUFFER_SIZE;
+
+  // The delay length being read, which follows buffer_size.  Kept in double
+  // precision so that the glide's tiny final steps aren't lost to rounding.
+  double delay_length = MIN_BUFFER_SIZE;
+  double glide_coefficient = 0.001;
+
+  // Nothing has been written since the buffers were allocated or purged
+  bool silent = true;
+
+  // Set by allocate() once the buffers exist.  process() checks it before
+  // touching them.
+  std::atomic<bool> allocated {false};
 
   SimpleDelay()
   {
-    for(unsigned int i=0; i<MAX_BUFFER_SIZE; i++)
-    {
-      buffer_left[i] = 0.0;
-      buffer_right[i] = 0.0;
-    }
   }
 
   virtual void process(float audio_left, float audio_right, float &read_audio_left, float &read_audio_right)
   {
-    unsigned int read_index = (write_head + 1) % MAX_BUFFER_SIZE;
-
-    if (read_index < MAX_BUFFER_SIZE)
-    {
-      read_audio_left = (mix * buffer_left[read_index]) + ((1.0 - mix) * audio_left);
-      read_audio_right = (mix * buffer_right[read_index]) + ((1.0 - mix) * audio_right);
-    }
-    else
+    if (! isAllocated())
     {
       read_audio_left = audio_left;
       read_audio_right = audio_right;
+      return;
+    }
+
+    // There's nothing to glide through until the delay has been used
+    if (silent) delay_length = buffer_size;
+
+    if (delay_length != buffer_size)
+    {
+      delay_length += (buffer_size - delay_length) * glide_coefficient;
+
+      // Land exactly on the new length, so that reads skip interpolation
+      if (std::fabs(buffer_size - delay_length) < 0.01) delay_length = buffer_size;
     }
 
+    // Reading happens before this frame is written, so a delay of
+    // _delay_length_ is delay_length - 1 writes ago.
+    float delayed_audio_left = delay_line_left.readInterpolated(delay_length - 1.0f);
+    float delayed_audio_right = delay_line_right.readInterpolated(delay_length - 1.0f);
+
+    read_audio_left = (mix * delayed_audio_left) + ((1.0 - mix) * audio_left);
+    read_audio_right = (mix * delayed_audio_right) + ((1.0 - mix) * audio_right);
+
     // Defensive programming in case the audio explodes for some reason
     read_audio_left = clamp(read_audio_left, -100.0, 100.0);
     read_audio_right = clamp(read_audio_right, -100.0, 100.0);
 
-    // Increment delay write head.  Wrap it to 0 if it's out of bounds.
-    write_head++;
-    if (write_head >= buffer_size || write_head >= MAX_BUFFER_SIZE) write_head = 0;
+    delay_line_left.write((delayed_audio_left * feedback) + audio_left);
+    delay_line_right.write((delayed_audio_right * feedback) + audio_right);
+    silent = false;
+  };
 
-    if (feedback == 0)
-    {
-      buffer_left[write_head] = audio_left;
-      buffer_right[write_head] = audio_right;
-    }
-    else
-    {
-      float existing_audio_left = buffer_left[write_head];
-      float existing_audio_right = buffer_right[write_head];
+  void setSampleRate(float sample_rate)
+  {
+    max_buffer_size = std::max((uint32_t) (sample_rate * MAX_DELAY_SECONDS), (uint32_t) MIN_BUFFER_SIZE);
 
-      float mixed_audio_left = (existing_audio_left * feedback) + audio_left;
-      float mixed_audio_right = (existing_audio_right * feedback) + audio_right;
+    // Glide with a time constant of about 20ms
+    glide_coefficient = 1.0 - std::exp(-1.0 / (0.02 * sample_rate));
 
-      // float mixed_audio = (existing_audio * feedback);
-      buffer_left[write_head] = mixed_audio_left;
-      buffer_right[write_head] = mixed_audio_right;
-    }
-  };
+    setBufferSize(buffer_size);
+    if (delay_length > max_buffer_size) delay_length = max_buffer_size;
+
+    if (isAllocated()) resizeBuffers();
+  }
+
+  // Allocates the buffers, if they haven't been already.  Call it from the GUI
+  // thread or dataFromJson(), not from process().
+  void allocate()
+  {
+    if (isAllocated()) return;
+
+    resizeBuffers();
+    allocated.store(true, std::memory_order_release);
+  }
+
+  bool isAllocated()
+  {
+    return (allocated.load(std::memory_order_acquire));
+  }
+
+  void resizeBuffers()
+  {
+    // Room for the interpolator's neighbouring samples
+    delay_line_left.setCapacity(max_buffer_size + 4);
+    delay_line_right.setCapacity(max_buffer_size + 4);
+  }
 
   uint32_t getBufferSize()
   {
@@ -72,12 +131,13 @@ struct SimpleDelay
 
   uint32_t getMaxBufferSize()
   {
-    return (MAX_BUFFER_SIZE);
+    return (max_buffer_size);
   }
 
   void setBufferSize(uint32_t new_buffer_size)
   {
-    if (new_buffer_size > MAX_BUFFER_SIZE) new_buffer_size = MAX_BUFFER_SIZE;
+    if (new_buffer_size < MIN_BUFFER_SIZE) new_buffer_size = MIN_BUFFER_SIZE;
+    if (new_buffer_size > max_buffer_size) new_buffer_size = max_buffer_size;
     buffer_size = new_buffer_size;
   }
 
@@ -93,10 +153,8 @@ struct SimpleDelay
 
   void purge()
   {
-    for (unsigned int i = 0; i < MAX_BUFFER_SIZE; i++)
-    {
-      buffer_left[i] = 0.0;
-      buffer_right[i] = 0.0;
-    }
+    delay_line_left.clear();
+    delay_line_right.clear();
+    silent = true;
   }
 };
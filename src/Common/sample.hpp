@@ -1,46 +1,152 @@
 #pragma once
 
 #include "AudioFile.h"
+#include "SampleCache.hpp"
+#include "SampleStream.hpp"
 
 struct SampleAudioBuffer
 {
-  std::vector<float> left_buffer;
-  std::vector<float> right_buffer;
+  // Audio which was loaded from a file is shared with other samples through
+  // the SampleCache, so it must never be modified.  Recorded audio is written
+  // to recording_data instead, which belongs to this buffer alone.  When
+  // recording, _data_ and _recording_data_ point to the same object.
+  std::shared_ptr<const SampleAudioData> data;
+  std::shared_ptr<SampleAudioData> recording_data;
+
+  // Optional disk streaming for memory mapped files.  See SampleStream.hpp.
+  std::shared_ptr<SampleStream> stream;
+
+  // Raw pointers into _data_, refreshed whenever _data_ changes, so that
+  // reading audio doesn't have to go through the shared pointer.  Decoded
+  // audio is interleaved (see InterleavedAudioBuffer.hpp).  Large files may
+  // be memory mapped instead, in which case _mapped_file_ is set and
+  // _frames_ is NULL.
+  const float *frames = NULL;
+  const MappedWavFile *mapped_file = NULL;
+  SampleStream *active_stream = NULL;
+  unsigned int length = 0;
+  unsigned int channels = 2;   // Of _frames_.  Mono files are decoded as one channel.
+
   unsigned int interpolation = 1;
   unsigned int virtual_size = 0;
 
   void clear()
   {
-    // Trick to free up memory in buffers
-    std::vector<float>().swap(left_buffer);
-    std::vector<float>().swap(right_buffer);
+    data.reset();
+    recording_data.reset();
+    stream.reset();
+    refresh();
+  }
 
-    left_buffer.resize(0);
-    right_buffer.resize(0);
+  // Use decoded audio provided by the SampleCache
+  void setData(std::shared_ptr<const SampleAudioData> new_data)
+  {
+    recording_data.reset();
+    stream.reset();
+    data = new_data;
+    refresh();
+  }
+
+  // Read _data_ through a SampleStream, which must have been created for it
+  void setStream(std::shared_ptr<SampleStream> new_stream)
+  {
+    stream = new_stream;
+    refresh();
   }
 
   void push_back(float audio_left, float audio_right)
   {
-    left_buffer.push_back(audio_left);
-    right_buffer.push_back(audio_right);
+    // Copy-on-write: the first write makes a private copy of any shared audio
+    if(! recording_data)
+    {
+      recording_data = std::make_shared<SampleAudioData>();
+      recording_data->channels = 2;
+
+      if(length > 0)
+      {
+        recording_data->sample_rate = data->sample_rate;
+
+        recording_data->audio.resize(length);
+
+        for(unsigned int i = 0; i < length; i++)
+        {
+          float left, right;
+          read(i, &left, &right);
+          recording_data->audio.set(i, left, right);
+        }
+      }
+
+      data = recording_data;
+      stream.reset();
+    }
+
+    recording_data->audio.push_back(audio_left, audio_right);
+    refresh();
+  }
+
+  void refresh()
+  {
+    if(data)
+    {
+      mapped_file = data->mapped();
+      active_stream = stream.get();
+      frames = mapped_file ? NULL : data->audio.data();
+      channels = data->audio.channels;
+      length = data->size();
+    }
+    else
+    {
+      frames = NULL;
+      mapped_file = NULL;
+      active_stream = NULL;
+      length = 0;
+    }
   }
 
   unsigned int size()
   {
-    return(left_buffer.size());
+    return(length);
+  }
+
+  // Exchange audio data with another buffer.  This only swaps pointers,
+  // so it's safe to call from the audio thread.
+  void swap(SampleAudioBuffer &other)
+  {
+    data.swap(other.data);
+    recording_data.swap(other.recording_data);
+    stream.swap(other.stream);
+    std::swap(frames, other.frames);
+    std::swap(mapped_file, other.mapped_file);
+    std::swap(active_stream, other.active_stream);
+    std::swap(length, other.length);
+    std::swap(channels, other.channels);
+    std::swap(interpolation, other.interpolation);
+    std::swap(virtual_size, other.virtual_size);
   }
 
   void read(unsigned int index, float *left_audio_ptr, float *right_audio_ptr)
   {
-    if((index >= left_buffer.size()) || (index >= right_buffer.size()))
+    if(index >= length)
     {
       *left_audio_ptr = 0;
       *right_audio_ptr = 0;
     }
+    else if(active_stream)
+    {
+      active_stream->read(index, left_audio_ptr, right_audio_ptr);
+    }
+    else if(mapped_file)
+    {
+      mapped_file->read(index, left_audio_ptr, right_audio_ptr);
+    }
+    else if(channels == 1)
+    {
+      *left_audio_ptr = frames[index];
+      *right_audio_ptr = frames[index];
+    }
     else
     {
-      *left_audio_ptr = left_buffer[index];
-      *right_audio_ptr = right_buffer[index];
+      InterleavedAudioBuffer::readFrame(frames + (index * 2), left_audio_ptr, right_audio_ptr);
     }
   }
 
@@ -49,18 +155,37 @@ struct SampleAudioBuffer
   {
     unsigned int index = std::floor(position); // convert float to int
 
-    // If out of bounds, return zeros
-    if((index >= (left_buffer.size() - 1)) || ((index >= right_buffer.size() - 1)))
+    // If out of bounds, return zeros.  As before the buffer was interleaved,
+    // the last frame has nothing to interpolate toward, so it's silent too.
+    if(index + 1 >= length)
     {
       *left_audio_ptr = 0;
       *right_audio_ptr = 0;
     }
+    // Streamed and memory mapped files are converted one frame at a time
+    else if(active_stream || mapped_file)
+    {
+      float distance = position - (float) index;
+      float left_next, right_next;
+
+      read(index, left_audio_ptr, right_audio_ptr);
+      read(index + 1, &left_next, &right_next);
+
+      *left_audio_ptr += (left_next - *left_audio_ptr) * distance;
+      *right_audio_ptr += (right_next - *right_audio_ptr) * distance;
+    }
+    else if(channels == 1)
+    {
+      float distance = position - (float) index;
+      float mono = frames[index] + ((frames[index + 1] - frames[index]) * distance);
+
+      *left_audio_ptr = mono;
+      *right_audio_ptr = mono;
+    }
     // Else, compute and return the interpolated values
     else
     {
-      float distance = position - (float) index;
-      *left_audio_ptr = left_buffer[index] + ((left_buffer[index + 1] - left_buffer[index]) * distance);
-      *right_audio_ptr = right_buffer[index] + ((right_buffer[index + 1] - right_buffer[index]) * distance);
+      InterleavedAudioBuffer::interpolateFrame(frames + (index * 2), position - (double) index, left_audio_ptr, right_audio_ptr);
     }
   }
 };
@@ -78,7 +203,7 @@ struct Sample
   SampleAudioBuffer sample_audio_buffer;
   float sample_rate = 44100.0;                // This is the sample rate in which the sample was recorded
   unsigned int channels = 0;
-  AudioFile<float> audioFile;                 // For loading samples and saving samples
+  AudioFile<float> audioFile;                 // For saving recorded samples
 
   Sample()
   {
@@ -99,50 +224,42 @@ struct Sample
     sample_audio_buffer.clear();
   }
 
-  bool load(std::string path)
+  // When _allow_mapping_ is true, large files are memory mapped and read
+  // directly from disk instead of being decoded into memory.  If
+  // _stream_read_ahead_ms_ is also set, mapped files are streamed through a
+  // small read-ahead buffer, which is filled on a background thread.
+  bool load(std::string path, bool allow_mapping = false, unsigned int stream_read_ahead_ms = 0)
   {
     // Set loading flags
     this->loading = true;
     this->loaded = false;
 
-    // initialize some transient variables
-    float left = 0;
-    float right = 0;
+    // Fetch the decoded audio from the cache.  The file is only read and
+    // decoded if no other sample has it loaded already.
+    std::shared_ptr<const SampleAudioData> data = SampleCache::instance().load(path, allow_mapping);
 
-    // Load the audio file
-    if(! audioFile.load(path))
+    if(! data)
     {
       this->loading = false;
       this->loaded = false;
       return(false);
     }
 
-    // Read details about the loaded sample
-    uint32_t sampleRate = audioFile.getSampleRate();
-    int numSamples = audioFile.getNumSamplesPerChannel();
-    int numChannels = audioFile.getNumChannels();
+    this->channels = data->channels;
+    this->sample_rate = data->sample_rate;
+    sample_audio_buffer.setData(data);
 
-    this->channels = numChannels;
-    this->sample_rate = sampleRate;
-    sample_audio_buffer.clear();
+#ifdef VOXGLITCH_OFFLINE_RENDER
+    // How far ahead a stream gets depends on its worker thread, so offline
+    // renders read mapped files directly (see SampleLoader.hpp)
+    stream_read_ahead_ms = 0;
+#endif
 
-    //
-    // Copy the sample data from the AudioFile object to floating point vectors
-    //
-    for(int i = 0; i < numSamples; i++)
+    if(data->mapped() && stream_read_ahead_ms > 0)
     {
-      if(numChannels == 2)
-      {
-        left = audioFile.samples[0][i];  // [channel][sample_index]
-        right = audioFile.samples[1][i];
-      }
-      else if(numChannels == 1)
-      {
-        left = audioFile.samples[0][i];
-        right = left;
-      }
-
-      sample_audio_buffer.push_back(left, right);
+      std::shared_ptr<SampleStream> stream = std::make_shared<SampleStream>(data, stream_read_ahead_ms);
+      SampleStreamer::instance().add(stream);
+      sample_audio_buffer.setStream(stream);
     }
 
     // Store sample length and file information to this object for the rest
@@ -156,13 +273,26 @@ struct Sample
     this->loading = false;
     this->loaded = true;
 
-    // Now that the audioFile has been read into memory, clear it out
-    audioFile.samples[0].resize(0);
-    audioFile.samples[1].resize(0);
-
     return(true);
   };
 
+  // Exchange the loaded audio and file information with another sample.
+  // This is used by the SampleLoader to swap a sample, which was loaded in
+  // the background, into place without allocating memory.  The audioFile
+  // member is left alone, as it's only used while loading and recording.
+  void swap(Sample &other)
+  {
+    path.swap(other.path);
+    filename.swap(other.filename);
+    display_name.swap(other.display_name);
+    sample_audio_buffer.swap(other.sample_audio_buffer);
+    std::swap(loading, other.loading);
+    std::swap(loaded, other.loaded);
+    std::swap(sample_length, other.sample_length);
+    std::swap(sample_rate, other.sample_rate);
+    std::swap(channels, other.channels);
+  }
+
   // Where to put recording code and how to save it?
   void initialize_recording()
   {
@@ -2,34 +2,24 @@
 
 #include "AudioFile.h"
 
-struct AudioBuffer
-{
-  std::vector<float> buffer;
-
-  void clear()
-  {
-    buffer.resize(0);
-  }
-
-  void push_back(float audio)
-  {
-    buffer.push_back(audio);
-  }
-
-  unsigned int size()
-  {
-    return(buffer.size());
-  }
-
-  float read(unsigned int index)
-  {
-    if(index >= buffer.size()) return 0.0;
-    return buffer[index];
-  }
-};
+//
+// SampleMC
+//
+// A multi-channel sample.  The audio of every channel is kept in one
+// contiguous buffer, with the channels of each frame next to each other
+// (frame 0 channel 0, frame 0 channel 1, ..., frame 1 channel 0, ...), so
+// that all of the channels at a playback position share a few cache lines.
+//
+// The buffer is followed by PADDING floats of silence.  This means that four
+// channels can be loaded with a single float_4 load starting at any channel
+// of any frame, even when that reads past the last channel of the last
+// frame.  Values read from past the last channel should be ignored.
+//
 
 struct SampleMC
 {
+  static const unsigned int PADDING = 4;
+
 	std::string path;
 	std::string filename;
 	std::string display_name;
@@ -39,7 +29,7 @@ struct SampleMC
   std::string queued_path = "";
   unsigned int sample_length = 0;
 
-  std::vector<AudioBuffer> audio_buffers;
+  std::vector<float> frames;
 
   // Here, number_of_samples is the number of float values in a sample.
   // I might want to rename this to avoid confusion with "samples" meaning
@@ -48,8 +38,6 @@ struct SampleMC
   unsigned int number_of_channels;
   unsigned int sample_rate;
 
-  AudioFile<float> audioFile; // For loading samples and saving samples
-
 	SampleMC()
 	{
 		loading = false;
@@ -58,28 +46,20 @@ struct SampleMC
 		path = "";
 		sample_rate = 0;
 		number_of_channels = 0;
-
-    audioFile.setNumChannels(2);
-    audioFile.setSampleRate(44100);
+		number_of_samples = 0;
 	}
 
-  ~SampleMC()
-  {
-    for (auto &audio_buffer : audio_buffers) // access by reference to avoid copying
-    {
-      audio_buffer.clear();
-    }
-  }
-
   void load(std::string path)
   {
     this->loading = true;
     this->loaded = false;
 
-    // float audio = 0;
+    // The AudioFile is only needed while loading.  Keeping it around would
+    // keep a second copy of the audio in memory.
+    AudioFile<float> audio_file;
 
     // If file fails to load, abandon operation
-    if(! audioFile.load(path))
+    if(! audio_file.load(path))
     {
       this->loading = false;
       this->loaded = false;
@@ -87,22 +67,23 @@ struct SampleMC
     }
 
     // Read details about the loaded sample
-    this->number_of_samples = audioFile.getNumSamplesPerChannel();
-    this->number_of_channels = audioFile.getNumChannels();
-    this->sample_rate = audioFile.getSampleRate();
+    this->number_of_samples = audio_file.getNumSamplesPerChannel();
+    this->number_of_channels = audio_file.getNumChannels();
+    this->sample_rate = audio_file.getSampleRate();
+
+    // Size the buffer once, replacing the audio of any previously loaded file
+    std::vector<float>(((std::size_t) number_of_samples * number_of_channels) + PADDING, 0.0f).swap(frames);
 
     for (unsigned int channel_index = 0; channel_index < this->number_of_channels; channel_index++)
     {
-      AudioBuffer audio_buffer;
-
-      audio_buffer.clear();
+      const std::vector<float> &channel_samples = audio_file.samples[channel_index];
+      float *destination = &frames[channel_index];
 
       for (unsigned int sample_index = 0; sample_index < number_of_samples; sample_index++)
       {
-        audio_buffer.push_back(audioFile.samples[channel_index][sample_index]);
+        *destination = channel_samples[sample_index];
+        destination += number_of_channels;
       }
-
-      audio_buffers.push_back(audio_buffer);
     }
 
     // Store sample length and file information to this object for the rest
@@ -119,18 +100,15 @@ struct SampleMC
 
   float read(unsigned int channel, unsigned int index)
   {
-    float audio;
-
-    if (channel < audio_buffers.size())
-    {
-      audio = audio_buffers[channel].read(index);
-    }
-    else
-    {
-      audio = 0;
-    }
+    if((channel >= number_of_channels) || (index >= sample_length)) return(0);
+    return(frames[((std::size_t) index * number_of_channels) + channel]);
+  }
 
-    return(audio);
+  // Returns the first channel of frame _index_, which must be less than
+  // size().  See the note about PADDING above.
+  const float *frame(unsigned int index)
+  {
+    return(&frames[(std::size_t) index * number_of_channels]);
   }
 
   unsigned int size()
@@ -138,4 +116,44 @@ struct SampleMC
     return(sample_length);
   }
 
+  // Exchanges the audio and file details with another SampleMC.  Only vector
+  // and string internals are swapped, so nothing is allocated or freed, and
+  // it's safe to call from the audio thread.
+  void swap(SampleMC &other)
+  {
+    std::swap(path, other.path);
+    std::swap(filename, other.filename);
+    std::swap(display_name, other.display_name);
+    std::swap(loading, other.loading);
+    std::swap(loaded, other.loaded);
+    std::swap(sample_length, other.sample_length);
+    std::swap(number_of_samples, other.number_of_samples);
+    std::swap(number_of_channels, other.number_of_channels);
+    std::swap(sample_rate, other.sample_rate);
+    frames.swap(other.frames);
+  }
+
+};
+
+//
+// SampleMCLoadRequest
+//
+// Loads a SampleMC on the SampleLoader's worker threads.  See SampleLoader.hpp.
+//
+
+struct SampleMCLoadRequest : LoadRequest
+{
+  SampleMC sample;
+
+  SampleMCLoadRequest(std::string path) : LoadRequest(path)
+  {
+  }
+
+  bool decode() override
+  {
+    if(path == "") return(true);
+
+    sample.load(path);
+    return(sample.loaded);
+  }
 };
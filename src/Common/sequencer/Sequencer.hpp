@@ -3,22 +3,30 @@ struct Sequencer
   unsigned int sequence_length = 16;
   unsigned int sequence_playback_position = 0;
 
+  // Incremented whenever anything a display might show changes, including
+  // the playback position.  Displays compare it with the value they last
+  // drew to decide whether they need to draw again.
+  unsigned int revision = 0;
+
   void step()
   {
     sequence_playback_position = (sequence_playback_position + 1) % sequence_length;
+    revision++;
   }
 
   void setPosition(unsigned int position)
   {
-    if(position < sequence_length)
+    if(position < sequence_length && position != sequence_playback_position)
     {
       sequence_playback_position = position;
+      revision++;
     }
   }
 
   void reset()
   {
     sequence_playback_position = 0;
+    revision++;
   }
 
   unsigned int getPlaybackPosition()
@@ -38,6 +46,8 @@ struct Sequencer
 
   void setLength(unsigned int sequence_length)
   {
+    // This is called on every frame by some modules, so only changes count
+    if(sequence_length != this->sequence_length) revision++;
     this->sequence_length = sequence_length;
   }
 };
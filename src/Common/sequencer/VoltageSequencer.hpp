@@ -27,6 +27,7 @@ struct VoltageSequencer : Sequencer
   void assign(unsigned int length, double value)
   {
     sequence.assign(length, value);
+    revision++;
 
     // Set the parent sequencer length to the correct length
     this->setLength(length);
@@ -69,11 +70,14 @@ struct VoltageSequencer : Sequencer
     {
       sequence[index] = value;
     }
+
+    revision++;
   }
 
   void fill(double value)
   {
    sequence.assign(sequence.size(), value);
+   revision++;
   }
 
   void setSnapDivisionIndex(unsigned int new_snap_division_index)
@@ -89,6 +93,7 @@ struct VoltageSequencer : Sequencer
       sequence[i] = sequence[i + 1];
     }
     sequence[this->sequence_length - 1] = temp;
+    revision++;
   }
 
   void shiftRight()
@@ -101,6 +106,7 @@ struct VoltageSequencer : Sequencer
     }
 
     sequence[0] = temp;
+    revision++;
   }
 
   void randomize()
@@ -115,6 +121,7 @@ struct VoltageSequencer : Sequencer
   {
     // sequence.fill(0.0);
     sequence.assign(sequence.size(), 0);
+    revision++;
   }
 
   void copy(VoltageSequencer *src_sequence)
@@ -123,5 +130,6 @@ struct VoltageSequencer : Sequencer
     this->sequence_length = src_sequence->sequence_length;
     this->snap_division_index = src_sequence->snap_division_index;
     this->sample_and_hold = src_sequence->sample_and_hold;
+    revision++;
   }
 };
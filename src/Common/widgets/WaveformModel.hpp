@@ -3,6 +3,12 @@ struct WaveformModel
     Sample *sample;
     bool visible = false;
 
+    // The path of the sample, and a count which the module increases each
+    // time it swaps a sample in, even if it's the same file loaded again.
+    // The display fetches the sample's overview when the count changes.
+    PathHandle *loaded_path = NULL;
+    std::atomic<unsigned int> sample_revision {0};
+
     // Vertical line to show playback position
     bool draw_position_indicator = true;
     float playback_percentage = 0.0;
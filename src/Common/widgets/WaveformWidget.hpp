@@ -1,7 +1,14 @@
 struct WaveformWidget : TransparentWidget
 {
     // AutobreakStudio *module;
-    std::string sample_filename = "";
+
+    // The overview of the sample on display, fetched on the SampleLoader's
+    // worker threads (see OverviewLoadRequest.hpp).  NULL when there's no
+    // sample, and until the first fetch has finished.
+    std::shared_ptr<const SampleOverview> overview;
+    LoadSlot<OverviewLoadRequest> overview_slot;
+    unsigned int sample_revision = 0;
+    bool overview_requested = false;
 
     bool refresh = true;
     float width = 0.0;
@@ -23,6 +30,11 @@ struct WaveformWidget : TransparentWidget
 
     float max_average = 0.0;
 
+    // The waveform is drawn into the cached layer, and only drawn again when
+    // the sample changes.  The position indicator and highlighted section are
+    // drawn over it on every frame.
+    CachedLayer *cached_layer = NULL;
+
     WaveformWidget(float width, float height, WaveformModel *waveform_modal)
     {
         this->width = width;
@@ -30,14 +42,11 @@ struct WaveformWidget : TransparentWidget
         this->waveform_modal = waveform_modal;
 
         box.size = Vec(width, height);
-        sample_filename = waveform_modal->sample->filename;
 
-        averages.reserve((unsigned int) width);
+        averages.resize((unsigned int) width, 0.0);
 
-        for (unsigned int i = 0; i < width; i++)
-        {
-            averages[i] = 0.0;
-        }
+        cached_layer = new CachedLayer(box.size, [this](NVGcontext *vg) { drawWaveform(vg); });
+        addChild(cached_layer);
     }
 
     void drawLayer(const DrawArgs &args, int layer) override
@@ -49,25 +58,24 @@ struct WaveformWidget : TransparentWidget
             // Save the drawing context to restore later
             nvgSave(vg);
 
-            if (waveform_modal->sample && waveform_modal->sample->loaded)
+            if (overview)
             {
                 // Compute the values to draw
                 if(refresh == true)
                 {
                     max_average = 0.0;
 
-                    if (waveform_modal->sample->size() > this->width)
+                    for (unsigned int x = 0; x < this->width; x++)
                     {
-                        for (unsigned int x = 0; x < this->width; x++)
-                        {
-                            computeAverages(x, waveform_modal->sample->size());
-                        }
+                        computeAverages(x, overview->length);
                     }
 
                     normalizeAverages();
+                    refresh = false;
+                    cached_layer->setDirty();
                 }
 
-                drawWaveform(vg);
+                cached_layer->drawCached(args);
 
                 if(waveform_modal->draw_position_indicator) drawPositionIndicator(vg);
                 if(waveform_modal->highlight_section) highlightSection(vg);
@@ -81,10 +89,27 @@ struct WaveformWidget : TransparentWidget
     {
         TransparentWidget::step();
 
-        // Sample has changed
-        if(sample_filename != waveform_modal->sample->filename)
+        // Sample has changed, or this is the first step.  The revision is
+        // checked rather than the path, because reloading a file which has
+        // been edited keeps the same path.
+        unsigned int revision = waveform_modal->sample_revision.load();
+
+        if(revision != sample_revision || ! overview_requested)
+        {
+            sample_revision = revision;
+            overview_requested = true;
+
+            // Modules which don't set a path have nothing to show
+            std::string path = (waveform_modal->loaded_path) ? waveform_modal->loaded_path->path() : "";
+            overview_slot.post(SampleLoader::instance().submit(new OverviewLoadRequest(path)));
+        }
+
+        OverviewLoadRequest *overview_request = overview_slot.take();
+
+        if(overview_request)
         {
-            sample_filename = waveform_modal->sample->filename;
+            overview = overview_request->overview;
+            overview_request->release();
             refresh = true;
         }
 
@@ -98,55 +123,40 @@ struct WaveformWidget : TransparentWidget
         }
     }
 
+    // Reads the loudness of the part of the sample under column _x_ from the
+    // sample's overview.  This is the average absolute level of both
+    // channels, as it was when the widget read every frame itself.
     void computeAverages(unsigned int x, unsigned int sample_size)
     {
-        // Get average height of line at index
-        float left_sum = 0.0;
-        float right_sum = 0.0;
-        unsigned int count = 0;
-
-        float left;
-        float right;
-
         float chunk_size = (float) sample_size / (float) width;
         unsigned int chunk_start = (x * chunk_size);
-        unsigned int chunk_end = chunk_start +  chunk_size;
+        unsigned int chunk_end = std::max((unsigned int) ((x + 1) * chunk_size), chunk_start + 1);
 
-        for(unsigned int i=chunk_start; i < chunk_end; i++)
-        {
-            if(i<sample_size)
-            {
-                waveform_modal->sample->read(i, &left, &right);
-                left_sum = left_sum + std::abs(left);
-                right_sum = right_sum + std::abs(right);
-                count++;
-            }
-        }
-
-        float left_average = left_sum / (float) count;
-        float right_average = right_sum / (float) count;
-
-        averages[x] = (left_average + right_average) / 2.0;
+        averages[x] = overview->getRange(chunk_start, chunk_end).average();
 
         if(averages[x] > max_average)  max_average = clamp(averages[x], 0.0, 1.0);
-
-        refresh = false;
     }
 
     void normalizeAverages()
     {
         for(unsigned int x = 0; x < this->width; x++)
         {
-            averages[x] = (1.0 / max_average) * averages[x];
+            averages[x] = (max_average > 0.0) ? (averages[x] / max_average) : 0.0;
         }
     }
 
+    // All of the lines share one path, so they're filled in a single call
     void drawWaveform(NVGcontext *vg)
     {
+        nvgBeginPath(vg);
+
         for (unsigned int x = 0; x < this->width; x++)
         {
             drawLine(vg, x);
         }
+
+        nvgFillColor(vg, nvgRGBA(255, 255, 255, 200));
+        nvgFill(vg);
     }
 
     void drawContainer(NVGcontext *vg)
@@ -165,10 +175,7 @@ struct WaveformWidget : TransparentWidget
         average_height = clamp(average_height, 0.0, 1.0);
         float line_height = (average_height * this->height);
 
-        nvgBeginPath(vg);
         nvgRect(vg, x, (this->height - line_height) / 2.0, 1.0, line_height);  // todo: compute this instead of hard coded
-        nvgFillColor(vg, nvgRGBA(255, 255, 255, 200));
-        nvgFill(vg);
     }
 
     void drawPositionIndicator(NVGcontext *vg)
@@ -10,6 +10,14 @@ struct VoltageSequencerDisplay : SequencerDisplay
   int previous_shift_sequence_column = 0;
   int shift_sequence_column = 0;
 
+  // The pattern is drawn into the cached layer, and only drawn again when
+  // the sequencer, its range or the room brightness change.
+  CachedLayer *cached_layer = NULL;
+  VoltageSequencer *drawn_sequencer = NULL;
+  unsigned int drawn_revision = 0;
+  unsigned int drawn_voltage_range_index = 0;
+  float drawn_brightness = -1.0;
+
   VoltageSequencerDisplay()
   {
     // The bounding box needs to be a little deeper than the visual
@@ -17,119 +25,150 @@ struct VoltageSequencerDisplay : SequencerDisplay
     // which is why 16 is being added to the draw height to define the
     // bounding box.
     box.size = Vec(DRAW_AREA_WIDTH, DRAW_AREA_HEIGHT + 16);
+
+    cached_layer = new CachedLayer(box.size, [this](NVGcontext *vg) { drawPattern(vg); });
+    addChild(cached_layer);
+  }
+
+  void step() override
+  {
+    SequencerDisplay::step();
+
+    if(module)
+    {
+      VoltageSequencer *sequencer = module->selected_voltage_sequencer;
+
+      if(sequencer != drawn_sequencer || sequencer->revision != drawn_revision || sequencer->voltage_range_index != drawn_voltage_range_index)
+      {
+        drawn_sequencer = sequencer;
+        drawn_revision = sequencer->revision;
+        drawn_voltage_range_index = sequencer->voltage_range_index;
+        cached_layer->setDirty();
+      }
+    }
+
+    if(settings::rackBrightness != drawn_brightness)
+    {
+      drawn_brightness = settings::rackBrightness;
+      cached_layer->setDirty();
+    }
   }
 
   void drawLayer(const DrawArgs& args, int layer) override
   {
   	if (layer == 1)
     {
-
       const auto vg = args.vg;
-      NVGcolor bar_color;
-      bool draw_from_center = false;
 
       // Save the drawing context to restore later
       nvgSave(vg);
 
+      cached_layer->drawCached(args);
+
       if(module)
       {
-        double range_low = module->selected_voltage_sequencer->voltage_ranges[module->selected_voltage_sequencer->voltage_range_index][0];
-        double range_high = module->selected_voltage_sequencer->voltage_ranges[module->selected_voltage_sequencer->voltage_range_index][1];
-
-        if(range_low < 0 && range_high > 0) draw_from_center = true;
-
-        //
-        // Display the pattern
-        //
-        for(unsigned int i=0; i < MAX_SEQUENCER_STEPS; i++)
-        {
-          float value = module->selected_voltage_sequencer->getValue(i);
-
-          // Draw grey background bar
-          if(i < module->selected_voltage_sequencer->getLength()) {
-            bar_color = brightness(bright_background_color, settings::rackBrightness);
-          }
-          else {
-            bar_color = brightness(dark_background_color, settings::rackBrightness);
-          }
-
-          drawBar(vg, i, BAR_HEIGHT, DRAW_AREA_HEIGHT, bar_color);
-
-          if(i == module->selected_voltage_sequencer->getPlaybackPosition())
-          {
-            // Highlight current step
-            bar_color = current_step_highlight_color;
-          }
-          else if(i < module->selected_voltage_sequencer->getLength())
-          {
-            bar_color = lesser_step_highlight_color;
-          }
-          else
-          {
-            bar_color = default_step_highlight_color;
-          }
-
-          // Draw bars for the sequence values
-          if(value > 0)
-          {
-            drawBar(vg, i, (value * DRAW_AREA_HEIGHT), DRAW_AREA_HEIGHT, bar_color);
-          }
-
-          // Highlight the sequence playback column
-          if(i == module->selected_voltage_sequencer->getPlaybackPosition())
-          {
-            drawBar(vg, i, DRAW_AREA_HEIGHT, DRAW_AREA_HEIGHT, sequence_position_highlight_color);
-          }
-        }
+        if(module->tooltip_timer > 0) draw_tooltip = true;
 
-        // Draw a horizontal 0-indicator if the range is not symmetrical
-        if(draw_from_center)
+        if(draw_tooltip)
         {
-          // This calculation for y takes advance of the fact that all
-          // ranges that would have the 0-guide visible are symmetric, so
-          // it will need updating if non-symmetric ranges are added.
-          double y = DRAW_AREA_HEIGHT / 2.0;
-
-          nvgBeginPath(vg);
-          nvgRect(vg, 1, y, (DRAW_AREA_WIDTH - 2), 1.0);
-          nvgFillColor(vg, nvgRGBA(240, 240, 255, 40));
-          nvgFill(vg);
+          drawTooltip(vg);
+          draw_tooltip = false;
         }
       }
-      else // Draw a demo sequence so that the sequencer looks nice in the library selector
-      {
-        double demo_sequence[32] = {100.0,100.0,93.0,80.0,67.0,55.0,47.0,44.0,43.0,44.0,50.0,69.0,117.0,137.0,166,170,170,164,148,120,105,77,65,41,28,23,22,22,28,48,69,94};
 
-        for(unsigned int i=0; i < MAX_SEQUENCER_STEPS; i++)
-        {
-          // Draw blue background bars
-          drawBar(vg, i, BAR_HEIGHT, DRAW_AREA_HEIGHT, bright_background_color);
+      nvgRestore(vg);
+    }
+  }
 
-          // Draw bar for value at i
-          drawBar(vg, i, demo_sequence[i], DRAW_AREA_HEIGHT, lesser_step_highlight_color);
+  void drawPattern(NVGcontext *vg)
+  {
+    NVGcolor bar_color;
+    bool draw_from_center = false;
 
-          // Highlight active step
-          if(i == 5) drawBar(vg, i, DRAW_AREA_HEIGHT, DRAW_AREA_HEIGHT, sequence_position_highlight_color);
-        }
-      }
+    if(module)
+    {
+      double range_low = module->selected_voltage_sequencer->voltage_ranges[module->selected_voltage_sequencer->voltage_range_index][0];
+      double range_high = module->selected_voltage_sequencer->voltage_ranges[module->selected_voltage_sequencer->voltage_range_index][1];
 
-      drawVerticalGuildes(vg, DRAW_AREA_HEIGHT);
-      drawOverlay(vg, DRAW_AREA_WIDTH, DRAW_AREA_HEIGHT);
+      if(range_low < 0 && range_high > 0) draw_from_center = true;
 
-      if(module)
+      //
+      // Display the pattern
+      //
+      for(unsigned int i=0; i < MAX_SEQUENCER_STEPS; i++)
       {
-        if(module->tooltip_timer > 0) draw_tooltip = true;
+        float value = module->selected_voltage_sequencer->getValue(i);
 
-        if(draw_tooltip)
+        // Draw grey background bar
+        if(i < module->selected_voltage_sequencer->getLength()) {
+          bar_color = brightness(bright_background_color, settings::rackBrightness);
+        }
+        else {
+          bar_color = brightness(dark_background_color, settings::rackBrightness);
+        }
+
+        drawBar(vg, i, BAR_HEIGHT, DRAW_AREA_HEIGHT, bar_color);
+
+        if(i == module->selected_voltage_sequencer->getPlaybackPosition())
         {
-          drawTooltip(vg);
-          draw_tooltip = false;
+          // Highlight current step
+          bar_color = current_step_highlight_color;
+        }
+        else if(i < module->selected_voltage_sequencer->getLength())
+        {
+          bar_color = lesser_step_highlight_color;
+        }
+        else
+        {
+          bar_color = default_step_highlight_color;
+        }
+
+        // Draw bars for the sequence values
+        if(value > 0)
+        {
+          drawBar(vg, i, (value * DRAW_AREA_HEIGHT), DRAW_AREA_HEIGHT, bar_color);
+        }
+
+        // Highlight the sequence playback column
+        if(i == module->selected_voltage_sequencer->getPlaybackPosition())
+        {
+          drawBar(vg, i, DRAW_AREA_HEIGHT, DRAW_AREA_HEIGHT, sequence_position_highlight_color);
         }
       }
 
-      nvgRestore(vg);
+      // Draw a horizontal 0-indicator if the range is not symmetrical
+      if(draw_from_center)
+      {
+        // This calculation for y takes advance of the fact that all
+        // ranges that would have the 0-guide visible are symmetric, so
+        // it will need updating if non-symmetric ranges are added.
+        double y = DRAW_AREA_HEIGHT / 2.0;
+
+        nvgBeginPath(vg);
+        nvgRect(vg, 1, y, (DRAW_AREA_WIDTH - 2), 1.0);
+        nvgFillColor(vg, nvgRGBA(240, 240, 255, 40));
+        nvgFill(vg);
+      }
+    }
+    else // Draw a demo sequence so that the sequencer looks nice in the library selector
+    {
+      double demo_sequence[32] = {100.0,100.0,93.0,80.0,67.0,55.0,47.0,44.0,43.0,44.0,50.0,69.0,117.0,137.0,166,170,170,164,148,120,105,77,65,41,28,23,22,22,28,48,69,94};
+
+      for(unsigned int i=0; i < MAX_SEQUENCER_STEPS; i++)
+      {
+        // Draw blue background bars
+        drawBar(vg, i, BAR_HEIGHT, DRAW_AREA_HEIGHT, bright_background_color);
+
+        // Draw bar for value at i
+        drawBar(vg, i, demo_sequence[i], DRAW_AREA_HEIGHT, lesser_step_highlight_color);
 
+        // Highlight active step
+        if(i == 5) drawBar(vg, i, DRAW_AREA_HEIGHT, DRAW_AREA_HEIGHT, sequence_position_highlight_color);
+      }
     }
+
+    drawVerticalGuildes(vg, DRAW_AREA_HEIGHT);
+    drawOverlay(vg, DRAW_AREA_WIDTH, DRAW_AREA_HEIGHT);
   }
 
   void drawTooltip(NVGcontext *vg)
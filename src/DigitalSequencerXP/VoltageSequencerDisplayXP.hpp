@@ -15,6 +15,14 @@ struct VoltageSequencerDisplayXP : SequencerDisplay
   int previous_control_sequence_column = 0;
   int control_sequence_column = 0;
 
+  // The pattern is drawn into the cached layer, and only drawn again when
+  // the sequencer, its range or the room brightness change.
+  CachedLayer *cached_layer = NULL;
+  VoltageSequencer *drawn_sequencer = NULL;
+  unsigned int drawn_revision = 0;
+  unsigned int drawn_voltage_range_index = 0;
+  float drawn_brightness = -1.0;
+
   VoltageSequencerDisplayXP()
   {
     // The bounding box needs to be a little deeper than the visual
@@ -22,6 +30,33 @@ struct VoltageSequencerDisplayXP : SequencerDisplay
     // which is why 16 is being added to the draw height to define the
     // bounding box.
     box.size = Vec(DRAW_AREA_WIDTH, DRAW_AREA_HEIGHT + 16);
+
+    cached_layer = new CachedLayer(box.size, [this](NVGcontext *vg) { drawPattern(vg); });
+    addChild(cached_layer);
+  }
+
+  void step() override
+  {
+    SequencerDisplay::step();
+
+    if(module)
+    {
+      VoltageSequencer *sequencer = module->selected_voltage_sequencer;
+
+      if(sequencer != drawn_sequencer || sequencer->revision != drawn_revision || sequencer->voltage_range_index != drawn_voltage_range_index)
+      {
+        drawn_sequencer = sequencer;
+        drawn_revision = sequencer->revision;
+        drawn_voltage_range_index = sequencer->voltage_range_index;
+        cached_layer->setDirty();
+      }
+    }
+
+    if(settings::rackBrightness != drawn_brightness)
+    {
+      drawn_brightness = settings::rackBrightness;
+      cached_layer->setDirty();
+    }
   }
 
   void drawLayer(const DrawArgs& args, int layer) override
@@ -29,125 +64,129 @@ struct VoltageSequencerDisplayXP : SequencerDisplay
   	if (layer == 1)
     {
       const auto vg = args.vg;
-      double value;
-      NVGcolor bar_color;
-      bool draw_from_center = false;
 
       // Save the drawing context to restore later
       nvgSave(vg);
 
+      cached_layer->drawCached(args);
+
       if(module)
       {
-        double range_low = module->selected_voltage_sequencer->voltage_ranges[module->selected_voltage_sequencer->voltage_range_index][0];
-        double range_high = module->selected_voltage_sequencer->voltage_ranges[module->selected_voltage_sequencer->voltage_range_index][1];
-
-        if(range_low < 0 && range_high > 0) draw_from_center = true;
-
-        //
-        // Display the pattern
-        //
-        for(unsigned int i=0; i < MAX_SEQUENCER_STEPS; i++)
-        {
-          value = module->selected_voltage_sequencer->getValue(i);
-
-          // Draw grey background bar
-          if(i < module->selected_voltage_sequencer->getLength()) {
-            bar_color = brightness(bright_background_color, settings::rackBrightness);
-          }
-          else {
-            bar_color = brightness(dark_background_color, settings::rackBrightness);
-          }
-
-          drawBar(vg, i, BAR_HEIGHT, DRAW_AREA_HEIGHT, bar_color); // background
-
-          if(i == module->selected_voltage_sequencer->getPlaybackPosition())
-          {
-            bar_color = current_step_highlight_color;
-          }
-          else if(i < module->selected_voltage_sequencer->getLength())
-          {
-            bar_color = lesser_step_highlight_color;
-          }
-          else
-          {
-            bar_color = default_step_highlight_color;
-          }
-
-          // Draw bars for the sequence values
-          if(value > 0) drawBar(vg, i, (value * DRAW_AREA_HEIGHT), DRAW_AREA_HEIGHT, bar_color);
-
-          // Highlight the sequence playback column
-          if(i == module->selected_voltage_sequencer->getPlaybackPosition())
-          {
-            drawBar(vg, i, DRAW_AREA_HEIGHT, DRAW_AREA_HEIGHT, sequence_position_highlight_color);
-          }
-        }
-
-        // Draw a horizontal 0-indicator if the range is not symmetrical
-        if(draw_from_center)
-        {
-          // This calculation for y takes advance of the fact that all
-          // ranges that would have the 0-guide visible are symmetric, so
-          // it will need updating if non-symmetric ranges are added.
-          double y = DRAW_AREA_HEIGHT / 2.0;
-
-          nvgBeginPath(vg);
-          nvgRect(vg, 1, y, (DRAW_AREA_WIDTH - 2), 1.0);
-          nvgFillColor(vg, nvgRGBA(240, 240, 255, 40));
-          nvgFill(vg);
-        }
-
-        // Draw label, if there is one
+        // Draw label, if there is one.  Text is drawn here rather than in
+        // the cached layer, which doesn't share the window's fonts.
         std::string to_display = module->labels[module->selected_sequencer_index];
 
         if(to_display != "")
         {
-          nvgFontSize(args.vg, 14);
-          nvgTextLetterSpacing(args.vg, 0);
-          nvgFillColor(args.vg, nvgRGBA(255, 255, 255, 0xff));
-          nvgTextAlign(args.vg, NVG_ALIGN_CENTER);
+          nvgFontSize(vg, 14);
+          nvgTextLetterSpacing(vg, 0);
+          nvgFillColor(vg, nvgRGBA(255, 255, 255, 0xff));
+          nvgTextAlign(vg, NVG_ALIGN_CENTER);
           float x_position = DRAW_AREA_HEIGHT / 2;
           float y_position = 16;
           float wrap_at = 275.0; // Just throw your hands in the air!  And wave them like you just don't 274.0
-          nvgTextBox(args.vg, x_position, y_position, wrap_at, to_display.c_str(), NULL);
+          nvgTextBox(vg, x_position, y_position, wrap_at, to_display.c_str(), NULL);
         }
 
-      }
-      else // Draw a demo sequence so that the sequencer looks nice in the library selector
-      {
-        double demo_sequence[32] = {100.0,100.0,93.0,80.0,67.0,55.0,47.0,44.0,43.0,44.0,50.0,69.0,117.0,137.0,166,170,170,164,148,120,105,77,65,41,28,23,22,22,28,48,69,94};
+        if(module->tooltip_timer > 0) draw_tooltip = true;
 
-        for(unsigned int i=0; i < MAX_SEQUENCER_STEPS; i++)
+        if(draw_tooltip)
         {
-          // Draw blue background bars
-          drawBar(vg, i, BAR_HEIGHT, DRAW_AREA_HEIGHT, nvgRGBA(60, 60, 64, 255));
-
-          // Draw bar for value at i
-          drawBar(vg, i, demo_sequence[i], DRAW_AREA_HEIGHT, nvgRGBA(255, 255, 255, 150));
-
-          // Highlight active step
-          if(i == 5) drawBar(vg, i, DRAW_AREA_HEIGHT, DRAW_AREA_HEIGHT, nvgRGBA(255, 255, 255, 20));
+          drawTooltip(vg);
+          draw_tooltip = false;
         }
       }
 
-      drawVerticalGuildes(vg, DRAW_AREA_HEIGHT);
-      drawOverlay(vg, OVERLAY_WIDTH, DRAW_AREA_HEIGHT);
+      nvgRestore(vg);
+    }
+  }
 
-      if(module)
+  void drawPattern(NVGcontext *vg)
+  {
+    double value;
+    NVGcolor bar_color;
+    bool draw_from_center = false;
+
+    if(module)
+    {
+      double range_low = module->selected_voltage_sequencer->voltage_ranges[module->selected_voltage_sequencer->voltage_range_index][0];
+      double range_high = module->selected_voltage_sequencer->voltage_ranges[module->selected_voltage_sequencer->voltage_range_index][1];
+
+      if(range_low < 0 && range_high > 0) draw_from_center = true;
+
+      //
+      // Display the pattern
+      //
+      for(unsigned int i=0; i < MAX_SEQUENCER_STEPS; i++)
       {
-        if(module->tooltip_timer > 0) draw_tooltip = true;
+        value = module->selected_voltage_sequencer->getValue(i);
 
-        if(draw_tooltip)
+        // Draw grey background bar
+        if(i < module->selected_voltage_sequencer->getLength()) {
+          bar_color = brightness(bright_background_color, settings::rackBrightness);
+        }
+        else {
+          bar_color = brightness(dark_background_color, settings::rackBrightness);
+        }
+
+        drawBar(vg, i, BAR_HEIGHT, DRAW_AREA_HEIGHT, bar_color); // background
+
+        if(i == module->selected_voltage_sequencer->getPlaybackPosition())
         {
-          drawTooltip(vg);
-          draw_tooltip = false;
+          bar_color = current_step_highlight_color;
+        }
+        else if(i < module->selected_voltage_sequencer->getLength())
+        {
+          bar_color = lesser_step_highlight_color;
+        }
+        else
+        {
+          bar_color = default_step_highlight_color;
+        }
+
+        // Draw bars for the sequence values
+        if(value > 0) drawBar(vg, i, (value * DRAW_AREA_HEIGHT), DRAW_AREA_HEIGHT, bar_color);
+
+        // Highlight the sequence playback column
+        if(i == module->selected_voltage_sequencer->getPlaybackPosition())
+        {
+          drawBar(vg, i, DRAW_AREA_HEIGHT, DRAW_AREA_HEIGHT, sequence_position_highlight_color);
         }
       }
 
-      nvgRestore(vg);
+      // Draw a horizontal 0-indicator if the range is not symmetrical
+      if(draw_from_center)
+      {
+        // This calculation for y takes advance of the fact that all
+        // ranges that would have the 0-guide visible are symmetric, so
+        // it will need updating if non-symmetric ranges are added.
+        double y = DRAW_AREA_HEIGHT / 2.0;
+
+        nvgBeginPath(vg);
+        nvgRect(vg, 1, y, (DRAW_AREA_WIDTH - 2), 1.0);
+        nvgFillColor(vg, nvgRGBA(240, 240, 255, 40));
+        nvgFill(vg);
+      }
+    }
+    else // Draw a demo sequence so that the sequencer looks nice in the library selector
+    {
+      double demo_sequence[32] = {100.0,100.0,93.0,80.0,67.0,55.0,47.0,44.0,43.0,44.0,50.0,69.0,117.0,137.0,166,170,170,164,148,120,105,77,65,41,28,23,22,22,28,48,69,94};
 
+      for(unsigned int i=0; i < MAX_SEQUENCER_STEPS; i++)
+      {
+        // Draw blue background bars
+        drawBar(vg, i, BAR_HEIGHT, DRAW_AREA_HEIGHT, nvgRGBA(60, 60, 64, 255));
+
+        // Draw bar for value at i
+        drawBar(vg, i, demo_sequence[i], DRAW_AREA_HEIGHT, nvgRGBA(255, 255, 255, 150));
+
+        // Highlight active step
+        if(i == 5) drawBar(vg, i, DRAW_AREA_HEIGHT, DRAW_AREA_HEIGHT, nvgRGBA(255, 255, 255, 20));
+      }
     }
 
+    drawVerticalGuildes(vg, DRAW_AREA_HEIGHT);
+    drawOverlay(vg, OVERLAY_WIDTH, DRAW_AREA_HEIGHT);
   }
 
   void drawTooltip(NVGcontext *vg)
@@ -7,9 +7,37 @@ struct CellularAutomatonDisplay : VoxglitchWidget
   int old_row = -1;
   int old_column = -1;
 
+  // The cells are drawn into the cached layer, and only drawn again when the
+  // sequencer, the mode or the room brightness change.
+  CachedLayer *cached_layer = NULL;
+  unsigned int drawn_revision = 0;
+  unsigned int drawn_mode = 0;
+  int drawn_trigger_group_index = -1;
+  float drawn_brightness = -1.0;
+
   CellularAutomatonDisplay()
   {
     box.size = Vec(DRAW_AREA_WIDTH, DRAW_AREA_HEIGHT);
+
+    cached_layer = new CachedLayer(box.size, [this](NVGcontext *vg) { drawCells(vg); });
+    addChild(cached_layer);
+  }
+
+  void step() override
+  {
+    VoxglitchWidget::step();
+
+    if(module)
+    {
+      if(module->sequencer.revision != drawn_revision || module->mode != drawn_mode || module->selected_trigger_group_index != drawn_trigger_group_index || settings::rackBrightness != drawn_brightness)
+      {
+        drawn_revision = module->sequencer.revision;
+        drawn_mode = module->mode;
+        drawn_trigger_group_index = module->selected_trigger_group_index;
+        drawn_brightness = settings::rackBrightness;
+        cached_layer->setDirty();
+      }
+    }
   }
 
   void draw(const DrawArgs &args) override
@@ -43,66 +71,63 @@ struct CellularAutomatonDisplay : VoxglitchWidget
 
   void drawLayer(const DrawArgs& args, int layer) override
   {
-  	if (layer == 1)
+  	if (layer == 1 && module)
     {
+      cached_layer->drawCached(args);
+    }
 
-      const auto vg = args.vg;
-
-      // Save the drawing context to restore later
-      nvgSave(vg);
+  	Widget::drawLayer(args, layer);
+  }
 
-      if(module)
+  void drawCells(NVGcontext *vg)
+  {
+    if(module)
+    {
+      for(unsigned int row=0; row < SEQUENCER_ROWS; row++)
       {
-        for(unsigned int row=0; row < SEQUENCER_ROWS; row++)
+        for(unsigned int column=0; column < SEQUENCER_COLUMNS; column++)
         {
-          for(unsigned int column=0; column < SEQUENCER_COLUMNS; column++)
-          {
-            nvgBeginPath(vg);
-            nvgRect(vg, (column * CELL_WIDTH) + (column * CELL_PADDING), (row * CELL_HEIGHT) + (row * CELL_PADDING), CELL_WIDTH, CELL_HEIGHT);
+          nvgBeginPath(vg);
+          nvgRect(vg, (column * CELL_WIDTH) + (column * CELL_PADDING), (row * CELL_HEIGHT) + (row * CELL_PADDING), CELL_WIDTH, CELL_HEIGHT);
 
-            // Default color for inactive square
+          // Default color for inactive square
 
-            float dim = settings::rackBrightness;
-            // unsigned int fill_color = 55.0 - ((1.0 - dim) * 55.0);
+          float dim = settings::rackBrightness;
+          // unsigned int fill_color = 55.0 - ((1.0 - dim) * 55.0);
 
-            // nvgFillColor(vg, nvgRGB(fill_color, fill_color, fill_color));
-            nvgFillColor(vg, brightness(nvgRGBA(55.0, 55.0, 55.0, 230), dim));
+          // nvgFillColor(vg, nvgRGB(fill_color, fill_color, fill_color));
+          nvgFillColor(vg, brightness(nvgRGBA(55.0, 55.0, 55.0, 230), dim));
 
-            // When in edit mode, the pattern that's being edited will be bright white
-            // and the underlying animation will continue to be shown but at a dim gray
-            switch(module->mode)
-            {
-              case PLAY_MODE:
-              if(module->sequencer.seed[row][column]) nvgFillColor(vg, nvgRGB(80, 80, 80));
-              if(module->sequencer.state[row][column]) nvgFillColor(vg, nvgRGB(255, 255, 255));
-              break;
+          // When in edit mode, the pattern that's being edited will be bright white
+          // and the underlying animation will continue to be shown but at a dim gray
+          switch(module->mode)
+          {
+            case PLAY_MODE:
+            if(module->sequencer.seed[row][column]) nvgFillColor(vg, nvgRGB(80, 80, 80));
+            if(module->sequencer.state[row][column]) nvgFillColor(vg, nvgRGB(255, 255, 255));
+            break;
 
-              case EDIT_SEED_MODE:
+            case EDIT_SEED_MODE:
+            if(module->sequencer.state[row][column]) nvgFillColor(vg, nvgRGB(65, 65, 65));
+            if(module->sequencer.seed[row][column]) nvgFillColor(vg, nvgRGB(255, 255, 255));
+            break;
+
+            case EDIT_TRIGGERS_MODE:
+            if(module->selected_trigger_group_index >= 0)
+            {
               if(module->sequencer.state[row][column]) nvgFillColor(vg, nvgRGB(65, 65, 65));
-              if(module->sequencer.seed[row][column]) nvgFillColor(vg, nvgRGB(255, 255, 255));
-              break;
-
-              case EDIT_TRIGGERS_MODE:
-              if(module->selected_trigger_group_index >= 0)
-              {
-                if(module->sequencer.state[row][column]) nvgFillColor(vg, nvgRGB(65, 65, 65));
-                bool cell_contains_trigger = module->sequencer.triggers[module->selected_trigger_group_index][row][column];
-                bool is_triggered = module->sequencer.state[row][column];
-                if(cell_contains_trigger) nvgFillColor(vg, nvgRGB(140, 140, 140));
-                if(cell_contains_trigger && is_triggered) nvgFillColor(vg, nvgRGB(255, 255, 255));
-              }
-              break;
+              bool cell_contains_trigger = module->sequencer.triggers[module->selected_trigger_group_index][row][column];
+              bool is_triggered = module->sequencer.state[row][column];
+              if(cell_contains_trigger) nvgFillColor(vg, nvgRGB(140, 140, 140));
+              if(cell_contains_trigger && is_triggered) nvgFillColor(vg, nvgRGB(255, 255, 255));
             }
-
-            nvgFill(vg);
+            break;
           }
+
+          nvgFill(vg);
         }
       }
-
-      nvgRestore(vg);
     }
-
-  	Widget::drawLayer(args, layer);
   }
 
 
@@ -204,6 +229,8 @@ struct CellularAutomatonDisplay : VoxglitchWidget
     // If the sequencer is at the first step, also update the current "state"
     // The first "state" of the sequencer should always mirror the pattern
     if(module->sequencer.position == 0) module->sequencer.state[row][column] = this->cell_edit_value;
+
+    module->sequencer.revision++;
   }
 
   void onButton(const event::Button &e) override
@@ -235,6 +262,7 @@ struct CellularAutomatonDisplay : VoxglitchWidget
           // drags to set ("paints") additional triggers
           this->cell_edit_value = ! module->sequencer.triggers[module->selected_trigger_group_index][row][column];
           module->sequencer.triggers[module->selected_trigger_group_index][row][column] = this->cell_edit_value;
+          module->sequencer.revision++;
         }
 
         // Store the initial drag position
@@ -269,6 +297,7 @@ struct CellularAutomatonDisplay : VoxglitchWidget
         if(module->mode == EDIT_TRIGGERS_MODE && module->selected_trigger_group_index >= 0)
         {
           module->sequencer.triggers[module->selected_trigger_group_index][row][column] = this->cell_edit_value;
+          module->sequencer.revision++;
         }
 
         old_row = row;
@@ -3,6 +3,11 @@ struct CellularAutomatonSequencer
   unsigned int position = 0;
   unsigned int length = 0;
 
+  // Incremented whenever the seed, state or triggers change, so that the
+  // display knows when to draw them again.  Code which writes to the
+  // patterns directly must increment it too.
+  unsigned int revision = 0;
+
   bool seed[SEQUENCER_ROWS][SEQUENCER_COLUMNS] = {
     { 0,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0 },
     { 0,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,0 },
@@ -133,6 +138,7 @@ struct CellularAutomatonSequencer
   void step(bool *trigger_results)
   {
     position ++;
+    revision ++;
 
     if(position >= length)
     {
@@ -208,6 +214,8 @@ struct CellularAutomatonSequencer
         (*dst)[row][column] = (*src)[row][column];
       }
     }
+
+    revision ++;
   }
 
   void clearPattern(bool (*pattern)[SEQUENCER_ROWS][SEQUENCER_COLUMNS])
@@ -219,6 +227,8 @@ struct CellularAutomatonSequencer
         (*pattern)[row][column] = 0;
       }
     }
+
+    revision ++;
   }
 
   void setLength(unsigned int length)
@@ -279,5 +289,7 @@ struct CellularAutomatonSequencer
         string_index++;
       }
     }
+
+    revision ++;
   }
 };
@@ -12,16 +12,18 @@
 
 #include "Common/constants.h"
 #include "Common/sample.hpp"
+#include "Common/SampleLoader.hpp"
 #include "Common/SamplePlayer.hpp"
 #include "Common/dsp/StereoPan.hpp"
 #include "Common/dsp/StereoFadeIn.hpp"
 #include "Common/dsp/StereoFadeOut.hpp"
+#include "Common/dsp/Random.hpp"
+#include "Common/ExpanderChannel.hpp"
 #include "Common/GrainEngineExpanderMessage.hpp"
 #include "Common/Theme.hpp"
 #include "Common/components/VoxglitchComponents.hpp"
 
 #include "GrainEngineMK2/defines.h"
-#include "GrainEngineMK2/Grain.hpp"
 #include "GrainEngineMK2/GrainManager.hpp"
 #include "GrainEngineMK2/GrainEngineMK2.hpp"
 #include "GrainEngineMK2/GrainEngineMK2LoadSample.hpp"
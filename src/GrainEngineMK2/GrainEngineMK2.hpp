@@ -2,16 +2,20 @@
 // TODO: Provide options for different window max and min
 //
 
+//
+// The LoadQueue keeps track of a sample, requested by the expander, which
+// is being loaded in the background.  The new sample isn't swapped in until
+// the output has faded out.
+//
+
 struct LoadQueue
 {
   bool sample_queued_for_loading = false;
-  std::string path_to_file = "";
   unsigned int sample_number = 0;
 
-  void queue_sample_for_loading(std::string path_to_file, unsigned int sample_number)
+  void queue_sample_for_loading(unsigned int sample_number)
   {
     this->sample_queued_for_loading = true;
-    this->path_to_file = path_to_file;
     this->sample_number = sample_number;
   }
 };
@@ -26,13 +30,13 @@ struct GrainEngineMK2 : VoxglitchSamplerModule
   float smooth_rate = 0;
   int spawn_throttling_countdown = 0;
   unsigned int selected_waveform = 0;
-	std::string loaded_filenames[NUMBER_OF_SAMPLES];
+  bool extended_grain_limit = false;  // When true, the Grains knob goes up to EXTENDED_MAX_GRAINS
 	std::string root_dir;
-	std::string path;
   float pan = 0;
   LoadQueue load_queue;
   StereoFadeOut stereo_fade_out;
   StereoFadeIn stereo_fade_in;
+  Random random;
 
   // Structs
   SamplePlayer sample_players[NUMBER_OF_SAMPLES];
@@ -83,8 +87,9 @@ struct GrainEngineMK2 : VoxglitchSamplerModule
     NUM_LIGHTS
   };
 
-  GrainEngineExpanderMessage *producer_message = new GrainEngineExpanderMessage;
-  GrainEngineExpanderMessage *consumer_message = new GrainEngineExpanderMessage;
+  // Messages from the expander, telling this module about new recordings
+  GrainEngineExpanderChannel expander_channel;
+  GrainEngineExpanderMessage expander_message;
 
 
 
@@ -115,20 +120,15 @@ struct GrainEngineMK2 : VoxglitchSamplerModule
     configParam(SAMPLE_KNOB, 0.0f, 1.0f, 0.0f, "SampleKnob");
     configParam(SAMPLE_ATTN_KNOB, 0.0f, 1.0f, 0.0f, "SampleAttnKnob");
 
-    std::fill_n(loaded_filenames, NUMBER_OF_SAMPLES, "[ EMPTY ]");
-
-    // leftExpander.producerMessage = producer_message;
-    // leftExpander.consumerMessage = consumer_message;
-
-    rightExpander.producerMessage = producer_message;
-    rightExpander.consumerMessage = consumer_message;
+    expander_channel.attach(rightExpander);
 
   }
 
   ~GrainEngineMK2()
   {
-    delete producer_message;
-    delete consumer_message;
+    // Recordings which were never picked up hold load requests
+    while(expander_channel.receive(expander_message)) expander_message.request->release();
+
     /*
     for(unsigned int i=0; i<NUMBER_OF_SAMPLES; i++)
     {
@@ -147,6 +147,8 @@ struct GrainEngineMK2 : VoxglitchSamplerModule
 			json_object_set_new(root, ("loaded_sample_path_" + std::to_string(i+1)).c_str(), json_string(sample_players[i].getPath().c_str()));
 		}
 
+    json_object_set_new(root, "extended_grain_limit", json_boolean(extended_grain_limit));
+
     // Save bipolar pitch mode
     // json_object_set_new(root, "bipolar_pitch_mode", json_integer(bipolar_pitch_mode));
 
@@ -160,11 +162,14 @@ struct GrainEngineMK2 : VoxglitchSamplerModule
 			json_t *loaded_sample_path = json_object_get(root, ("loaded_sample_path_" +  std::to_string(i+1)).c_str());
 			if (loaded_sample_path)
 			{
-				sample_players[i].loadSample(json_string_value(loaded_sample_path));
-				loaded_filenames[i] = sample_players[i].getFilename();
+        // The sample is loaded in the background and swapped in by process()
+				sample_players[i].loadSampleAsync(json_string_value(loaded_sample_path));
 			}
 		}
 
+    json_t *extended_grain_limit_json = json_object_get(root, "extended_grain_limit");
+    if (extended_grain_limit_json) extended_grain_limit = json_is_true(extended_grain_limit_json);
+
     // Load bipolar pitch mode
     /*
     json_t* bipolar_pitch_mode_json = json_object_get(root, "bipolar_pitch_mode");
@@ -174,8 +179,7 @@ struct GrainEngineMK2 : VoxglitchSamplerModule
 
   float randomFloat(float min, float max)
   {
-    float r = (float)rand() / (float)RAND_MAX;
-    return(min + r * (max - min));
+    return(random.uniform(min, max));
   }
 
   float calculate_inputs(int input_index, int knob_index, int attenuator_index, float low_range, float high_range)
@@ -257,24 +261,35 @@ struct GrainEngineMK2 : VoxglitchSamplerModule
 
     this->processExpander();
 
+    // Samples loaded from the context menu or from a saved patch are swapped
+    // in as soon as the background loader has finished with them.
+    for(unsigned int i=0; i<NUMBER_OF_SAMPLES; i++)
+    {
+      if(load_queue.sample_queued_for_loading && (load_queue.sample_number == i)) continue;
+      if(sample_players[i].acceptLoadedSample()) sampleLoaded(i);
+    }
+
     if(load_queue.sample_queued_for_loading)
     {
+      SamplePlayer *queued_sample_player = &sample_players[load_queue.sample_number];
+
       // If either there's no loaded sample in the sample slot, or the fade out
-      // of the existing sample has completed then load the new sample and start fading in.
-      if((stereo_fade_out.isFadingOut() == false) || (sample_players[load_queue.sample_number].isLoaded() == false))
+      // of the existing sample has completed then swap in the new sample and start fading in.
+      if((stereo_fade_out.isFadingOut() == false) || (queued_sample_player->isLoaded() == false))
       {
-        // dequeue the request.  We're going to process it right now!
-        load_queue.sample_queued_for_loading = false;
-
-        // Load the sample!
-        sample_players[load_queue.sample_number].loadSample(load_queue.path_to_file);
-        std::string path = sample_players[load_queue.sample_number].getPath();
-
-        this->root_dir = path; // This is used by the widget class
-        this->path = path;     // This is used by the widget class
-        loaded_filenames[load_queue.sample_number] = sample_players[load_queue.sample_number].getFilename();
-
-        stereo_fade_in.trigger();
+        if(queued_sample_player->acceptLoadedSample())
+        {
+          // dequeue the request.  The new sample is in place.
+          load_queue.sample_queued_for_loading = false;
+          sampleLoaded(load_queue.sample_number);
+          stereo_fade_in.trigger();
+        }
+        else if(queued_sample_player->isLoading() == false)
+        {
+          // The sample couldn't be loaded, so fade the old one back in
+          load_queue.sample_queued_for_loading = false;
+          stereo_fade_in.trigger();
+        }
       }
     }
 
@@ -284,8 +299,9 @@ struct GrainEngineMK2 : VoxglitchSamplerModule
     if(sample_players[selected_sample_index].isLoaded() == false) return;
 
     // Process Max Grains knob
-    unsigned int max_grains = calculate_inputs(GRAINS_INPUT, GRAINS_KNOB, GRAINS_ATTN_KNOB, MAX_GRAINS);
-    max_grains = clamp(max_grains, 0, MAX_GRAINS);
+    unsigned int grain_limit = extended_grain_limit ? EXTENDED_MAX_GRAINS : MAX_GRAINS;
+    unsigned int max_grains = calculate_inputs(GRAINS_INPUT, GRAINS_KNOB, GRAINS_ATTN_KNOB, grain_limit);
+    max_grains = clamp(max_grains, 0, grain_limit);
 
     // Process window (width of the grains) inputs
     float window_knob_value = calculate_inputs(WINDOW_INPUT, WINDOW_KNOB, WINDOW_ATTN_KNOB, 1.0, 6400.0);
@@ -317,13 +333,13 @@ struct GrainEngineMK2 : VoxglitchSamplerModule
     // If jitter_spread is 124, then the jitter will be between -124 and 124.
 
     // In this case, I experimented with using FastRandom, but at sample speed,
-    // it generated a repeating pattern that could be heard clearly.  So, instead
-    // of saving the CPU cycles, in this case I decided to stick with rand(), 
-    // which didn't produce any audible repitition.
+    // it generated a repeating pattern that could be heard clearly.  Random
+    // (see Common/dsp/Random.hpp) has a period of 2^128 - 1, so it's both
+    // cheap and free of audible repetition.
     if(jitter_spread > 0) start_position += this->randomFloat(-1 * jitter_spread, jitter_spread);
   
 
-    // In Grain.hpp, it is ensured that start_position stays within the sample array length
+    // In GrainManager.hpp, it is ensured that start_position stays within the sample array length
     // This is ensured again in sample.h
     // Therefore, we don't jump through any hoops here to clamp the start_position
 
@@ -369,6 +385,13 @@ struct GrainEngineMK2 : VoxglitchSamplerModule
       if(stereo_fade_in.isFadingIn()) stereo_fade_in.process(&left_mix_output, &right_mix_output, 100.0 * APP->engine->getSampleTime()); // 1/100th of a second
       if(stereo_fade_out.isFadingOut()) stereo_fade_out.process(&left_mix_output, &right_mix_output, 100.0 * APP->engine->getSampleTime()); // 1/100th of a second
 
+      // Stay silent between the end of the fade out and the new sample arriving
+      else if(load_queue.sample_queued_for_loading)
+      {
+        left_mix_output = 0;
+        right_mix_output = 0;
+      }
+
       // Send audio to outputs
       outputs[AUDIO_OUTPUT_LEFT].setVoltage(left_mix_output);
       outputs[AUDIO_OUTPUT_RIGHT].setVoltage(right_mix_output);
@@ -383,38 +406,32 @@ struct GrainEngineMK2 : VoxglitchSamplerModule
     // if (leftExpander.module && leftExpander.module->model == modelGrainEngineMK2Expander)
     if (rightExpander.module && rightExpander.module->model == modelGrainEngineMK2Expander)
     {
-      // Receive message from expander
-      // GrainEngineExpanderMessage *expander_message = (GrainEngineExpanderMessage *) leftExpander.producerMessage;
-      GrainEngineExpanderMessage *expander_message = (GrainEngineExpanderMessage *) rightExpander.producerMessage;
-
-      if(expander_message->message_received == false)
+      // Receive messages from the expander.  Only one sample is swapped in
+      // at a time, so further recordings wait in the channel until the
+      // previous one is in place.
+      while(! load_queue.sample_queued_for_loading && expander_channel.receive(expander_message))
       {
-        // Retrieve the path name
-        std::string filename = expander_message->filename;
-        std::string path = expander_message->path;
-
-        if(filename != "")
-        {
-          // Retrieve the sample slot
-          unsigned int sample_slot = expander_message->sample_slot;
-          sample_slot = clamp(sample_slot, 0, 4);
-
-          std::string path_to_file = path + "/" + filename;
+        if(! expander_message.request) continue;
 
-          // Queue sample for loading
-          load_queue.queue_sample_for_loading(path_to_file, sample_slot);
-          stereo_fade_out.trigger();
-        }
+        // Retrieve the sample slot
+        unsigned int sample_slot = expander_message.sample_slot;
+        sample_slot = clamp(sample_slot, 0, 4);
 
-        // Set the received flag so we don't process the message every single frame
-        expander_message->message_received = true;
+        // The expander's recorder has already asked the loader for the
+        // recording.  It will be swapped in once the fade out has completed.
+        sample_players[sample_slot].postLoadRequest(expander_message.request);
+        load_queue.queue_sample_for_loading(sample_slot);
+        stereo_fade_out.trigger();
       }
-
-      // leftExpander.messageFlipRequested = true;
-      rightExpander.messageFlipRequested = true;
     }
   }
 
+  // Called after a sample has been swapped into one of the sample players
+  void sampleLoaded(unsigned int sample_number)
+  {
+    updateSampleRateDivision();
+  }
+
   void onSampleRateChange(const SampleRateChangeEvent& e) override
   {
     for(unsigned int i=0; i<NUMBER_OF_SAMPLES; i++)
@@ -34,10 +34,10 @@ struct GrainEngineMK2LoadSample : MenuItem
 			module->updateSampleRateDivision();
 			module->setRoot(filename);
 			*/
-			module->sample_players[sample_number].loadSample(filename);
-			module->loaded_filenames[sample_number] = module->sample_players[sample_number].getFilename();
-			module->updateSampleRateDivision();
-			module->setRoot(filename);		
+			// The sample is loaded in the background and swapped in by process()
+			module->sample_players[sample_number].loadSampleAsync(filename);
+			module->root_dir = filename;
+			module->setRoot(filename);
 		}
 	}
 };
@@ -81,6 +81,16 @@ struct GrainEngineMK2Widget : VoxglitchModuleWidget
   };
   */
 
+  // The Grains knob normally goes up to MAX_GRAINS.  Many more grains than
+  // that can overload slower computers, so the higher limit is opt-in.
+  struct ExtendedGrainLimitMenuItem : MenuItem {
+    GrainEngineMK2 *module;
+
+    void onAction(const event::Action &e) override {
+      module->extended_grain_limit ^= true;
+    }
+  };
+
   void appendContextMenu(Menu *menu) override
   {
     GrainEngineMK2 *module = dynamic_cast<GrainEngineMK2*>(this->module);
@@ -97,10 +107,15 @@ struct GrainEngineMK2Widget : VoxglitchModuleWidget
 		{
 			GrainEngineMK2LoadSample *menu_item_load_sample = new GrainEngineMK2LoadSample();
 			menu_item_load_sample->sample_number = i;
-			menu_item_load_sample->text = std::to_string(i+1) + ": " + module->loaded_filenames[i];
+			std::string filename = module->sample_players[i].getFilename();
+			menu_item_load_sample->text = std::to_string(i+1) + ": " + (filename == "" ? "[ EMPTY ]" : filename);
 			menu_item_load_sample->module = module;
 			menu->addChild(menu_item_load_sample);
 		}
 
+    menu->addChild(new MenuEntry); // For spacing only
+    ExtendedGrainLimitMenuItem *extended_grain_limit_menu_item = createMenuItem<ExtendedGrainLimitMenuItem>("Extended grain limit (" + std::to_string(EXTENDED_MAX_GRAINS) + " grains)", CHECKMARK(module->extended_grain_limit));
+    extended_grain_limit_menu_item->module = module;
+    menu->addChild(extended_grain_limit_menu_item);
   }
 };
@@ -1,12 +1,43 @@
+//
+// GrainManager
+//
+// Grains are stored as a structure of arrays: each per-grain field has its
+// own array, indexed by grain.  Live grains are always packed into the
+// first grain_array_length slots.  When a grain dies, the last live grain
+// is moved into its slot, so process() only ever touches live grains, and
+// only the fields it needs.
+//
+// The envelope and panning are computed four grains at a time using
+// rack::simd::float_4.  Rather than dividing age by lifespan for every grain
+// on every frame, each grain's envelope phase is stepped by a precomputed
+// increment, and its panning is turned into left and right gains once, when
+// the grain is added.  Sample and contour reads are gathered one lane at a
+// time, as they come from different places in memory.
+//
+
 struct GrainManager
 {
-    Grain grain_array[MAX_GRAINS];
-    Grain grain_array_tmp[MAX_GRAINS];
+    // Per-grain fields
+    double positions[EXTENDED_MAX_GRAINS + 4];           // Playback position in the sample
+    float step_amounts[EXTENDED_MAX_GRAINS + 4];
+    unsigned int ages[EXTENDED_MAX_GRAINS + 4];          // Counts down from lifespan to 0
+    Sample *samples[EXTENDED_MAX_GRAINS + 4];
+
+    // Per-grain fields which are processed four grains at a time
+    float envelope_phases[EXTENDED_MAX_GRAINS + 4];      // Runs from 0 to 1 over the life of the grain
+    float envelope_increments[EXTENDED_MAX_GRAINS + 4];  // 1 / lifespan
+    float left_gains[EXTENDED_MAX_GRAINS + 4];
+    float right_gains[EXTENDED_MAX_GRAINS + 4];
+
     unsigned int grain_array_length = 0;
-    // Common *common;
 
     GrainManager()
     {
+      // Unused lanes are still multiplied in process(), so keep them finite
+      std::fill_n(envelope_phases, EXTENDED_MAX_GRAINS + 4, 0.0f);
+      std::fill_n(envelope_increments, EXTENDED_MAX_GRAINS + 4, 0.0f);
+      std::fill_n(left_gains, EXTENDED_MAX_GRAINS + 4, 0.0f);
+      std::fill_n(right_gains, EXTENDED_MAX_GRAINS + 4, 0.0f);
     }
 
     virtual ~GrainManager() {
@@ -30,54 +61,103 @@ struct GrainManager
 
     virtual void addGrain(double start_position, unsigned int lifespan, float pan, Sample *sample_ptr, unsigned int max_grains, float step_amount)
     {
-        if(grain_array_length > max_grains || (grain_array_length >= (MAX_GRAINS - 1))) return;
+        if(grain_array_length > max_grains || grain_array_length >= EXTENDED_MAX_GRAINS) return;
         if(lifespan == 0) return;
 
-        Grain grain;
+        unsigned int i = grain_array_length;
 
-        // Configure grain for playback
-        grain.start_position = start_position;
-        grain.sample_ptr = sample_ptr;
-        grain.lifespan = lifespan;
-        grain.age = lifespan;
-        grain.pan = pan;
-        grain.step_amount = step_amount;
+        positions[i] = (float) start_position;
+        step_amounts[i] = step_amount;
+        ages[i] = lifespan;
+        samples[i] = sample_ptr;
 
-        grain_array[grain_array_length] = grain;
+        envelope_phases[i] = 0.0;
+        envelope_increments[i] = 1.0 / (float) lifespan;
+
+        // The same panning law as StereoPan, which only ever turns one side down
+        left_gains[i] = (pan > 0) ? (1.0 - pan) : 1.0;
+        right_gains[i] = (pan < 0) ? (1.0 + pan) : 1.0;
 
         grain_array_length ++;
     }
 
+    // Move the last live grain into slot _i_
+    void removeGrain(unsigned int i)
+    {
+        unsigned int last = grain_array_length - 1;
+
+        positions[i] = positions[last];
+        step_amounts[i] = step_amounts[last];
+        ages[i] = ages[last];
+        samples[i] = samples[last];
+        envelope_phases[i] = envelope_phases[last];
+        envelope_increments[i] = envelope_increments[last];
+        left_gains[i] = left_gains[last];
+        right_gains[i] = right_gains[last];
+
+        grain_array_length = last;
+    }
+
     virtual std::pair<float, float> process()
     {
-        float left_mix_output = 0;
-        float right_mix_output = 0;
-        unsigned int grain_array_tmp_length = 0;
+        simd::float_4 left_mix_output = 0.f;
+        simd::float_4 right_mix_output = 0.f;
 
         //
-        // Process grains
+        // Process grains, four at a time
         // ---------------------------------------------------------------------
 
-        for (unsigned int i=0; i < grain_array_length; i++)
+        for (unsigned int i = 0; i < grain_array_length; i += 4)
         {
-            if(grain_array[i].erase_me == false)
-            {
-                std::pair<float, float> stereo_output = grain_array[i].getStereoOutput();
-                left_mix_output  += stereo_output.first;
-                right_mix_output += stereo_output.second;
+            unsigned int lanes = std::min(4u, grain_array_length - i);
 
-                grain_array[i].step();
+            simd::float_4 envelope_phase = simd::float_4::load(&envelope_phases[i]);
+            simd::float_4 contour_position = simd::clamp(envelope_phase * 512.f, 0.f, 511.f);
 
-                grain_array_tmp[grain_array_tmp_length] = grain_array[i];
-                grain_array_tmp_length++;
+            simd::float_4 left_audio = 0.f;
+            simd::float_4 right_audio = 0.f;
+            simd::float_4 contour = 0.f;
+
+            for (unsigned int lane = 0; lane < lanes; lane++)
+            {
+                unsigned int grain = i + lane;
+                unsigned int sample_size = samples[grain]->size();
+
+                if (sample_size > 0)
+                {
+                    // The position wraps around the end of the sample
+                    if (positions[grain] >= sample_size) positions[grain] = fmod(positions[grain], sample_size);
+
+                    float left, right;
+                    samples[grain]->read(positions[grain], &left, &right);
+                    left_audio[lane] = left;
+                    right_audio[lane] = right;
+                }
+
+                positions[grain] += step_amounts[grain];
+                contour[lane] = CONTOUR[(int) contour_position[lane]];
             }
+
+            left_mix_output += left_audio * contour * simd::float_4::load(&left_gains[i]);
+            right_mix_output += right_audio * contour * simd::float_4::load(&right_gains[i]);
+
+            (envelope_phase + simd::float_4::load(&envelope_increments[i])).store(&envelope_phases[i]);
         }
 
-        std::swap(grain_array, grain_array_tmp);
-        grain_array_length = grain_array_tmp_length;
+        // Age the grains and remove the ones which have reached the end of
+        // their life.  The grain moved into a freed slot is checked next.
+        unsigned int i = 0;
+
+        while (i < grain_array_length)
+        {
+            if (! --ages[i]) removeGrain(i);
+            else i++;
+        }
 
+        float left_mix = left_mix_output[0] + left_mix_output[1] + left_mix_output[2] + left_mix_output[3];
+        float right_mix = right_mix_output[0] + right_mix_output[1] + right_mix_output[2] + right_mix_output[3];
 
-        return {left_mix_output, right_mix_output};
+        return {left_mix, right_mix};
     }
 
 };
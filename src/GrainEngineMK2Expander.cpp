@@ -8,6 +8,9 @@
 
 #include "Common/constants.h"
 #include "Common/sample.hpp"
+#include "Common/SampleLoader.hpp"
+#include "Common/ExpanderChannel.hpp"
+#include "Common/WavRecorder.hpp"
 #include "Common/GrainEngineExpanderMessage.hpp"
 #include "Common/Theme.hpp"
 #include "Common/components/VoxglitchComponents.hpp"
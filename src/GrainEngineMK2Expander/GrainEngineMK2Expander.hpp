@@ -7,7 +7,9 @@ struct GrainEngineMK2Expander : Module
   std::string patch_uuid = "";
   bool recording = false;
 
-  Sample *sample = new Sample();
+  // Recordings are streamed to disk in the background.  See WavRecorder.hpp.
+  WavRecorder *recorder = NULL;
+  WavRecorder::Recording finished_recording;
 
   enum ParamIds {
     RECORD_START_BUTTON_PARAM,
@@ -49,12 +51,18 @@ struct GrainEngineMK2Expander : Module
     {
       system::createDirectory(path);
     }
+
+    recorder = new WavRecorder(path);
+
+    // Recordings are named after the patch.  This is replaced by the saved
+    // value in dataFromJson(), but is needed for new modules.
+    patch_uuid = random_string(12);
   }
 
   // Destructor
   ~GrainEngineMK2Expander()
   {
-    delete sample;
+    delete recorder;
   }
 
   json_t *dataToJson() override
@@ -95,17 +103,17 @@ struct GrainEngineMK2Expander : Module
       {
         if(start_recording)
         {
-          sample->initialize_recording();
-          recording = true;
+          recorder->start(args.sampleRate);
+          recording = recorder->isRecording();
         }
 
         if(recording)
         {
-          sample->record_audio(left, right);
+          recorder->record(left, right);
         }
       }
 
-      if(stop_recording)
+      if(stop_recording && recording)
       {
         recording = false;
 
@@ -114,23 +122,26 @@ struct GrainEngineMK2Expander : Module
         sample_slot += params[SAMPLE_SLOT_KNOB_PARAM].getValue();
         sample_slot = clamp(sample_slot, 0, 4);
 
-        // Build up a filename for the .wav file in the format grain_engine_[patch_uuid]_s[sample_slot].wave
-        if(patch_uuid == "") patch_uuid = random_string(12);
-        std::string path = asset::user(WAV_FOLDER_NAME);
-        std::string filename = "grain_engine_" + patch_uuid + "_s" + std::to_string(sample_slot) + ".wav";
+        // Build up a filename for the .wav file in the format grain_engine_[patch_uuid]_s[sample_slot].wav
+        char filename[WavRecorder::FILENAME_LENGTH];
+        snprintf(filename, sizeof(filename), "grain_engine_%s_s%u.wav", patch_uuid.c_str(), sample_slot);
 
-        // Prepare message for sending to Grain Engine MK2
-        // GrainEngineExpanderMessage *message_to_grain_engine = (GrainEngineExpanderMessage *) rightExpander.module->leftExpander.producerMessage;
-        GrainEngineExpanderMessage *message_to_grain_engine = (GrainEngineExpanderMessage *) leftExpander.module->rightExpander.producerMessage;
-        message_to_grain_engine->sample_slot = sample_slot;
-        message_to_grain_engine->path = path;
-        message_to_grain_engine->filename = filename;
+        // The file is saved, and then loaded, in the background.  Grain
+        // Engine MK2 is told about it below, once it's saved.
+        recorder->stop(filename, sample_slot);
+      }
 
-        // Save the recorded audio to disk
-        sample->save_recorded_audio(path + "/" + filename);
+      // Send a message to Grain Engine MK2 once a recording has been saved.
+      // Recordings are left with the recorder until there's room in the
+      // channel, so none are lost.
+      GrainEngineExpanderChannel *channel = GrainEngineExpanderChannel::find(leftExpander.module->rightExpander);
 
-        // Tell Grain Engine MK2 that the message is ready for receiving
-        message_to_grain_engine->message_received = false;
+      if(channel && ! channel->full() && recorder->takeFinished(finished_recording))
+      {
+        GrainEngineExpanderMessage message;
+        message.sample_slot = finished_recording.tag;
+        message.request = finished_recording.request;
+        channel->send(message);
       }
 
       outputs[PASSTHROUGH_LEFT].setVoltage(left);
@@ -16,7 +16,6 @@
 
 #include "GrainFx/defines.h"
 #include "GrainFx/SimpleTableOsc.hpp"
-#include "GrainFx/Grain.hpp"
 #include "GrainFx/GrainFxCore.hpp"
 #include "GrainFx/GrainFx.hpp"
 #include "GrainFx/GrainFxWidget.hpp"
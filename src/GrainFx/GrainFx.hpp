@@ -5,8 +5,9 @@ struct GrainFx : VoxglitchModule
   float smooth_rate = 0;
   unsigned int spawn_throttling_countdown = 0;
   float max_grains = 0;
+  bool extended_grain_limit = false;  // When true, the Grains knob goes up to EXTENDED_MAX_GRAINS
   unsigned int selected_waveform = 0;
-  unsigned int buffering_counter = MAX_BUFFER_SIZE;
+  unsigned int buffering_counter = 0;
 
   // Structs
   AudioBuffer audio_buffer;
@@ -109,16 +110,30 @@ struct GrainFx : VoxglitchModule
     configParam(INTERNAL_MODULATION_OUTPUT_POLARITY_SWITCH, 0.0f, 1.0f, 0.0f, "InternalModulationOutputPolaritySwitch");
 
     grain_fx_core.common = &common;
+
+    audio_buffer.setSampleRate(APP->engine->getSampleRate());
+    buffering_counter = audio_buffer.getBufferSize();
+  }
+
+  void onSampleRateChange(const SampleRateChangeEvent &e) override
+  {
+    // The buffer may start over, empty, at the new rate
+    audio_buffer.setSampleRate(e.sampleRate);
+    buffering_counter = audio_buffer.getBufferSize();
+    lights[BUFFERING_GREEN_LIGHT].setBrightness(0.0);
   }
 
   json_t *dataToJson() override
   {
     json_t *root = json_object();
+    json_object_set_new(root, "extended_grain_limit", json_boolean(extended_grain_limit));
 		return root;
   }
 
   void dataFromJson(json_t *root) override
   {
+    json_t *extended_grain_limit_json = json_object_get(root, "extended_grain_limit");
+    if (extended_grain_limit_json) extended_grain_limit = json_is_true(extended_grain_limit_json);
   }
 
   float calculate_inputs(int input_index, int knob_index, int attenuator_index, float low_range, float high_range)
@@ -169,7 +184,7 @@ struct GrainFx : VoxglitchModule
     audio_buffer.push(inputs[AUDIO_INPUT_LEFT].getVoltage(), inputs[AUDIO_INPUT_RIGHT].getVoltage());
 
     // Process Max Grains knob
-    this->max_grains = calculate_inputs(GRAINS_INPUT, GRAINS_KNOB, GRAINS_ATTN_KNOB, MAX_GRAINS);
+    this->max_grains = calculate_inputs(GRAINS_INPUT, GRAINS_KNOB, GRAINS_ATTN_KNOB, extended_grain_limit ? EXTENDED_MAX_GRAINS : MAX_GRAINS);
 
     // Process inputs for the selection of waveforms
     selected_waveform = calculate_inputs(INTERNAL_MODULATION_WAVEFORM_INPUT, INTERNAL_MODULATION_WAVEFORM_KNOB, INTERNAL_MODULATION_WAVEFORM_ATTN_KNOB, 4.99);
@@ -230,7 +245,7 @@ struct GrainFx : VoxglitchModule
     // allow for the addition of the jitter without pushing the start_position out of
     // range of the buffer size.  Also leave room for the window length so that
     // none of the grains reaches the end of the buffer.
-    start_position = common.rescaleWithPadding(start_position, 0.0, 1.0, 0.0, MAX_BUFFER_SIZE, jitter_spread, jitter_spread + window_length);
+    start_position = common.rescaleWithPadding(start_position, 0.0, 1.0, 0.0, audio_buffer.getBufferSize(), jitter_spread, jitter_spread + window_length);
     start_position += jitter;
 
     //
@@ -321,7 +336,7 @@ struct GrainFx : VoxglitchModule
     if(buffering_counter > 0)
     {
       buffering_counter--;
-      lights[BUFFERING_RED_LIGHT].setBrightness(1.0 - ((float) buffering_counter / (float) MAX_BUFFER_SIZE));
+      lights[BUFFERING_RED_LIGHT].setBrightness(1.0 - ((float) buffering_counter / (float) audio_buffer.getBufferSize()));
 
       if(buffering_counter == 0)
       {
@@ -1,12 +1,42 @@
+//
+// GrainFxCore
+//
+// Grains are stored as a structure of arrays: each per-grain field has its
+// own array, indexed by grain.  Live grains are always packed into the
+// first grain_array_length slots.  When a grain dies, the last live grain
+// is moved into its slot, so process() only ever touches live grains, and
+// only the fields it needs.
+//
+// The envelope and panning are computed four grains at a time using
+// rack::simd::float_4, with a precomputed envelope increment and pan gains
+// for each grain.  See GrainEngineMK2/GrainManager.hpp, which works the
+// same way.
+//
+
 struct GrainFxCore
 {
-    Grain grain_array[MAX_GRAINS + 1];
-    Grain grain_array_tmp[MAX_GRAINS + 1];
+    // Per-grain fields
+    double positions[EXTENDED_MAX_GRAINS + 4];            // Playback position relative to the buffer's read head
+    double pitches[EXTENDED_MAX_GRAINS + 4];
+    unsigned int ages[EXTENDED_MAX_GRAINS + 4];           // Counts down from lifespan to 0
+    AudioBuffer *buffers[EXTENDED_MAX_GRAINS + 4];
+
+    // Per-grain fields which are processed four grains at a time
+    float envelope_phases[EXTENDED_MAX_GRAINS + 4];       // Runs from 0 to 1 over the life of the grain
+    float envelope_increments[EXTENDED_MAX_GRAINS + 4];   // 1 / lifespan
+    float left_gains[EXTENDED_MAX_GRAINS + 4];
+    float right_gains[EXTENDED_MAX_GRAINS + 4];
+
     unsigned int grain_array_length = 0;
     Common *common;
 
     GrainFxCore()
     {
+        // Unused lanes are still multiplied in process(), so keep them finite
+        std::fill_n(envelope_phases, EXTENDED_MAX_GRAINS + 4, 0.0f);
+        std::fill_n(envelope_increments, EXTENDED_MAX_GRAINS + 4, 0.0f);
+        std::fill_n(left_gains, EXTENDED_MAX_GRAINS + 4, 0.0f);
+        std::fill_n(right_gains, EXTENDED_MAX_GRAINS + 4, 0.0f);
     }
 
     virtual ~GrainFxCore() {
@@ -25,53 +55,126 @@ struct GrainFxCore
 
     virtual void add(double start_position, unsigned int lifespan, double pan, AudioBuffer *buffer_ptr, unsigned int max_grains, double pitch)
     {
-        if(grain_array_length > max_grains) return;
+        if(grain_array_length > max_grains || grain_array_length >= EXTENDED_MAX_GRAINS) return;
         if(lifespan == 0) return;
 
-        Grain grain;
+        unsigned int i = grain_array_length;
+
+        positions[i] = start_position;
+        pitches[i] = pitch;
+        ages[i] = lifespan;
+        buffers[i] = buffer_ptr;
+
+        envelope_phases[i] = 0.0;
+        envelope_increments[i] = 1.0 / (float) lifespan;
 
-        // Configure grain for playback
-        grain.start_position = start_position;
-        grain.buffer_ptr = buffer_ptr;
-        grain.lifespan = lifespan;
-        grain.age = lifespan;
-        grain.pan = pan;
-        grain.pitch = pitch;
-        grain.common = common;
+        // The same panning law as StereoPan, which only ever turns one side down
+        left_gains[i] = (pan > 0) ? (1.0 - pan) : 1.0;
+        right_gains[i] = (pan < 0) ? (1.0 + pan) : 1.0;
 
-        grain_array[grain_array_length] = grain;
         grain_array_length ++;
+
+        // Grains which start outside of the buffer are never heard
+        if(! isInsideBuffer(i)) remove(i);
+    }
+
+    bool isInsideBuffer(unsigned int i)
+    {
+        return(positions[i] >= 0 && positions[i] < buffers[i]->getBufferSize());
+    }
+
+    // Move the last live grain into slot _i_
+    void remove(unsigned int i)
+    {
+        unsigned int last = grain_array_length - 1;
+
+        positions[i] = positions[last];
+        pitches[i] = pitches[last];
+        ages[i] = ages[last];
+        buffers[i] = buffers[last];
+        envelope_phases[i] = envelope_phases[last];
+        envelope_increments[i] = envelope_increments[last];
+        left_gains[i] = left_gains[last];
+        right_gains[i] = right_gains[last];
+
+        grain_array_length = last;
+    }
+
+    // Reads the frame under each of the _lanes_ grains starting at _i_.
+    // Neighbouring grains which share a buffer (in GrainFx, all of them) are
+    // read with a single call.
+    void readFrames(unsigned int i, unsigned int lanes, float *left, float *right)
+    {
+        unsigned int lane = 0;
+
+        while (lane < lanes)
+        {
+            unsigned int run = 1;
+            while ((lane + run < lanes) && (buffers[i + lane + run] == buffers[i + lane])) run++;
+
+            buffers[i + lane]->getStereoBlock(&positions[i + lane], run, left + lane, right + lane);
+            lane += run;
+        }
     }
 
     virtual std::pair<float, float> process(float smooth_rate, unsigned int contour_selection)
     {
-        float left_mix_output = 0;
-        float right_mix_output = 0;
-        unsigned int grain_array_tmp_length = 0;
+        simd::float_4 left_mix_output = 0.f;
+        simd::float_4 right_mix_output = 0.f;
+
+        const float *contour_table = common->CONTOURS[contour_selection];
 
         //
-        // Process grains
+        // Process grains, four at a time
         // ---------------------------------------------------------------------
 
-        for (unsigned int i=0; i < grain_array_length; i++)
+        for (unsigned int i = 0; i < grain_array_length; i += 4)
         {
-            if(grain_array[i].erase_me == false)
-            {
-                std::pair<float, float> stereo_output = grain_array[i].getStereoOutput(contour_selection);
-                left_mix_output  += stereo_output.first;
-                right_mix_output += stereo_output.second;
+            unsigned int lanes = std::min(4u, grain_array_length - i);
 
-                grain_array[i].step();
+            simd::float_4 envelope_phase = simd::float_4::load(&envelope_phases[i]);
+            simd::float_4 contour_position = simd::clamp(envelope_phase * 512.f, 0.f, 511.f);
+
+            float left_frames[4] = {0.f, 0.f, 0.f, 0.f};
+            float right_frames[4] = {0.f, 0.f, 0.f, 0.f};
+            readFrames(i, lanes, left_frames, right_frames);
+
+            simd::float_4 left_audio = simd::float_4::load(left_frames);
+            simd::float_4 right_audio = simd::float_4::load(right_frames);
+            simd::float_4 contour = 0.f;
+
+            for (unsigned int lane = 0; lane < lanes; lane++)
+            {
+                unsigned int grain = i + lane;
 
-                grain_array_tmp[grain_array_tmp_length] = grain_array[i];
-                grain_array_tmp_length++;
+                positions[grain] += pitches[grain];
+                contour[lane] = contour_table[(int) contour_position[lane]];
             }
+
+            left_mix_output += left_audio * contour * simd::float_4::load(&left_gains[i]);
+            right_mix_output += right_audio * contour * simd::float_4::load(&right_gains[i]);
+
+            (envelope_phase + simd::float_4::load(&envelope_increments[i])).store(&envelope_phases[i]);
+        }
+
+        // Remove grains which have reached the end of their life or have
+        // played past the end of the buffer.  The grain moved into a freed
+        // slot is checked next.
+        //
+        // NOTE: Ideally, the sample position should be reaching the total sample
+        // count (or length) exactly as an applied amp envelope is reaching 0
+        unsigned int i = 0;
+
+        while (i < grain_array_length)
+        {
+            if ((! --ages[i]) || (! isInsideBuffer(i))) remove(i);
+            else i++;
         }
 
-        std::swap(grain_array, grain_array_tmp);
-        grain_array_length = grain_array_tmp_length;
+        float left_mix = left_mix_output[0] + left_mix_output[1] + left_mix_output[2] + left_mix_output[3];
+        float right_mix = right_mix_output[0] + right_mix_output[1] + right_mix_output[2] + right_mix_output[3];
 
-        return {left_mix_output, right_mix_output};
+        return {left_mix, right_mix};
     }
 
 };
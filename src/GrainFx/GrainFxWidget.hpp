@@ -96,10 +96,25 @@ struct GrainFxWidget : VoxglitchModuleWidget
     addInput(createInputCentered<PJ301MPort>(mm2px(Vec(118, 114.702)), module, GrainFx::SAMPLE_PLAYBACK_POSITION_INPUT));
   }
 
+  // The Grains knob normally goes up to MAX_GRAINS.  Many more grains than
+  // that can overload slower computers, so the higher limit is opt-in.
+  struct ExtendedGrainLimitMenuItem : MenuItem {
+    GrainFx *module;
+
+    void onAction(const event::Action &e) override {
+      module->extended_grain_limit ^= true;
+    }
+  };
+
   void appendContextMenu(Menu *menu) override
   {
     GrainFx *module = dynamic_cast<GrainFx*>(this->module);
     assert(module);
+
+    menu->addChild(new MenuEntry); // For spacing only
+    ExtendedGrainLimitMenuItem *extended_grain_limit_menu_item = createMenuItem<ExtendedGrainLimitMenuItem>("Extended grain limit (" + std::to_string(EXTENDED_MAX_GRAINS) + " grains)", CHECKMARK(module->extended_grain_limit));
+    extended_grain_limit_menu_item->module = module;
+    menu->addChild(extended_grain_limit_menu_item);
   }
 
 
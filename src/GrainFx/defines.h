@@ -1,4 +1,5 @@
-#define MAX_GRAINS 140
+#define MAX_GRAINS 140            // The highest setting of the Grains knob and CV
+#define EXTENDED_MAX_GRAINS 512   // ...when the "Extended grain limit" menu option is on
 #define MAX_PITCH 128
 
 // 100 = conservative
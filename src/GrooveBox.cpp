@@ -20,6 +20,7 @@ using namespace groove_box;
 #include "Common/Theme.hpp"
 #include "Common/components/VoxglitchComponents.hpp"
 #include "GrooveBox/ParameterLockSettings.hpp"
+#include "Common/ExpanderChannel.hpp"
 #include "GrooveBoxExpander/ExpanderToGrooveboxMessage.hpp"
 #include "GrooveBox/GrooveboxToExpanderMessage.hpp"
 
@@ -33,14 +34,18 @@ using namespace groove_box;
 #include "Common/dsp/Filter.hpp"
 #include "Common/dsp/FastSlewLimiter.hpp"
 #include "Common/dsp/Random.hpp"
+#include "Common/SampleLoader.hpp"
 #include "Common/SamplePlayer.hpp"
+#include "Common/DspProfiler.hpp"
 
 // Core components
 #include "GrooveBox/widgets/LCDColorScheme.hpp"
 #include "GrooveBox/TrackModel.hpp"
 #include "GrooveBox/Track.hpp"
+#include "GrooveBox/TrackEngine.hpp"
 #include "GrooveBox/MemorySlot.hpp"
 #include "GrooveBox/GrooveBox.hpp"
+#include "Common/components/DspProfilerMenu.hpp"
 
 #include "GrooveBox/GrooveBoxWidget.hpp"
 
@@ -69,11 +69,10 @@ struct GrooveBox : VoxglitchSamplerModule
   unsigned int visualizer_step = 0;
   unsigned int sample_position_snap_track_values[NUMBER_OF_TRACKS];
 
-  // A pair of GrooveBoxExpanderMessage structures for sending information
-  // from the expander to the groovebox.  Note that they both essentially
-  // serve the same purpose, but are rotated during read/write cycles
-  ExpanderToGrooveboxMessage expander_to_groovebox_message_a;
-  ExpanderToGrooveboxMessage expander_to_groovebox_message_b;
+  // Messages from the expander, holding its mute, solo, volume, pan and
+  // pitch settings.  See ExpanderChannel.hpp.
+  ExpanderToGrooveboxChannel expander_channel;
+  ExpanderToGrooveboxMessage expander_message;
   std::array<float, NUMBER_OF_TRACKS> track_volumes{};
   
   // The track_triggers array is used to send trigger information to the
@@ -87,11 +86,6 @@ struct GrooveBox : VoxglitchSamplerModule
   // load samples.  This is to alleviate the tedium of having to navigate to
   // the same folder every time a user goes to load new samples.
   //
-  // loaded_filenames: Filenames are displayed next to the tracks.  This variable
-  // keeps track of the filenames to display.
-  //
-  // TODO: remove the loaded_filenames array, which is not necessary
-  std::string loaded_filenames[NUMBER_OF_TRACKS]; // for display on the front panel
   std::string path = "";
   std::string kit_dir = "";
 
@@ -102,14 +96,16 @@ struct GrooveBox : VoxglitchSamplerModule
 
   SamplePlayer sample_players[NUMBER_OF_TRACKS];
 
-  // Each of the 8 tracks has dedicated slew limiters:
-  FastSlewLimiter volume_slew_limiters[NUMBER_OF_TRACKS];
-  FastSlewLimiter pan_slew_limiters[NUMBER_OF_TRACKS];
-  FastSlewLimiter filter_cutoff_slew_limiters[NUMBER_OF_TRACKS];
-  FastSlewLimiter filter_resonance_slew_limiters[NUMBER_OF_TRACKS];
+  // Renders the tracks of the selected memory slot.  It holds the slew
+  // limiters and filters, which are shared by all memory slots.
+  TrackEngine track_engine;
 
   SimpleDelay delay_dsps[NUMBER_OF_TRACKS];
 
+  // Optional timing of the track processing stages.  See the "DSP Profiler"
+  // context menu.
+  DspProfiler profiler;
+
   // sample position snap settings
   std::array<unsigned int, NUMBER_OF_TRACKS> sample_position_snap_indexes{};
 
@@ -158,29 +154,6 @@ struct GrooveBox : VoxglitchSamplerModule
     INTRO
   };
 
-  unsigned int left_output_enum_lookup_table[NUMBER_OF_TRACKS] = { 
-    TRACK_OUTPUTS + 0, 
-    TRACK_OUTPUTS + 2, 
-    TRACK_OUTPUTS + 4, 
-    TRACK_OUTPUTS + 6, 
-    TRACK_OUTPUTS + 8, 
-    TRACK_OUTPUTS + 10,
-    TRACK_OUTPUTS + 12,
-    TRACK_OUTPUTS + 14
-  };
-
-  unsigned int right_output_enum_lookup_table[NUMBER_OF_TRACKS] = {
-    TRACK_OUTPUTS + 1, 
-    TRACK_OUTPUTS + 3, 
-    TRACK_OUTPUTS + 5, 
-    TRACK_OUTPUTS + 7, 
-    TRACK_OUTPUTS + 9, 
-    TRACK_OUTPUTS + 11,
-    TRACK_OUTPUTS + 13,
-    TRACK_OUTPUTS + 15
-  };
-
-
   /*
  
 
@@ -219,25 +192,13 @@ struct GrooveBox : VoxglitchSamplerModule
     //  const float MS_50{20.0f};  // 20 Hz   = 50 milliseconds
     //  const float MS_100{10.0f}; // 10 Hz   = 100 milliseconds
         
-    float slew_speed = 100.0f;
-    float slew_sample_time = APP->engine->getSampleTime();
-
-    for (unsigned int i = 0; i < NUMBER_OF_TRACKS; i++)
-    {
-      volume_slew_limiters[i].setRiseFall(slew_speed, slew_speed);
-      pan_slew_limiters[i].setRiseFall(slew_speed, slew_speed);
-      filter_cutoff_slew_limiters[i].setRiseFall(slew_speed, slew_speed);
-      filter_resonance_slew_limiters[i].setRiseFall(slew_speed, slew_speed);
-
-      volume_slew_limiters[i].setDeltaTime(slew_sample_time);
-      pan_slew_limiters[i].setDeltaTime(slew_sample_time);
-      filter_cutoff_slew_limiters[i].setDeltaTime(slew_sample_time);
-      filter_resonance_slew_limiters[i].setDeltaTime(slew_sample_time);
-    }
+    track_engine.setSlewSpeed(100.0f);
+    track_engine.setProfiler(&profiler);
 
     // Configure delay dsps
     for (unsigned int i = 0; i < NUMBER_OF_TRACKS; i++)
     {
+      delay_dsps[i].setSampleRate(APP->engine->getSampleRate());
       delay_dsps[i].setBufferSize(APP->engine->getSampleRate() / 30.0);
     }
 
@@ -281,18 +242,22 @@ struct GrooveBox : VoxglitchSamplerModule
         // are shared across the tracks contained in the memory slots.
         memory_slots[m].setSamplePlayer(t, &sample_players[t]);
 
-        // Similarly, set the shared slew limiters
-        memory_slots[m].setVolumeSlewLimiter(t, &volume_slew_limiters[t]);
-        memory_slots[m].setPanSlewLimiter(t, &pan_slew_limiters[t]);
-        memory_slots[m].setFilterCutoffSlewLimiter(t, &filter_cutoff_slew_limiters[t]);
-        memory_slots[m].setFilterResonanceSlewLimiter(t, &filter_resonance_slew_limiters[t]);
-
         // Same idea with the dsp::delay objects
         SimpleDelay *simple_delay = &delay_dsps[t];
         memory_slots[m].setDelayDsp(t, simple_delay);
+
+        memory_slots[m].setProfiler(t, &profiler);
       }
     }
 
+    // These must be added in the same order as the ProfileStages enum in defines.h
+    profiler.addStage("GrooveBox total");
+    profiler.addStage("Sample read");
+    profiler.addStage("Pan and volume");
+    profiler.addStage("ADSR");
+    profiler.addStage("Filter");
+    profiler.addStage("Delay");
+
     // Store a pointer to the active memory slot
     selected_memory_slot = &memory_slots[0];
 
@@ -302,9 +267,8 @@ struct GrooveBox : VoxglitchSamplerModule
     // Update parameter lock knobs.  I'm not sure if this is necessary.
     updatePanelControls();
 
-    // Set the leftExpander pointers to the two message holders
-    leftExpander.producerMessage = &expander_to_groovebox_message_a;
-    leftExpander.consumerMessage = &expander_to_groovebox_message_b;
+    // The expander sends its messages through the channel on the left
+    expander_channel.attach(leftExpander);
   }
 
   /*
@@ -346,7 +310,6 @@ struct GrooveBox : VoxglitchSamplerModule
 
     for (unsigned int i = 0; i < NUMBER_OF_TRACKS; i++)
     {
-      this->loaded_filenames[i] = "";
       this->sample_position_snap_indexes[i] = 0;
     }
 
@@ -572,7 +535,6 @@ struct GrooveBox : VoxglitchSamplerModule
   void unassignSample(unsigned int track_index)
   {
     sample_players[track_index].releaseSample();
-    loaded_filenames[track_index] = "";
   }
 
   void importKit(std::string kit_path)
@@ -595,7 +557,7 @@ struct GrooveBox : VoxglitchSamplerModule
 
         while (std::getline(input_file, line) && (sample_number < NUMBER_OF_TRACKS))
         {
-          this->sample_players[sample_number].loadSample(destination_path + "/" + line);
+          this->sample_players[sample_number].loadSampleAsync(destination_path + "/" + line);
           sample_number++;
         }
       }
@@ -805,9 +767,9 @@ struct GrooveBox : VoxglitchSamplerModule
         if (sample_path_json)
         {
           std::string path = json_string_value(sample_path_json);
+          // Samples are loaded in the background and swapped in by process()
           if (path != "")
-            this->sample_players[track_index].loadSample(path);
-          this->loaded_filenames[track_index] = this->sample_players[track_index].getFilename();
+            this->sample_players[track_index].loadSampleAsync(path);
         }
 
         // Deprecated, but around for a while while people still have old versions
@@ -908,6 +870,7 @@ struct GrooveBox : VoxglitchSamplerModule
     json_t *selected_memory_index_json = json_object_get(json_root, "selected_memory_index");
     if(selected_memory_index_json) this->switchMemory(json_integer_value(selected_memory_index_json));
 
+    allocateDelays();
     updatePanelControls();
 	}
 
@@ -922,9 +885,18 @@ struct GrooveBox : VoxglitchSamplerModule
 
   void process(const ProcessArgs &args) override
   {
+    profiler.poll();
+    DspProfileScope profile_scope(&profiler, PROFILE_TOTAL);
+
     if (expander_connected)
       readFromExpander();
 
+    // Swap in any samples that have finished loading in the background
+    for (unsigned int i = 0; i < NUMBER_OF_TRACKS; i++)
+    {
+      sample_players[i].acceptLoadedSample();
+    }
+
     //
     // If the user has pressed a memory slot button, switch memory slots and update the
     // knob positions for the selected function.
@@ -1071,13 +1043,15 @@ struct GrooveBox : VoxglitchSamplerModule
       clock_counter++;
     }
 
+    // Get the output of the tracks and sum them for the stereo output.  This
+    // also steps the tracks' sample players, and takes up most of the CPU.
     float mix_left_output = 0;
     float mix_right_output = 0;
 
-    for (unsigned int track_index = 0; track_index < NUMBER_OF_TRACKS; track_index++)
-    {
-      processTrack(track_index, &mix_left_output, &mix_right_output);
-    }
+    // Track volumes from the expander
+    const float *expander_track_volumes = expander_connected ? track_volumes.data() : NULL;
+
+    track_engine.process(selected_memory_slot->tracks.data(), this->interpolation, expander_track_volumes, &outputs[TRACK_OUTPUTS], &mix_left_output, &mix_right_output);
 
     // Read master volume knob
     float master_volume = params[MASTER_VOLUME].getValue() * 8.0;
@@ -1090,36 +1064,6 @@ struct GrooveBox : VoxglitchSamplerModule
       writeToExpander();
   }
 
-  bool processTrack(unsigned int track_index, float *mix_left_output, float *mix_right_output)
-  {
-    //  1. Get the output of the tracks and sum them for the stereo output
-    //  2. Once the output has been read, increment the sample position
-
-    float track_left_output = 0;
-    float track_right_output = 0;
-
-    // This one line of code takes up most of the CPU
-    selected_memory_slot->tracks[track_index].getStereoOutput(&track_left_output, &track_right_output, this->interpolation);
-
-    // Apply track volumes from expander
-    if (expander_connected)
-    {
-      track_left_output = track_left_output * track_volumes[track_index];
-      track_right_output = track_right_output * track_volumes[track_index];
-    }
-
-    outputs[left_output_enum_lookup_table[track_index]].setVoltage(track_left_output);
-    outputs[right_output_enum_lookup_table[track_index]].setVoltage(track_right_output);
-
-    // Calculate summed output
-    *mix_left_output += track_left_output;
-    *mix_right_output += track_right_output;
-
-    selected_memory_slot->tracks[track_index].incrementSamplePosition();
-
-    return(true);
-  }
-
   /*
  
     █▀▀ ▀▄▀ █▀█ ▄▀█ █▄░█ █▀▄ █▀▀ █▀█   █▀█ █▀█ █▀█ █▀▀ █▀▀ █▀ █▀ █ █▄░█ █▀▀
@@ -1146,8 +1090,8 @@ struct GrooveBox : VoxglitchSamplerModule
 
   void readFromExpander()
   {
-    // Receive message from expander.  Always read from the consumer.
-    // when reading from the expander, we're using the __GrooveBox's__ consumer and producer message pair
+    // Receive messages from the expander.  Each message holds all of the
+    // expander's settings, so only the newest one is used.
 
     // If the expander is removed from the path, then detach it
     if(! leftExpander.module)
@@ -1156,10 +1100,8 @@ struct GrooveBox : VoxglitchSamplerModule
       return;
     }
 
-    ExpanderToGrooveboxMessage *consumer_message = (ExpanderToGrooveboxMessage *)leftExpander.consumerMessage;
-
     // Retrieve the data from the expander
-    if (consumer_message && consumer_message->message_received == false)
+    if (expander_channel.receiveLatest(expander_message))
     {
       this->any_track_soloed = false;
 
@@ -1184,8 +1126,8 @@ struct GrooveBox : VoxglitchSamplerModule
 
       for (unsigned int i = 0; i < NUMBER_OF_TRACKS; i++)
       {
-        bool expander_mute_value = consumer_message->mutes[i];
-        bool expander_solo_value = consumer_message->solos[i];
+        bool expander_mute_value = expander_message.mutes[i];
+        bool expander_solo_value = expander_message.solos[i];
 
         // Shorthand to make code more readable
         Track *track = &this->selected_memory_slot->tracks[i];
@@ -1213,17 +1155,12 @@ struct GrooveBox : VoxglitchSamplerModule
 
         this->mutes[i] = expander_mute_value;
         this->solos[i] = expander_solo_value;
-        this->track_volumes[i] = consumer_message->track_volumes[i];
+        this->track_volumes[i] = expander_message.track_volumes[i];
 
-        this->selected_memory_slot->tracks[i].setTrackPan(consumer_message->track_pans[i]);
-        this->selected_memory_slot->tracks[i].setTrackPitch(consumer_message->track_pitches[i]);
+        this->selected_memory_slot->tracks[i].setTrackPan(expander_message.track_pans[i]);
+        this->selected_memory_slot->tracks[i].setTrackPitch(expander_message.track_pitches[i]);
       }
-
-      // Set the received flag
-      consumer_message->message_received = true;
     }
-
-    leftExpander.messageFlipRequested = true;
   }
 
   void writeToExpander()
@@ -1235,19 +1172,34 @@ struct GrooveBox : VoxglitchSamplerModule
       return;
     }
 
-    // Always write to the producerMessage
-    GrooveboxToExpanderMessage *groovebox_to_expander_message = (GrooveboxToExpanderMessage *)leftExpander.module->rightExpander.producerMessage;
+    // Only send a message when a track has been triggered
+    bool any_track_triggered = false;
 
-    if (groovebox_to_expander_message && groovebox_to_expander_message->message_received == true)
+    for (unsigned int i = 0; i < NUMBER_OF_TRACKS; i++)
+    {
+      if (this->track_triggers[i])
+        any_track_triggered = true;
+    }
+
+    if (! any_track_triggered)
+      return;
+
+    GrooveboxToExpanderChannel *channel = GrooveboxToExpanderChannel::find(leftExpander.module->rightExpander);
+
+    GrooveboxToExpanderMessage message;
+
+    for (unsigned int i = 0; i < NUMBER_OF_TRACKS; i++)
+    {
+      message.track_triggers[i] = this->track_triggers[i];
+    }
+
+    // If the channel is full, the triggers are kept and sent on a later frame
+    if (channel && channel->send(message))
     {
       for (unsigned int i = 0; i < NUMBER_OF_TRACKS; i++)
       {
-        groovebox_to_expander_message->track_triggers[i] = this->track_triggers[i];
-        if (this->track_triggers[i])
-          this->track_triggers[i] = false;
+        this->track_triggers[i] = false;
       }
-
-      groovebox_to_expander_message->message_received = false;
     }
   }
 
@@ -1270,6 +1222,9 @@ struct GrooveBox : VoxglitchSamplerModule
         this->memory_slots[m].tracks[i].setTrackPitch(0.0);
       }
     }
+
+    // Throw away any settings sent by the expander before it was removed
+    expander_channel.clear();
   }
 
   void onSampleRateChange(const SampleRateChangeEvent &e) override
@@ -1284,10 +1239,31 @@ struct GrooveBox : VoxglitchSamplerModule
 
     for (unsigned int t = 0; t < NUMBER_OF_TRACKS; t++)
     {
-      volume_slew_limiters[t].updateRackSampleRate();
-      pan_slew_limiters[t].updateRackSampleRate();
-      filter_cutoff_slew_limiters[t].updateRackSampleRate();
-      filter_resonance_slew_limiters[t].updateRackSampleRate();
-    }    
+      delay_dsps[t].setSampleRate(e.sampleRate);
+    }
+
+    track_engine.updateRackSampleRate();
+  }
+
+  //
+  // The delays' buffers are only allocated for tracks which use them, the
+  // first time that the delay mix of any of the track's steps, in any memory
+  // slot, is above 0.  Called from the widget's step() and dataFromJson(), so
+  // that process() never allocates.
+  //
+  void allocateDelays()
+  {
+    for (unsigned int t = 0; t < NUMBER_OF_TRACKS; t++)
+    {
+      if (delay_dsps[t].isAllocated()) continue;
+
+      for (unsigned int m = 0; m < NUMBER_OF_MEMORY_SLOTS; m++)
+      {
+        for (unsigned int step = 0; step < NUMBER_OF_STEPS; step++)
+        {
+          if (memory_slots[m].tracks[t].getParameter(DELAY_MIX, step) > 0) delay_dsps[t].allocate();
+        }
+      }
+    }
   }
 };
@@ -126,8 +126,7 @@ struct LoadSamplesFromFolderMenuItem : MenuItem
         {
           if (i < NUMBER_OF_TRACKS)
           {
-            module->sample_players[i].loadSample(std::string(entry));
-            module->loaded_filenames[i] = module->sample_players[i].getFilename();
+            module->sample_players[i].loadSampleAsync(std::string(entry));
             i++;
           }
         }
@@ -164,8 +163,7 @@ struct LoadSampleMenuItem : MenuItem
   {
     if (filename != "")
     {
-      module->sample_players[track_number].loadSample(filename);
-      module->loaded_filenames[track_number] = module->sample_players[track_number].getFilename();
+      module->sample_players[track_number].loadSampleAsync(filename);
       module->setRoot(filename);
     }
   }
@@ -301,6 +299,17 @@ struct GrooveBoxWidget : VoxglitchSamplerModuleWidget
     }
   }
 
+  void step() override
+  {
+    GrooveBox *module = dynamic_cast<GrooveBox *>(this->module);
+
+    // Delay mixes are set from the knobs in process(), so this is where a
+    // newly used delay gets its buffers, off the audio thread
+    if (module) module->allocateDelays();
+
+    VoxglitchSamplerModuleWidget::step();
+  }
+
   void onHoverKey(const event::HoverKey &e) override
   {
     GrooveBox *module = dynamic_cast<GrooveBox *>(this->module);
@@ -390,6 +399,10 @@ struct GrooveBoxWidget : VoxglitchSamplerModuleWidget
     SampleInterpolationMenuItem *sample_interpolation_menu_item = createMenuItem<SampleInterpolationMenuItem>("Interpolation", RIGHT_ARROW);
     sample_interpolation_menu_item->module = module;
     menu->addChild(sample_interpolation_menu_item);
+
+    DspProfilerMenuItem *dsp_profiler_menu_item = createMenuItem<DspProfilerMenuItem>("DSP Profiler", RIGHT_ARROW);
+    dsp_profiler_menu_item->profiler = &module->profiler;
+    menu->addChild(dsp_profiler_menu_item);
   }
 
   // =================================================================
@@ -1,9 +1,9 @@
 #pragma once
 
+// Sent by the GrooveBox whenever one or more tracks are triggered
 struct GrooveboxToExpanderMessage
 {
   bool track_triggers[8];
-  bool message_received = true;
 
   GrooveboxToExpanderMessage()
   {
@@ -13,3 +13,5 @@ struct GrooveboxToExpanderMessage
     }
   }
 };
+
+typedef ExpanderChannel<GrooveboxToExpanderMessage, 64> GrooveboxToExpanderChannel;
@@ -18,31 +18,14 @@ struct MemorySlot
     tracks.at(track_index).setSamplePlayer(sample_player);
   }
 
-  // TODO:  I may eventually use an array of slew limiters to avoid having all
-  // of these similar functions.
-  void setVolumeSlewLimiter(unsigned int track_index, FastSlewLimiter *slew_limiter)
-  {
-    tracks.at(track_index).setVolumeSlewLimiter(slew_limiter);
-  }
-
-  void setPanSlewLimiter(unsigned int track_index, FastSlewLimiter *slew_limiter)
-  {
-    tracks.at(track_index).setPanSlewLimiter(slew_limiter);
-  }
-
-  void setFilterCutoffSlewLimiter(unsigned int track_index, FastSlewLimiter *slew_limiter)
-  {
-    tracks.at(track_index).setFilterCutoffSlewLimiter(slew_limiter);
-  }
-
-  void setFilterResonanceSlewLimiter(unsigned int track_index, FastSlewLimiter *slew_limiter)
+  void setDelayDsp(unsigned int track_index, SimpleDelay *delay_dsp)
   {
-    tracks.at(track_index).setFilterResonanceSlewLimiter(slew_limiter);
+    tracks.at(track_index).setDelayDsp(delay_dsp);
   }
 
-  void setDelayDsp(unsigned int track_index, SimpleDelay *delay_dsp)
+  void setProfiler(unsigned int track_index, DspProfiler *profiler)
   {
-    tracks.at(track_index).setDelayDsp(delay_dsp);
+    tracks.at(track_index).setProfiler(profiler);
   }
 
   Track *getTrack(unsigned int track_index)
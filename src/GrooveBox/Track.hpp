@@ -13,16 +13,18 @@ namespace groove_box
     ADSR adsr;
     SimpleDelay *delay;
     StereoFadeOut fade_out;
-    Filter filter;
-    FastSlewLimiter *volume_slew_limiter;
-    FastSlewLimiter *pan_slew_limiter;
-    FastSlewLimiter *filter_cutoff_slew_limiter;
-    FastSlewLimiter *filter_resonance_slew_limiter;
+
+    // The attack and release settings that the ADSR's rates were last
+    // computed from.  Computing the rates is expensive, so it's only done
+    // when these change.
+    float envelope_attack = -1.0;
+    float envelope_release = -1.0;
 
     // Random number generation
     Random random;
 
     StereoPan stereo_pan;
+    DspProfiler *profiler = NULL;
     float sample_time = APP->engine->getSampleTime();
 
     // Notes on the next line of code: 
@@ -55,24 +57,9 @@ namespace groove_box
       this->sample_player = sample_player;
     }
 
-    void setVolumeSlewLimiter(FastSlewLimiter *slew_limiter)
-    {
-      volume_slew_limiter = slew_limiter;
-    }
-
-    void setPanSlewLimiter(FastSlewLimiter *slew_limiter)
-    {
-      pan_slew_limiter = slew_limiter;
-    }
-
-    void setFilterCutoffSlewLimiter(FastSlewLimiter *slew_limiter)
-    {
-      filter_cutoff_slew_limiter = slew_limiter;
-    }
-
-    void setFilterResonanceSlewLimiter(FastSlewLimiter *slew_limiter)
+    void setProfiler(DspProfiler *profiler)
     {
-      filter_resonance_slew_limiter = slew_limiter;
+      this->profiler = profiler;
     }
 
     void setDelayDsp(SimpleDelay *delay_dsp)
@@ -298,32 +285,19 @@ namespace groove_box
       this->sample_player->initialize();
     }
 
-    void getStereoOutput(float *final_left_output, float *final_right_output, unsigned int interpolation)
+    //
+    // Reads the next frame of the track's sample and applies the fade out and
+    // the ADSR.  Pan, volume and the filter are applied to all of the tracks
+    // together by TrackEngine, followed by applyDelay().
+    //
+    void renderVoice(float *left_output, float *right_output, unsigned int interpolation)
     {
-      float left_output = 0.0;
-      float right_output = 0.0;
-
-      // Question: Is slewing on the filter cutoff really necesary?
-      // Answer: Yes.  I used a flute sound to test and heavily modulated the cutoff,
-      //    and the slewed filter cutoff was far smoother sounding.  Without it,
-      //    there was an audible click.
-
-      // -===== Slew Limiter Processing =====-
-      float volume = volume_slew_limiter->process(m.local_parameter_lock_settings.getParameter(VOLUME));
-      float filter_cutoff = filter_cutoff_slew_limiter->process(m.local_parameter_lock_settings.getParameter(FILTER_CUTOFF));
-      float filter_resonance = filter_resonance_slew_limiter->process(m.local_parameter_lock_settings.getParameter(FILTER_RESONANCE));
-      
-
-      // Mostly cosmetic: Load up the settings into easily readable variables
       // The "m.local_parameter_lock_settings" structure is populated when the track is stepped.  It
       // contains of snapshot of the m.local_parameter_lock_settings related to the active step.
+      ParameterLockSettings &settings = m.local_parameter_lock_settings;
 
-      float pan = m.local_parameter_lock_settings.getParameter(PAN);
-      float attack = m.local_parameter_lock_settings.getParameter(ATTACK);
-      float release = m.local_parameter_lock_settings.getParameter(RELEASE);
-      float delay_mix = m.local_parameter_lock_settings.getParameter(DELAY_MIX);
-      float delay_length = m.local_parameter_lock_settings.getParameter(DELAY_LENGTH);
-      float delay_feedback = m.local_parameter_lock_settings.getParameter(DELAY_FEEDBACK);
+      float attack = settings.getParameter(ATTACK);
+      float release = settings.getParameter(RELEASE);
 
       // When the ADSR reaches the sustain state, then switch to the release
       // state.  Only do this when the release is less than max release, otherwise
@@ -334,23 +308,23 @@ namespace groove_box
       if (adsr.getState() == ADSR::env_sustain && release < 1.0)
         adsr.gate(false);
 
-      // Read sample output
-      this->sample_player->getStereoOutput(&left_output, &right_output, interpolation);
+      // Read sample output and step the sample player
+      float pitch = settings.getParameter(PITCH);
+      float reverse = settings.getParameter(REVERSE);
+      float sample_start = settings.getParameter(SAMPLE_START);
+      float sample_end = settings.getParameter(SAMPLE_END);
+      float loop = settings.getParameter(LOOP);
 
-      // Apply pan parameters
-      //
-      // m.local_parameter_lock_settings.pan ranges from 0 to 1
-      // track_pan ranges from -1 to 0
-
-      float computed_pan = rescale(pan, 0.0, 1.0, -1.0, 1.0);
-      computed_pan = clamp(computed_pan + m.track_pan, -1.0, 1.0);
-      computed_pan = pan_slew_limiter->process(computed_pan);
-      stereo_pan.process(&left_output, &right_output, computed_pan);
+      float summed_pitch = clamp(pitch + m.track_pitch, 0.0, 1.0);
+      float rescaled_pitch = rescale(summed_pitch, 0.0, 1.0, -2.0, 2.0); // -2.0 to 2.0 is a two octave range in either direction (4 octives total)
 
-      // Apply volume parameters
-      left_output *= (volume * 2);  // Range from 0 to 2 times normal volume
-      right_output *= (volume * 2); // Range from 0 to 2 times normal volume
+      *left_output = 0.0;
+      *right_output = 0.0;
 
+      {
+        DspProfileScope profile_scope(profiler, PROFILE_SAMPLE_READ);
+        this->sample_player->renderFrame(left_output, right_output, interpolation, rescaled_pitch, sample_start, sample_end, loop, reverse > .5);
+      }
 
       // Process fade out at 1/10th of a second.
       //
@@ -361,85 +335,59 @@ namespace groove_box
       // Why fade?  At the moment, the only reason to fade_out is when a track
       // is muted by the expander.
       //
-      if (fade_out.process(&left_output, &right_output, 10.0 * APP->engine->getSampleTime()))
+      if (fade_out.process(left_output, right_output, 10.0 * sample_time))
       {
         // If this line has been reached, it means the a fade out has just completed
         // If so, stop the sample player
         this->sample_player->stop();
       }
 
-
       // -===== ADSR Processing =====-
 
       if(attack > 0.0 || release < 1.0) // skip computations if not used
       {
-        adsr.setAttackRate(attack * APP->engine->getSampleRate());
-        adsr.setReleaseRate(release * maximum_release_time * APP->engine->getSampleRate());
-        float adsr_value = adsr.process();
+        DspProfileScope profile_scope(profiler, PROFILE_ADSR);
 
-        // Apply ADSR to volume
-        left_output *= adsr_value;
-        right_output *= adsr_value;
-      }
+        if (attack != envelope_attack || release != envelope_release)
+        {
+          float sample_rate = 1.0 / sample_time;
+          adsr.setAttackRate(attack * sample_rate);
+          adsr.setReleaseRate(release * maximum_release_time * sample_rate);
 
-      // Apply filter
-      if(filter_cutoff < 1.0) // Skip if cutoff is max value
-      {
-        filter.setCutoff(filter_cutoff);
-        filter.setResonance(filter_resonance);
-        filter.process(&left_output, &right_output);
-      }
+          envelope_attack = attack;
+          envelope_release = release;
+        }
 
-      // If the delay mix is above 0 for this track, then compute the delay and
-      // output it.  This if statement is an attempt to trim down CPU usage when
-      // the delay is effectively turned off.
-      if (delay_mix > 0)
-      {
-        float delay_output_left = 0.0;
-        float delay_output_right = 0.0;
-
-        // Apply delay
-        delay->setMix(delay_mix);
-        delay->setBufferSize(delay_length * (APP->engine->getSampleRate() / 4));
-        delay->setFeedback(delay_feedback);
-        delay->process(left_output, right_output, delay_output_left, delay_output_right);
-
-        // Return audio with the delay applied
-        *final_left_output = delay_output_left;
-        *final_right_output = delay_output_right;
-      }
-      else
-      {
-        *final_left_output = left_output;
-        *final_right_output = right_output;        
+        float adsr_value = adsr.process();
+
+        // Apply ADSR to volume
+        *left_output *= adsr_value;
+        *right_output *= adsr_value;
       }
     }
 
-    void incrementSamplePosition()
+    // If the delay mix is above 0 for this track, then compute the delay and
+    // output it.  This if statement is an attempt to trim down CPU usage when
+    // the delay is effectively turned off.
+    void applyDelay(float *left_output, float *right_output)
     {
-      float pitch = m.local_parameter_lock_settings.getParameter(PITCH);
-      float reverse = m.local_parameter_lock_settings.getParameter(REVERSE);
-      float sample_start = m.local_parameter_lock_settings.getParameter(SAMPLE_START);
-      float sample_end = m.local_parameter_lock_settings.getParameter(SAMPLE_END);
-      float loop = m.local_parameter_lock_settings.getParameter(LOOP);
+      float delay_mix = m.local_parameter_lock_settings.getParameter(DELAY_MIX);
+      if (delay_mix <= 0) return;
 
-      float summed_pitch = clamp(pitch + m.track_pitch, 0.0, 1.0);
-      float rescaled_pitch = rescale(summed_pitch, 0.0, 1.0, -2.0, 2.0);
+      float delay_length = m.local_parameter_lock_settings.getParameter(DELAY_LENGTH);
+      float delay_feedback = m.local_parameter_lock_settings.getParameter(DELAY_FEEDBACK);
 
-      if (reverse > .5)
-      {
-        // -2.0 to 2.0 is a two octave range in either direction (4 octives total)
-        this->sample_player->stepReverse(rescaled_pitch, sample_start, sample_end, loop);
-      }
-      else
-      {
-        this->sample_player->step(rescaled_pitch, sample_start, sample_end, loop);
-      }
+      delay->setMix(delay_mix);
+      delay->setBufferSize(delay_length * (0.25 / sample_time));
+      delay->setFeedback(delay_feedback);
+      delay->process(*left_output, *right_output, *left_output, *right_output);
     }
 
     void updateRackSampleRate()
     {
       this->sample_time = APP->engine->getSampleTime();
+      this->envelope_attack = -1.0;
+      this->envelope_release = -1.0;
       this->sample_player->updateSampleRate();
     }
 
@@ -0,0 +1,269 @@
+namespace groove_box
+{
+
+  //
+  // TrackEngine
+  //
+  // Renders the eight tracks of the selected memory slot together.
+  //
+  // The parts of a track that depend on its own state (reading its sample,
+  // its envelope, its fade out and its delay) are handled track by track in
+  // Track.hpp.  Everything else (the slew limiters, pan, volume and filter)
+  // runs on all of the tracks at once, as two float_4 groups of four tracks.
+  //
+  // The slew limiter and filter states belong to the engine rather than to
+  // the tracks.  Like the sample players and delays, they are shared by the
+  // tracks of every memory slot.
+  //
+
+  struct TrackEngine
+  {
+    static const unsigned int NUMBER_OF_GROUPS = NUMBER_OF_TRACKS / 4;
+
+    TFastSlewLimiter<simd::float_4> volume_slew_limiters[NUMBER_OF_GROUPS];
+    TFastSlewLimiter<simd::float_4> pan_slew_limiters[NUMBER_OF_GROUPS];
+    TFastSlewLimiter<simd::float_4> filter_cutoff_slew_limiters[NUMBER_OF_GROUPS];
+    TFastSlewLimiter<simd::float_4> filter_resonance_slew_limiters[NUMBER_OF_GROUPS];
+
+    // State of the low pass filters, for the left and right channels
+    simd::float_4 filter_ic1eq_left[NUMBER_OF_GROUPS];
+    simd::float_4 filter_ic2eq_left[NUMBER_OF_GROUPS];
+    simd::float_4 filter_ic1eq_right[NUMBER_OF_GROUPS];
+    simd::float_4 filter_ic2eq_right[NUMBER_OF_GROUPS];
+
+    // Filter coefficients, one per track.  The Filter objects are only used
+    // to compute them, when a track's cutoff or resonance changes.
+    Filter coefficient_filters[NUMBER_OF_TRACKS];
+    float filter_cutoffs[NUMBER_OF_TRACKS];
+    float filter_resonances[NUMBER_OF_TRACKS];
+    alignas(16) float filter_a1[NUMBER_OF_TRACKS] = {};
+    alignas(16) float filter_a2[NUMBER_OF_TRACKS] = {};
+    alignas(16) float filter_a3[NUMBER_OF_TRACKS] = {};
+
+    // Per-frame working values, one per track
+    alignas(16) float left_audio[NUMBER_OF_TRACKS] = {};
+    alignas(16) float right_audio[NUMBER_OF_TRACKS] = {};
+    alignas(16) float volumes[NUMBER_OF_TRACKS] = {};
+    alignas(16) float pans[NUMBER_OF_TRACKS] = {};
+    alignas(16) float cutoffs[NUMBER_OF_TRACKS] = {};
+    alignas(16) float resonances[NUMBER_OF_TRACKS] = {};
+
+    DspProfiler *profiler = NULL;
+
+    TrackEngine()
+    {
+      for (unsigned int g = 0; g < NUMBER_OF_GROUPS; g++)
+      {
+        filter_ic1eq_left[g] = 0.f;
+        filter_ic2eq_left[g] = 0.f;
+        filter_ic1eq_right[g] = 0.f;
+        filter_ic2eq_right[g] = 0.f;
+      }
+
+      invalidateFilterCoefficients();
+    }
+
+    void setProfiler(DspProfiler *profiler)
+    {
+      this->profiler = profiler;
+    }
+
+    //  Be careful when setting the slew limiter values.  Larger numbers are
+    //  faster, not slower.  100.0 is about 10 milliseconds.  See the notes
+    //  in the GrooveBox constructor.
+    void setSlewSpeed(float slew_speed)
+    {
+      for (unsigned int g = 0; g < NUMBER_OF_GROUPS; g++)
+      {
+        volume_slew_limiters[g].setRiseFall(slew_speed, slew_speed);
+        pan_slew_limiters[g].setRiseFall(slew_speed, slew_speed);
+        filter_cutoff_slew_limiters[g].setRiseFall(slew_speed, slew_speed);
+        filter_resonance_slew_limiters[g].setRiseFall(slew_speed, slew_speed);
+      }
+
+      updateRackSampleRate();
+    }
+
+    void updateRackSampleRate()
+    {
+      for (unsigned int g = 0; g < NUMBER_OF_GROUPS; g++)
+      {
+        volume_slew_limiters[g].updateRackSampleRate();
+        pan_slew_limiters[g].updateRackSampleRate();
+        filter_cutoff_slew_limiters[g].updateRackSampleRate();
+        filter_resonance_slew_limiters[g].updateRackSampleRate();
+      }
+
+      // The filter coefficients depend on the sample rate
+      for (unsigned int t = 0; t < NUMBER_OF_TRACKS; t++)
+      {
+        coefficient_filters[t].setSampleRate(APP->engine->getSampleRate());
+      }
+
+      invalidateFilterCoefficients();
+    }
+
+    void invalidateFilterCoefficients()
+    {
+      for (unsigned int t = 0; t < NUMBER_OF_TRACKS; t++)
+      {
+        filter_cutoffs[t] = -1.0;
+        filter_resonances[t] = -1.0;
+      }
+    }
+
+    //
+    // Renders one frame of every track.  The outputs of the tracks are written
+    // to track_outputs, which holds the left and right outputs of each track
+    // in turn, and their sum is returned in mix_left_output and
+    // mix_right_output.  track_volumes, if not NULL, holds a volume for each
+    // track from the expander.
+    //
+    void process(Track *tracks, unsigned int interpolation, const float *track_volumes, Output *track_outputs, float *mix_left_output, float *mix_right_output)
+    {
+      // Read each track's sample, and apply its fade out and envelope.  Also
+      // collect the settings for the next stage.
+      for (unsigned int t = 0; t < NUMBER_OF_TRACKS; t++)
+      {
+        Track &track = tracks[t];
+        ParameterLockSettings &settings = track.m.local_parameter_lock_settings;
+
+        track.renderVoice(&left_audio[t], &right_audio[t], interpolation);
+
+        // Pan ranges from 0 to 1, and the track pan from -1 to 1
+        float pan = rescale(settings.getParameter(PAN), 0.0, 1.0, -1.0, 1.0);
+
+        volumes[t] = settings.getParameter(VOLUME);
+        pans[t] = clamp(pan + track.m.track_pan, -1.0, 1.0);
+        cutoffs[t] = settings.getParameter(FILTER_CUTOFF);
+        resonances[t] = settings.getParameter(FILTER_RESONANCE);
+      }
+
+      for (unsigned int g = 0; g < NUMBER_OF_GROUPS; g++)
+      {
+        processGroup(g);
+      }
+
+      // Apply each track's delay, if its delay mix is above 0
+      {
+        DspProfileScope profile_scope(profiler, PROFILE_DELAY);
+
+        for (unsigned int t = 0; t < NUMBER_OF_TRACKS; t++)
+        {
+          tracks[t].applyDelay(&left_audio[t], &right_audio[t]);
+        }
+      }
+
+      // Write the track outputs and sum them for the stereo outputs
+      float mix_left = 0;
+      float mix_right = 0;
+
+      for (unsigned int t = 0; t < NUMBER_OF_TRACKS; t++)
+      {
+        float track_left_output = left_audio[t];
+        float track_right_output = right_audio[t];
+
+        if (track_volumes)
+        {
+          track_left_output *= track_volumes[t];
+          track_right_output *= track_volumes[t];
+        }
+
+        track_outputs[t * 2].setVoltage(track_left_output);
+        track_outputs[(t * 2) + 1].setVoltage(track_right_output);
+
+        mix_left += track_left_output;
+        mix_right += track_right_output;
+      }
+
+      *mix_left_output = mix_left;
+      *mix_right_output = mix_right;
+    }
+
+    // Slew, pan, volume and filter for four tracks at once
+    void processGroup(unsigned int g)
+    {
+      unsigned int first_track = g * 4;
+
+      simd::float_4 left = simd::float_4::load(&left_audio[first_track]);
+      simd::float_4 right = simd::float_4::load(&right_audio[first_track]);
+      simd::float_4 cutoff;
+      simd::float_4 resonance;
+
+      {
+        DspProfileScope profile_scope(profiler, PROFILE_PAN);
+
+        // It's necessary to slew the volume and pan, otherwise these will
+        // introduce a pop or click when modulated between distant values.
+        // Slewing the filter cutoff avoids clicks when it is modulated.
+        simd::float_4 volume = volume_slew_limiters[g].process(simd::float_4::load(&volumes[first_track]));
+        simd::float_4 pan = pan_slew_limiters[g].process(simd::float_4::load(&pans[first_track]));
+        cutoff = filter_cutoff_slew_limiters[g].process(simd::float_4::load(&cutoffs[first_track]));
+        resonance = filter_resonance_slew_limiters[g].process(simd::float_4::load(&resonances[first_track]));
+
+        // Panning right turns down the left channel, and vice versa (see StereoPan.hpp)
+        left *= 1.f - simd::fmax(pan, 0.f);
+        right *= 1.f + simd::fmin(pan, 0.f);
+
+        // Volume ranges from 0 to 2 times normal volume
+        left *= volume * 2.f;
+        right *= volume * 2.f;
+      }
+
+      // The filter is skipped, and its state left alone, on tracks with the
+      // cutoff at its maximum value
+      simd::float_4 filter_active = cutoff < 1.f;
+
+      if (simd::movemask(filter_active))
+      {
+        DspProfileScope profile_scope(profiler, PROFILE_FILTER);
+
+        for (unsigned int lane = 0; lane < 4; lane++)
+        {
+          if (cutoff[lane] < 1.f) updateFilterCoefficients(first_track + lane, cutoff[lane], resonance[lane]);
+        }
+
+        simd::float_4 a1 = simd::float_4::load(&filter_a1[first_track]);
+        simd::float_4 a2 = simd::float_4::load(&filter_a2[first_track]);
+        simd::float_4 a3 = simd::float_4::load(&filter_a3[first_track]);
+
+        left = processFilter(left, filter_active, a1, a2, a3, filter_ic1eq_left[g], filter_ic2eq_left[g]);
+        right = processFilter(right, filter_active, a1, a2, a3, filter_ic1eq_right[g], filter_ic2eq_right[g]);
+      }
+
+      left.store(&left_audio[first_track]);
+      right.store(&right_audio[first_track]);
+    }
+
+    // The low pass output of the state variable filter in Filter.hpp
+    simd::float_4 processFilter(simd::float_4 input, simd::float_4 active, simd::float_4 a1, simd::float_4 a2, simd::float_4 a3, simd::float_4 &ic1eq, simd::float_4 &ic2eq)
+    {
+      simd::float_4 v3 = input - ic2eq;
+      simd::float_4 v1 = a2 * v3 + a1 * ic1eq;
+      simd::float_4 v2 = a3 * v3 + a2 * ic1eq + ic2eq;
+
+      ic1eq = simd::ifelse(active, 2.f * v1 - ic1eq, ic1eq);
+      ic2eq = simd::ifelse(active, 2.f * v2 - ic2eq, ic2eq);
+
+      return (simd::ifelse(active, v2, input));
+    }
+
+    void updateFilterCoefficients(unsigned int t, float cutoff, float resonance)
+    {
+      if (cutoff == filter_cutoffs[t] && resonance == filter_resonances[t]) return;
+
+      filter_cutoffs[t] = cutoff;
+      filter_resonances[t] = resonance;
+
+      Filter &filter = coefficient_filters[t];
+      filter.cutoff = cutoff;
+      filter.resonance = resonance;
+      filter.recalculate();
+
+      filter_a1[t] = filter.a1;
+      filter_a2[t] = filter.a2;
+      filter_a3[t] = filter.a3;
+    }
+  };
+
+}
@@ -12,6 +12,17 @@ namespace groove_box
 
     const float maximum_release_time = 4.0;
 
+    // Stages timed by the DSP profiler.  PROFILE_TOTAL must come first.
+    enum ProfileStages
+    {
+        PROFILE_TOTAL,
+        PROFILE_SAMPLE_READ,
+        PROFILE_PAN,
+        PROFILE_ADSR,
+        PROFILE_FILTER,
+        PROFILE_DELAY
+    };
+
     // WARNING!  Do not reorder the elements in the Parameters array, otherwise 
     // it will break people's patches.
     //
@@ -62,8 +62,7 @@ struct TrackLabelDisplay : TransparentWidget
   {
     if (filename != "")
     {
-      module->sample_players[track_number].loadSample(filename);
-      module->loaded_filenames[track_number] = module->sample_players[track_number].getFilename();
+      module->sample_players[track_number].loadSampleAsync(filename);
       module->setRoot(filename);
     }
   }
@@ -228,8 +227,7 @@ struct TrackLabelDisplay : TransparentWidget
     {
       if (filename != "")
       {
-        module->sample_players[track_number].loadSample(filename);
-        module->loaded_filenames[track_number] = module->sample_players[track_number].getFilename();
+        module->sample_players[track_number].loadSampleAsync(filename);
         module->setRoot(filename);
       }
     }
@@ -377,8 +375,7 @@ struct TrackSampleNudge : TransparentWidget
   {
     if (filename != "")
     {
-      module->sample_players[track_number].loadSample(filename);
-      module->loaded_filenames[track_number] = module->sample_players[track_number].getFilename();
+      module->sample_players[track_number].loadSampleAsync(filename);
       module->setRoot(filename);
     }
   }
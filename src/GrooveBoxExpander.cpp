@@ -12,6 +12,7 @@
 #include "Common/constants.h"
 #include "Common/Theme.hpp"
 #include "Common/components/VoxglitchComponents.hpp"
+#include "Common/ExpanderChannel.hpp"
 #include "GrooveBoxExpander/ExpanderToGrooveboxMessage.hpp"
 #include "GrooveBox/GrooveboxToExpanderMessage.hpp"
 #include "GrooveBoxExpander/GrooveBoxExpander.hpp"
@@ -1,8 +1,9 @@
 #pragma once
 
+// Sent by the expander on every frame.  Each message holds all of the
+// expander's settings, so the GrooveBox only needs the newest one.
 struct ExpanderToGrooveboxMessage
 {
-  bool message_received = true;
   bool mutes[8];
   bool solos[8];
   float track_volumes[8];
@@ -21,3 +22,5 @@ struct ExpanderToGrooveboxMessage
     }
   }
 };
+
+typedef ExpanderChannel<ExpanderToGrooveboxMessage, 16> ExpanderToGrooveboxChannel;
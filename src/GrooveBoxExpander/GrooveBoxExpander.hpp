@@ -6,8 +6,9 @@ struct GrooveBoxExpander : VoxglitchModule
   dsp::PulseGenerator triggerOutputPulseGenerators[NUMBER_OF_TRACKS];
   dsp::PulseGenerator triggerLightPulseGenerators[NUMBER_OF_TRACKS];
 
-  GrooveboxToExpanderMessage groovebox_to_expander_message_a;
-  GrooveboxToExpanderMessage groovebox_to_expander_message_b;
+  // Track triggers sent by the GrooveBox.  See ExpanderChannel.hpp.
+  GrooveboxToExpanderChannel groovebox_channel;
+  GrooveboxToExpanderMessage groovebox_message;
 
   bool mutes[NUMBER_OF_TRACKS];
   bool solos[NUMBER_OF_TRACKS];
@@ -118,8 +119,8 @@ struct GrooveBoxExpander : VoxglitchModule
       configOnOff(SOLO_BUTTONS + i, 0.0, "Solo Track "+ std::to_string(i + 1));
     }
 
-    rightExpander.producerMessage = &groovebox_to_expander_message_a;
-    rightExpander.consumerMessage = &groovebox_to_expander_message_b;
+    // The GrooveBox sends its messages through the channel on the right
+    groovebox_channel.attach(rightExpander);
   }
 
   // Destructor
@@ -194,48 +195,42 @@ struct GrooveBoxExpander : VoxglitchModule
 
   void writeToGroovebox()
   {
-    // Prepare message for sending to Grain Engine MK2
-    // When writing to the groovebox, we're using the __GrooveBox's__ producer and consumer pair
-    // Always write to the producer and read from the consumer
-    ExpanderToGrooveboxMessage *message_to_groove_box = (ExpanderToGrooveboxMessage *) rightExpander.module->leftExpander.producerMessage;
+    // Send the current settings to the GrooveBox, through the channel
+    // which belongs to the GrooveBox.  If the channel is full, the GrooveBox
+    // hasn't read the earlier settings yet, and these are sent on a later frame.
+    ExpanderToGrooveboxChannel *channel = ExpanderToGrooveboxChannel::find(rightExpander.module->leftExpander);
 
-    // Wait until the groovebox received the last message
-    if(message_to_groove_box && message_to_groove_box->message_received == true)
+    if(channel)
     {
+      ExpanderToGrooveboxMessage message;
+
       for(unsigned int i=0; i < NUMBER_OF_TRACKS; i++)
       {
-        message_to_groove_box->mutes[i] = mutes[i];
-        message_to_groove_box->solos[i] = solos[i];
-        message_to_groove_box->track_volumes[i] = params[VOLUME_KNOBS + i].getValue();
-        message_to_groove_box->track_pans[i] = params[PAN_KNOBS + i].getValue();
-        message_to_groove_box->track_pitches[i] = params[PITCH_KNOBS + i].getValue();
+        message.mutes[i] = mutes[i];
+        message.solos[i] = solos[i];
+        message.track_volumes[i] = params[VOLUME_KNOBS + i].getValue();
+        message.track_pans[i] = params[PAN_KNOBS + i].getValue();
+        message.track_pitches[i] = params[PITCH_KNOBS + i].getValue();
       }
 
-      // Tell GrooveBox that the message is ready for receiving
-      message_to_groove_box->message_received = false;
+      channel->send(message);
     }
   }
 
   void readFromGroovebox()
   {
-    // Receive message from expander
-    GrooveboxToExpanderMessage *groovebox_message = (GrooveboxToExpanderMessage *) this->rightExpander.consumerMessage;
-
-    // Retrieve the data from the expander
-    if(groovebox_message && groovebox_message->message_received == false)
+    // Receive every message from the GrooveBox, so that no triggers are missed
+    while(groovebox_channel.receive(groovebox_message))
     {
       for(unsigned int i=0; i < NUMBER_OF_TRACKS; i++)
       {
-        if(groovebox_message->track_triggers[i])
+        if(groovebox_message.track_triggers[i])
         {
           // Trigger output
           triggerOutputPulseGenerators[i].trigger(0.01f);
           triggerLightPulseGenerators[i].trigger(0.05f);
         }
       }
-
-      groovebox_message->message_received = true;
     }
-    rightExpander.messageFlipRequested = true;
   }
 };
@@ -139,6 +139,8 @@ struct Hazumi : Module
       //if (height_json) json_decref(height_json);
     }
 
+    this->hazumi_sequencer.revision++;
+
     // Load trigger options data
     json_t *trigger_options_data = json_object_get(json_root, "trigger_options");
     if(trigger_options_data)
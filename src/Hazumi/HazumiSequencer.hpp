@@ -12,6 +12,11 @@ struct HazumiSequencer
   // the widget to color the balls differently when they trigger an output
   bool stored_trigger_results[SEQUENCER_COLUMNS] = { 0,0,0,0,0,0,0,0 };
 
+  // Incremented whenever the balls or column heights change, so that the
+  // widget knows when to draw them again.  Code which writes to them
+  // directly must increment it too.
+  unsigned int revision = 0;
+
   // constructor
   HazumiSequencer()
   {
@@ -73,6 +78,8 @@ struct HazumiSequencer
 
       stored_trigger_results[i] = trigger_results[i];
     }
+
+    revision++;
   }
 
 
@@ -82,6 +89,8 @@ struct HazumiSequencer
     {
       ball_locations[i] = 0;
     }
+
+    revision++;
   }
 
 };
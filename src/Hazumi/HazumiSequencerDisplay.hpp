@@ -15,6 +15,17 @@ struct HazumiSequencerDisplay : TransparentWidget
 
   float color_fades[8] = {1.0,1.0,1.0,1.0,1.0,1.0,1.0,1.0};
 
+  // The grid is drawn into the cached layer, and only drawn again when the
+  // balls or columns change, or while a ball's highlight is fading out.
+  CachedLayer *cached_layer = NULL;
+  unsigned int drawn_revision = 0;
+
+  HazumiSequencerDisplay()
+  {
+    cached_layer = new CachedLayer(Vec(DRAW_AREA_WIDTH, DRAW_AREA_HEIGHT), [this](NVGcontext *vg) { drawGrid(vg); });
+    addChild(cached_layer);
+  }
+
   void HazumiDisplay()
   {
     box.size = Vec(DRAW_AREA_WIDTH, DRAW_AREA_HEIGHT);
@@ -38,57 +49,7 @@ struct HazumiSequencerDisplay : TransparentWidget
 
     if(module)
     {
-      for(unsigned int column=0; column < SEQUENCER_COLUMNS; column++)
-      {
-        for(unsigned int row=0; row < SEQUENCER_ROWS; row++)
-        {
-          // Draw bright backdrop squares for highlighs
-          float x = (column * CELL_WIDTH) + (column * CELL_PADDING);
-          float y = ((SEQUENCER_ROWS - row - 1) * CELL_HEIGHT) + ((SEQUENCER_ROWS - row - 1) * CELL_PADDING);
-
-          // Draw square
-          nvgBeginPath(vg);
-          nvgRect(vg, x, y, CELL_WIDTH, CELL_HEIGHT);
-
-          row = clamp(row, 0, SEQUENCER_ROWS - 1);
-          column = clamp(column, 0, SEQUENCER_COLUMNS - 1);
-
-          // If inside of the height range, then blink
-          if(module->hazumi_sequencer.column_heights[column] > row)
-          {
-            nvgFillColor(vg, nvgLerpRGBA(nvgRGBA(160, 160, 160, 150), nvgRGBA(63, 71, 73, 255), color_fades[column]));
-          }
-          // ouside of the height range
-          else
-          {
-            nvgFillColor(vg, nvgRGB(42, 50, 52));
-          }
-
-          // If we're paintint the square that the ball is on
-          if(module->hazumi_sequencer.ball_locations[column] == row)
-          {
-            // If the ball has triggered an output, paint it brighter
-            if(module->hazumi_sequencer.stored_trigger_results[column] == true)
-            {
-              color_fades[column] = 0;
-              module->hazumi_sequencer.stored_trigger_results[column] = false;
-            }
-
-            // Paint a bright color for the ball
-            // nvgFillColor(vg, nvgRGBA(176, 255, 224, 255));
-            nvgFillColor(vg, nvgRGBA(223,234,236,255));
-
-            // This assumes a consistent draw frequency. I should probably
-            // replace this with code that accurately fades out the alpha at
-            // a exact rate.
-            color_fades[column] += 0.0006f / APP->window->getLastFrameDuration();
-            if(color_fades[column] > 1.0) color_fades[column] = 1.0;
-          }
-
-          nvgFill(vg);
-
-        }
-      }
+      cached_layer->drawCached(args);
     }
     //
     // Paint static content for library display
@@ -148,6 +109,48 @@ struct HazumiSequencerDisplay : TransparentWidget
     nvgRestore(vg);
   }
 
+  void drawGrid(NVGcontext *vg)
+  {
+    for(unsigned int column=0; column < SEQUENCER_COLUMNS; column++)
+    {
+      for(unsigned int row=0; row < SEQUENCER_ROWS; row++)
+      {
+        // Draw bright backdrop squares for highlighs
+        float x = (column * CELL_WIDTH) + (column * CELL_PADDING);
+        float y = ((SEQUENCER_ROWS - row - 1) * CELL_HEIGHT) + ((SEQUENCER_ROWS - row - 1) * CELL_PADDING);
+
+        // Draw square
+        nvgBeginPath(vg);
+        nvgRect(vg, x, y, CELL_WIDTH, CELL_HEIGHT);
+
+        row = clamp(row, 0, SEQUENCER_ROWS - 1);
+        column = clamp(column, 0, SEQUENCER_COLUMNS - 1);
+
+        // If inside of the height range, then blink
+        if(module->hazumi_sequencer.column_heights[column] > row)
+        {
+          nvgFillColor(vg, nvgLerpRGBA(nvgRGBA(160, 160, 160, 150), nvgRGBA(63, 71, 73, 255), color_fades[column]));
+        }
+        // ouside of the height range
+        else
+        {
+          nvgFillColor(vg, nvgRGB(42, 50, 52));
+        }
+
+        // If we're paintint the square that the ball is on
+        if(module->hazumi_sequencer.ball_locations[column] == row)
+        {
+          // Paint a bright color for the ball
+          // nvgFillColor(vg, nvgRGBA(176, 255, 224, 255));
+          nvgFillColor(vg, nvgRGBA(223,234,236,255));
+        }
+
+        nvgFill(vg);
+
+      }
+    }
+  }
+
   std::pair<unsigned int, unsigned int> getRowAndColumnFromVec(Vec position)
   {
     unsigned int row = 17 - (position.y / (CELL_HEIGHT + CELL_PADDING));
@@ -175,6 +178,7 @@ struct HazumiSequencerDisplay : TransparentWidget
           std::tie(row, column) = getRowAndColumnFromVec(e.pos);
 
           module->hazumi_sequencer.column_heights[column] = row;
+          module->hazumi_sequencer.revision++;
 
           // Store the initial drag position
           drag_position = e.pos;
@@ -204,6 +208,7 @@ struct HazumiSequencerDisplay : TransparentWidget
       {
         // this->setSequencerCell(row, column, this->cell_edit_value);
         module->hazumi_sequencer.column_heights[column] = row;
+        module->hazumi_sequencer.revision++;
 
         old_row = row;
         old_column = column;
@@ -240,6 +245,37 @@ struct HazumiSequencerDisplay : TransparentWidget
 
   void step() override {
     TransparentWidget::step();
+
+    if(module)
+    {
+      bool fading = false;
+
+      for(unsigned int column=0; column < SEQUENCER_COLUMNS; column++)
+      {
+        // If the ball has triggered an output, paint it brighter
+        if(module->hazumi_sequencer.stored_trigger_results[column] == true)
+        {
+          color_fades[column] = 0;
+          module->hazumi_sequencer.stored_trigger_results[column] = false;
+        }
+
+        // This assumes a consistent draw frequency. I should probably
+        // replace this with code that accurately fades out the alpha at
+        // a exact rate.
+        if(color_fades[column] < 1.0)
+        {
+          color_fades[column] += 0.0006f / APP->window->getLastFrameDuration();
+          if(color_fades[column] > 1.0) color_fades[column] = 1.0;
+          fading = true;
+        }
+      }
+
+      if(fading || module->hazumi_sequencer.revision != drawn_revision)
+      {
+        drawn_revision = module->hazumi_sequencer.revision;
+        cached_layer->setDirty();
+      }
+    }
   }
 
 };
@@ -6,6 +6,7 @@
 #include "Common/Theme.hpp"
 #include "Common/components/VoxglitchComponents.hpp"
 #include "Common/sample.hpp"
+#include "Common/SampleLoader.hpp"
 #include "Common/SamplePlayer.hpp"
 
 #include "Looper/defines.h"
@@ -2,7 +2,6 @@
 
 struct Looper : VoxglitchSamplerModule
 {
-	std::string loaded_filename = "[ EMPTY ]";
   SamplePlayer sample_player;
   dsp::SchmittTrigger resetTrigger;
   float left_audio = 0;
@@ -27,6 +26,9 @@ struct Looper : VoxglitchSamplerModule
 	{
     config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS);
     configParam(VOLUME_SLIDER, 0.0f, 1.0f, 1.0f, "VolumeSlider");
+
+    // Loops can be long field recordings, so map them instead of decoding
+    sample_player.map_large_files = true;
 	}
 
 	// Autosave module data.  VCV Rack decides when this should be called.
@@ -34,6 +36,7 @@ struct Looper : VoxglitchSamplerModule
 	{
 		json_t *root = json_object();
 		json_object_set_new(root, "loaded_sample_path", json_string(sample_player.getPath().c_str()));
+		json_object_set_new(root, "stream_read_ahead_ms", json_integer(stream_read_ahead_ms));
 
     // Call VoxglitchSamplerModule::saveSamplerData to save sampler data
     saveSamplerData(root);
@@ -44,11 +47,15 @@ struct Looper : VoxglitchSamplerModule
 	// Load module data
 	void dataFromJson(json_t *root) override
 	{
+		// The streaming setting has to be known before the sample is requested
+		json_t *stream_read_ahead_ms_json = json_object_get(root, ("stream_read_ahead_ms"));
+		if (stream_read_ahead_ms_json) setStreamReadAhead(json_integer_value(stream_read_ahead_ms_json));
+
 		json_t *loaded_sample_path = json_object_get(root, ("loaded_sample_path"));
 		if (loaded_sample_path)
 		{
-			if(sample_player.loadSample(json_string_value(loaded_sample_path))) sample_player.trigger(0.0, true); // starting position=0.0, loop=true
-			loaded_filename = sample_player.getFilename();
+			// The sample is loaded in the background and swapped in by process()
+			sample_player.loadSampleAsync(json_string_value(loaded_sample_path));
 		}
 
     // Call VoxglitchSamplerModule::loadSamplerData to load sampler specific data
@@ -57,6 +64,12 @@ struct Looper : VoxglitchSamplerModule
 
 	void process(const ProcessArgs &args) override
 	{
+    // Swap in the sample once it has finished loading in the background and
+    // start looping it from the beginning.
+    if(sample_player.acceptLoadedSample())
+    {
+      sample_player.trigger();
+    }
     if(resetTrigger.process(inputs[RESET_INPUT].getVoltage(), constants::gate_low_trigger, constants::gate_high_trigger))
     {
       sample_player.trigger(); // starting position=0.0, loop=true
@@ -73,6 +86,17 @@ struct Looper : VoxglitchSamplerModule
     outputs[AUDIO_OUTPUT_RIGHT].setVoltage(right_audio * volume);
   }
 
+  void setStreamReadAhead(unsigned int stream_read_ahead_ms) override
+  {
+    VoxglitchSamplerModule::setStreamReadAhead(stream_read_ahead_ms);
+
+    if(sample_player.stream_read_ahead_ms == stream_read_ahead_ms) return;
+    sample_player.stream_read_ahead_ms = stream_read_ahead_ms;
+
+    // Load the sample again so that the new setting takes effect
+    if(sample_player.isLoaded()) sample_player.loadSampleAsync(sample_player.getPath());
+  }
+
   void onSampleRateChange(const SampleRateChangeEvent& e) override
   {
     sample_player.updateSampleRate();
@@ -48,7 +48,7 @@ struct LooperWaveformDisplay : TransparentWidget
     const std::string dir = module->root_dir.empty() ? "" : module->root_dir;
     #ifdef USING_CARDINAL_NOT_RACK
       Looper *module = this->module;
-      async_dialog_filebrowser(false, NULL, dir.c_str(), module->loaded_filename.c_str(), [module](char* path) {
+      async_dialog_filebrowser(false, NULL, dir.c_str(), module->sample_player.getFilename().c_str(), [module](char* path) {
         pathSelected(module, path);
       });
     #else
@@ -62,8 +62,7 @@ struct LooperWaveformDisplay : TransparentWidget
     if (path)
     {
       module->root_dir = std::string(path);
-      module->sample_player.loadSample(std::string(path));
-      module->loaded_filename = module->sample_player.getFilename();
+      module->sample_player.loadSampleAsync(std::string(path));
       free(path);
     }
   }
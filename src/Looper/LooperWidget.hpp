@@ -39,12 +39,17 @@ struct LooperWidget : VoxglitchSamplerModuleWidget
 
     // Add the sample slot to the right-click context menu
     LooperLoadSample *menu_item_load_sample = new LooperLoadSample();
-    menu_item_load_sample->text = module->loaded_filename;
+    std::string filename = module->sample_player.getFilename();
+    menu_item_load_sample->text = (filename == "") ? "[ EMPTY ]" : filename;
     menu_item_load_sample->module = module;
     menu->addChild(menu_item_load_sample);
 
     SampleInterpolationMenuItem *sample_interpolation_menu_item = createMenuItem<SampleInterpolationMenuItem>("Interpolation", RIGHT_ARROW);
     sample_interpolation_menu_item->module = module;
     menu->addChild(sample_interpolation_menu_item);
+
+    DiskStreamingMenuItem *disk_streaming_menu_item = createMenuItem<DiskStreamingMenuItem>("Disk Streaming", RIGHT_ARROW);
+    disk_streaming_menu_item->module = module;
+    menu->addChild(disk_streaming_menu_item);
   }
 };
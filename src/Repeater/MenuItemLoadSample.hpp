@@ -25,8 +25,7 @@ struct MenuItemLoadSample : MenuItem
         if (filename != "")
         {
             module->any_sample_has_been_loaded = true;
-            module->sample_players[sample_number].loadSample(filename);
-            module->loaded_filenames[sample_number] = module->sample_players[sample_number].getFilename();
+            module->sample_players[sample_number].loadSampleAsync(filename);
             module->setRoot(filename);
         }
     }
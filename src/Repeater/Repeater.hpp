@@ -18,7 +18,6 @@ struct Repeater : VoxglitchSamplerModule
 
     // Sample samples[NUMBER_OF_SAMPLES];
     SamplePlayer sample_players[NUMBER_OF_SAMPLES];
-    std::string loaded_filenames[NUMBER_OF_SAMPLES] = {""};
 
     dsp::SchmittTrigger playTrigger;
     dsp::PulseGenerator triggerOutputPulse;
@@ -71,8 +70,6 @@ struct Repeater : VoxglitchSamplerModule
         configParam(SAMPLE_SELECT_KNOB, 0.0f, 1.0f, 0.0f, "SampleSelectKnob");
         configParam(SAMPLE_SELECT_ATTN_KNOB, 0.0f, 1.0f, 1.0f, "SampleSelectAttnKnob");
         configParam(SMOOTH_SWITCH, 0.f, 1.f, 1.f, "Smooth");
-
-        std::fill_n(loaded_filenames, NUMBER_OF_SAMPLES, "[ EMPTY ]");
     }
 
     // Autosave module data.  VCV Rack decides when this should be called.
@@ -97,8 +94,8 @@ struct Repeater : VoxglitchSamplerModule
             json_t *loaded_sample_path = json_object_get(rootJ, ("loaded_sample_path_" + std::to_string(i + 1)).c_str());
             if (loaded_sample_path)
             {
-                sample_players[i].loadSample(json_string_value(loaded_sample_path));
-                loaded_filenames[i] = sample_players[i].getFilename();
+                // The sample is loaded in the background and swapped in by process()
+                sample_players[i].loadSampleAsync(json_string_value(loaded_sample_path));
                 this->any_sample_has_been_loaded = true;
             }
 
@@ -126,6 +123,12 @@ struct Repeater : VoxglitchSamplerModule
     {
         bool trigger_output_pulse = false;
 
+        // Swap in any samples that have finished loading in the background
+        for (unsigned int i = 0; i < NUMBER_OF_SAMPLES; i++)
+        {
+            sample_players[i].acceptLoadedSample();
+        }
+
         unsigned int sample_select_input_value = calculate_inputs(SAMPLE_SELECT_INPUT, SAMPLE_SELECT_KNOB, SAMPLE_SELECT_ATTN_KNOB, NUMBER_OF_SAMPLES_FLOAT);
         sample_select_input_value = clamp(sample_select_input_value, 0, NUMBER_OF_SAMPLES - 1);
 
@@ -187,7 +190,11 @@ struct Repeater : VoxglitchSamplerModule
             float left_output;
             float right_output;
 
-            selected_sample_player->getStereoOutput(&left_output, &right_output, true);
+            // Read the pitch input
+            pitch = inputs[PITCH_INPUT].getVoltage() + params[PITCH_KNOB].getValue();
+
+            // Render audio and step the sample player
+            selected_sample_player->renderFrame(&left_output, &right_output, true, pitch, sample_position, 1.0, retrigger);
 
             wav_output_voltage = GAIN * left_output;
 
@@ -197,12 +204,6 @@ struct Repeater : VoxglitchSamplerModule
 
             // Output voltage
             outputs[WAV_OUTPUT].setVoltage(wav_output_voltage);
-
-            // Read the pitch input
-            pitch = inputs[PITCH_INPUT].getVoltage() + params[PITCH_KNOB].getValue();
-
-            // Step the sample player
-            selected_sample_player->step(pitch, sample_position, 1.0, retrigger);
         }
         else
         {
@@ -9,6 +9,7 @@
 #include "Common/sample.hpp"
 #include "Common/Theme.hpp"
 #include "Common/components/VoxglitchComponents.hpp"
+#include "Common/SampleLoader.hpp"
 #include "Common/SamplePlayer.hpp"
 #include "Common/dsp/StereoPan.hpp"
 
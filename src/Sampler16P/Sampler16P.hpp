@@ -1,6 +1,5 @@
 struct Sampler16P : VoxglitchSamplerModule
 {
-	std::string loaded_filenames[NUMBER_OF_SAMPLES] = {""};
   std::vector<SamplePlayer> sample_players;
   dsp::SchmittTrigger sample_triggers[NUMBER_OF_SAMPLES];
 
@@ -33,8 +32,6 @@ struct Sampler16P : VoxglitchSamplerModule
 	{
     config(NUM_PARAMS, NUM_INPUTS, NUM_OUTPUTS, NUM_LIGHTS);
 
-    std::fill_n(loaded_filenames, NUMBER_OF_SAMPLES, "[ EMPTY ]");
-
     for(unsigned int i=0; i<NUMBER_OF_SAMPLES; i++)
     {
       SamplePlayer sample_player;
@@ -71,10 +68,8 @@ struct Sampler16P : VoxglitchSamplerModule
 			json_t *loaded_sample_path = json_object_get(root, ("loaded_sample_path_" +  std::to_string(i+1)).c_str());
 			if (loaded_sample_path)
 			{
-				if(sample_players[i].loadSample(json_string_value(loaded_sample_path)))
-        {
-          loaded_filenames[i] = sample_players[i].getFilename();
-        }
+        // The sample is loaded in the background and swapped in by process()
+				sample_players[i].loadSampleAsync(json_string_value(loaded_sample_path));
 			}
 		}
 
@@ -92,6 +87,9 @@ struct Sampler16P : VoxglitchSamplerModule
 
     for(unsigned int i=0; i<NUMBER_OF_SAMPLES; i++)
     {
+      // Swap in any samples that have finished loading in the background
+      sample_players[i].acceptLoadedSample();
+
       // Process trigger inputs to start sample playback
       if (sample_triggers[i].process(inputs[TRIGGER_INPUTS].getVoltage(i), constants::gate_low_trigger, constants::gate_high_trigger))
       {
@@ -99,16 +97,13 @@ struct Sampler16P : VoxglitchSamplerModule
       }
 
       //
-      // Send audio to outputs
+      // Render audio and step the sample player
       float left_audio, right_audio;
-      sample_players[i].getStereoOutput(&left_audio, &right_audio, interpolation);
+      sample_players[i].renderFrame(&left_audio, &right_audio, interpolation);
 
       // Sum up the output for the mix L/R output
       summed_output_left += left_audio;
       summed_output_right += right_audio;
-
-      // Step samples
-      sample_players[i].step();
     }
 
     // Output summed output
@@ -41,8 +41,7 @@ struct Sampler16PLoadFolder : MenuItem
 				{
 					if (i < 8)
 					{
-						module->sample_players[i].loadSample(std::string(entry));
-						module->loaded_filenames[i] = module->sample_players[i].getFilename();
+						module->sample_players[i].loadSampleAsync(std::string(entry));
 						i++;
 					}
 				}
@@ -1,6 +1,5 @@
 struct SamplerX8 : VoxglitchSamplerModule
 {
-	std::string loaded_filenames[NUMBER_OF_SAMPLES] = {""};
   std::vector<SamplePlayer> sample_players;
   dsp::SchmittTrigger sample_triggers[NUMBER_OF_SAMPLES];
 
@@ -49,8 +48,6 @@ struct SamplerX8 : VoxglitchSamplerModule
       configOutput(AUDIO_RIGHT_OUTPUTS + i, "right");
     }
 
-    std::fill_n(loaded_filenames, NUMBER_OF_SAMPLES, "[ EMPTY ]");
-
     for(unsigned int i=0; i<NUMBER_OF_SAMPLES; i++)
     {
       SamplePlayer sample_player;
@@ -85,10 +82,8 @@ struct SamplerX8 : VoxglitchSamplerModule
 			json_t *loaded_sample_path = json_object_get(root, ("loaded_sample_path_" +  std::to_string(i+1)).c_str());
 			if (loaded_sample_path)
 			{
-				if(sample_players[i].loadSample(json_string_value(loaded_sample_path)))
-        {
-          loaded_filenames[i] = sample_players[i].getFilename();
-        }
+        // The sample is loaded in the background and swapped in by process()
+				sample_players[i].loadSampleAsync(json_string_value(loaded_sample_path));
 			}
 		}
 
@@ -104,6 +99,9 @@ struct SamplerX8 : VoxglitchSamplerModule
 
     for(unsigned int i=0; i<NUMBER_OF_SAMPLES; i++)
     {
+      // Swap in any samples that have finished loading in the background
+      sample_players[i].acceptLoadedSample();
+
       // Process trigger inputs to start sample playback
       if (sample_triggers[i].process(inputs[TRIGGER_INPUTS + i].getVoltage(), constants::gate_low_trigger, constants::gate_high_trigger))
       {
@@ -118,9 +116,10 @@ struct SamplerX8 : VoxglitchSamplerModule
       }
 
       //
-      // Send audio to outputs
+      // Render audio and step the sample player.  The rest of the arguments
+      // match step(pitch, sample_start, sample_end, loop).
       float left_audio, right_audio;
-      sample_players[i].getStereoOutput(&left_audio, &right_audio, interpolation);
+      sample_players[i].renderFrame(&left_audio, &right_audio, interpolation, 0.0, inputs[POSITION_INPUTS + i].getVoltage(), 1.0, false);
 
       // Apply volume knobs
       left_audio = (left_audio * params[VOLUME_KNOBS + i].getValue());
@@ -140,11 +139,6 @@ struct SamplerX8 : VoxglitchSamplerModule
         summed_output_left += left_audio;
         summed_output_right += right_audio;
       }
-
-      // Step samples
-      // step(float pitch = 0.0, float sample_start = 0.0, float sample_end = 1.0, bool loop = false)
-      sample_players[i].step(0.0, inputs[POSITION_INPUTS + i].getVoltage(), 1.0, false);
-
     }
 
     // Output summed output
@@ -24,11 +24,8 @@ struct SamplerX8LoadSample : MenuItem
 	{
 		if (filename != "")
 		{
-      if(module->sample_players[sample_number].loadSample(filename))
-      {
-  			module->loaded_filenames[sample_number] = module->sample_players[sample_number].getFilename();
-        module->setRoot(filename);
-      }
+      module->sample_players[sample_number].loadSampleAsync(filename);
+      module->setRoot(filename);
 		}
 	}
 };
@@ -102,7 +102,8 @@ struct SamplerX8Widget : VoxglitchSamplerModuleWidget
     {
       SamplerX8LoadSample *menu_item_load_sample = new SamplerX8LoadSample();
       menu_item_load_sample->sample_number = i;
-      menu_item_load_sample->text = std::to_string(i+1) + ": " + module->loaded_filenames[i];
+      std::string filename = module->sample_players[i].getFilename();
+      menu_item_load_sample->text = std::to_string(i+1) + ": " + (filename == "" ? "[ EMPTY ]" : filename);
       menu_item_load_sample->module = module;
       menu->addChild(menu_item_load_sample);
     }
@@ -8,6 +8,7 @@
 #include "Common/constants.h"
 #include "Common/Theme.hpp"
 #include "Common/components/VoxglitchComponents.hpp"
+#include "Common/dsp/DelayLine.hpp"
 
 // #include "ByteBeat/calculator.hpp"
 #include "Satanonaut/defines.h"
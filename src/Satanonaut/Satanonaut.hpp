@@ -64,9 +64,15 @@ struct Satanonaut : Module
     configParam(DRIVE_KNOB, 1, 60, 1, "DriveKnob");
 
     rack::random::init();
+    audio_buffer.setSampleRate(APP->engine->getSampleRate());
     audio_buffer.purge();
 	}
 
+  void onSampleRateChange(const SampleRateChangeEvent &e) override
+  {
+    audio_buffer.setSampleRate(e.sampleRate);
+  }
+
 	// Autosave module data.  VCV Rack decides when this should be called.
 	json_t *dataToJson() override
 	{
@@ -142,7 +148,8 @@ struct Satanonaut : Module
     selected_effect = snapped_attenuverter_input(EFFECT_INPUT, EFFECT_KNOB, 0, NUMBER_OF_EFFECTS);
     param_1_input = attenuverter_input(PARAM_1_INPUT, PARAM_1_KNOB); // ranges from 0 to 1
     param_2_input = attenuverter_input(PARAM_2_INPUT, PARAM_2_KNOB); // ranges from 0 to 1
-    buffer_size = clamp((int) (attenuverter_input(BUFFER_SIZE_INPUT, BUFFER_SIZE_KNOB) * (float) MAX_BUFFER_SIZE), MIN_BUFFER_SIZE, MAX_BUFFER_SIZE);
+    int max_buffer_size = audio_buffer.getMaxBufferSize();
+    buffer_size = clamp((int) (attenuverter_input(BUFFER_SIZE_INPUT, BUFFER_SIZE_KNOB) * (float) max_buffer_size), MIN_BUFFER_SIZE, max_buffer_size);
     feedback = clamp(attenuverter_input(FEEDBACK_INPUT, FEEDBACK_KNOB), 0.0, 1.0);
     drive = params[DRIVE_KNOB].getValue();
 
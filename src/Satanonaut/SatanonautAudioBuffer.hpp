@@ -1,25 +1,24 @@
 #pragma once
 
-#define MAX_BUFFER_SIZE 44100
-#define MIN_BUFFER_SIZE 10
+//
+// Mono version of SatanonautStereoAudioBuffer.  See that file for details.
+//
 
 struct SatanonautAudioBuffer
 {
   int read_head = 0;
   unsigned int write_head = 0;
 
-	float playBuffer[MAX_BUFFER_SIZE];
+	DelayLine playBuffer;
   int sample_position = 0;
   float feedback = 0.0;
 
   uint32_t buffer_size = 44100;
+  uint32_t max_buffer_size = 44100;
 
 	SatanonautAudioBuffer()
 	{
-    for(unsigned int i=0; i<MAX_BUFFER_SIZE; i++)
-    {
-      playBuffer[i] = 0.0;
-    }
+    setSampleRate(44100);
 	}
 
 	virtual ~SatanonautAudioBuffer() {}
@@ -27,17 +26,17 @@ struct SatanonautAudioBuffer
 	virtual void push(float audio)
 	{
     write_head++;
-    if(write_head >= buffer_size || write_head >= MAX_BUFFER_SIZE) write_head = 0;
+    if(write_head >= buffer_size || write_head >= max_buffer_size) write_head = 0;
 
     if(feedback == 0)
     {
-      playBuffer[write_head] = audio;
+      playBuffer.at(write_head) = audio;
     }
     else
     {
-      float existing_audio = playBuffer[write_head];
+      float existing_audio = playBuffer.at(write_head);
       float mixed_audio = (existing_audio * feedback) + (audio * (1.0 - feedback));
-      playBuffer[write_head] = mixed_audio;
+      playBuffer.at(write_head) = mixed_audio;
     }
 
 	};
@@ -45,15 +44,19 @@ struct SatanonautAudioBuffer
   float getOutput(int sample_position)
   {
     if(buffer_size <= 0) buffer_size = 1;
-    if(buffer_size > MAX_BUFFER_SIZE) buffer_size = MAX_BUFFER_SIZE - 1;
+    if(buffer_size > max_buffer_size) buffer_size = max_buffer_size - 1;
 
-    unsigned int index = 0;
-    float output = 0;
+    unsigned int index = sample_position % buffer_size;
+    return(playBuffer.at(index));
+  }
 
-    index = sample_position % buffer_size;
-    if(index < sizeof(playBuffer)) output = playBuffer[index]; // very paranoid!
+  void setSampleRate(float sample_rate)
+  {
+    max_buffer_size = sample_rate;
+    playBuffer.setCapacity(max_buffer_size);
 
-    return(output);
+    if(buffer_size > max_buffer_size) buffer_size = max_buffer_size;
+    if(write_head >= max_buffer_size) write_head = 0;
   }
 
   uint32_t getBufferSize()
@@ -63,7 +66,7 @@ struct SatanonautAudioBuffer
 
   uint32_t getMaxBufferSize()
   {
-    return(MAX_BUFFER_SIZE);
+    return(max_buffer_size);
   }
 
   void setBufferSize(uint32_t new_buffer_size)
@@ -83,9 +86,6 @@ struct SatanonautAudioBuffer
 
   void purge()
   {
-    for(unsigned int i=0; i < MAX_BUFFER_SIZE; i++)
-    {
-      playBuffer[i] = 0.0;
-    }
+    playBuffer.clear();
   }
 };
@@ -1,26 +1,28 @@
 #pragma once
 
-#define MAX_BUFFER_SIZE 44100
-#define MIN_BUFFER_SIZE 10
+//
+// The effects index this buffer directly (modulo the buffer size) rather than
+// relative to the write head, so it uses DelayLine only for storage.  The
+// largest buffer is one second at the engine's sample rate.  setSampleRate()
+// allocates it, so it's called from the module's constructor and
+// onSampleRateChange(), never from process().
+//
 
 struct SatanonautStereoAudioBuffer
 {
   int read_head = 0;
   unsigned int write_head = 0;
 
-	float buffer_left[MAX_BUFFER_SIZE];
-  float buffer_right[MAX_BUFFER_SIZE];
+	DelayLine buffer_left;
+  DelayLine buffer_right;
   float feedback = 0.0;
 
   uint32_t buffer_size = 44100;
+  uint32_t max_buffer_size = 44100;
 
 	SatanonautStereoAudioBuffer()
 	{
-    for(unsigned int i=0; i<MAX_BUFFER_SIZE; i++)
-    {
-      buffer_left[i] = 0.0;
-      buffer_right[i] = 0.0;
-    }
+    setSampleRate(44100);
 	}
 
 	virtual ~SatanonautStereoAudioBuffer() {}
@@ -28,24 +30,24 @@ struct SatanonautStereoAudioBuffer
 	virtual void push(float audio_left, float audio_right)
 	{
     write_head++;
-    if(write_head >= buffer_size || write_head >= MAX_BUFFER_SIZE) write_head = 0;
+    if(write_head >= buffer_size || write_head >= max_buffer_size) write_head = 0;
 
     if(feedback == 0)
     {
-      buffer_left[write_head] = audio_left;
-      buffer_right[write_head] = audio_right;
+      buffer_left.at(write_head) = audio_left;
+      buffer_right.at(write_head) = audio_right;
     }
     else
     {
-      float existing_audio_left = buffer_left[write_head];
-      float existing_audio_right = buffer_right[write_head];
+      float existing_audio_left = buffer_left.at(write_head);
+      float existing_audio_right = buffer_right.at(write_head);
 
       float mixed_audio_left = (existing_audio_left * feedback) + (audio_left * (1.0 - feedback));
       float mixed_audio_right = (existing_audio_right * feedback) + (audio_right * (1.0 - feedback));
 
       // float mixed_audio = (existing_audio * feedback);
-      buffer_left[write_head] = mixed_audio_left;
-      buffer_right[write_head] = mixed_audio_right;
+      buffer_left.at(write_head) = mixed_audio_left;
+      buffer_right.at(write_head) = mixed_audio_right;
     }
 
 	};
@@ -53,20 +55,21 @@ struct SatanonautStereoAudioBuffer
   std::pair<float, float> valueAt(int sample_position)
   {
     if(buffer_size <= 0) buffer_size = 1;
-    if(buffer_size > MAX_BUFFER_SIZE) buffer_size = MAX_BUFFER_SIZE - 1;
-
-    float output_left = 0;
-    float output_right = 0;
+    if(buffer_size > max_buffer_size) buffer_size = max_buffer_size - 1;
 
     unsigned int index = sample_position % buffer_size;
 
-    if(index < sizeof(buffer_left)) // very paranoid!
-    {
-      output_left = buffer_left[index];
-      output_right = buffer_right[index];
-    }
+    return { buffer_left.at(index), buffer_right.at(index) };
+  }
+
+  void setSampleRate(float sample_rate)
+  {
+    max_buffer_size = sample_rate;
+    buffer_left.setCapacity(max_buffer_size);
+    buffer_right.setCapacity(max_buffer_size);
 
-    return { output_left, output_right };
+    if(buffer_size > max_buffer_size) buffer_size = max_buffer_size;
+    if(write_head >= max_buffer_size) write_head = 0;
   }
 
   uint32_t getBufferSize()
@@ -76,7 +79,7 @@ struct SatanonautStereoAudioBuffer
 
   uint32_t getMaxBufferSize()
   {
-    return(MAX_BUFFER_SIZE);
+    return(max_buffer_size);
   }
 
   void setBufferSize(uint32_t new_buffer_size)
@@ -96,10 +99,7 @@ struct SatanonautStereoAudioBuffer
 
   void purge()
   {
-    for(unsigned int i=0; i < MAX_BUFFER_SIZE; i++)
-    {
-      buffer_left[i] = 0.0;
-      buffer_right[i] = 0.0;
-    }
+    buffer_left.clear();
+    buffer_right.clear();
   }
 };
@@ -1,6 +1,7 @@
 // #define _TIME_DRAWING 1
 
 #define NUMBER_OF_EFFECTS 13
+#define MIN_BUFFER_SIZE 10
 
 #define COLUMN_1 9.525
 #define COLUMN_2 19.050
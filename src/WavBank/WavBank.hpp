@@ -1,3 +1,56 @@
+//
+// The sample players for the .wav files in one folder.  See
+// SampleBankResidency.hpp.
+//
+struct WavBankSamples : SampleBank
+{
+	std::vector<SamplePlayer> sample_players;
+
+	// Set from the GUI thread, and passed on to the sample players by the
+	// SampleBankWorker as it requests them
+	std::atomic<unsigned int> stream_read_ahead_ms;
+
+	WavBankSamples(const std::vector<std::string> &paths, unsigned int stream_read_ahead_ms) : SampleBank(paths), stream_read_ahead_ms(stream_read_ahead_ms)
+	{
+		// Create all of the sample players before requesting any samples.  Growing
+		// the vector copies the sample players, which would drop pending requests.
+		sample_players.resize(paths.size());
+
+		for (SamplePlayer &sample_player : sample_players)
+		{
+			sample_player.map_large_files = true;
+			sample_player.stream_read_ahead_ms = stream_read_ahead_ms;
+		}
+	}
+
+	void load(unsigned int slot, bool urgent) override
+	{
+		sample_players[slot].stream_read_ahead_ms = stream_read_ahead_ms;
+		sample_players[slot].loadSampleAsync(residency.paths[slot], urgent);
+	}
+
+	void unload(unsigned int slot) override
+	{
+		sample_players[slot].unloadSampleAsync();
+	}
+
+	void prioritize(unsigned int slot) override
+	{
+		if (sample_players[slot].isLoading())
+			sample_players[slot].prioritizeLoad();
+	}
+
+	// Loads the samples again if the streaming setting has changed
+	void reload() override
+	{
+		for (unsigned int slot = 0; slot < sample_players.size(); slot++)
+		{
+			if (residency.isResident(slot) && sample_players[slot].stream_read_ahead_ms != stream_read_ahead_ms)
+				load(slot, false);
+		}
+	}
+};
+
 struct WavBank : VoxglitchSamplerModule
 {
 	unsigned int selected_sample_slot = 0;
@@ -8,9 +61,15 @@ struct WavBank : VoxglitchSamplerModule
 	unsigned int trig_input_response_mode = TRIGGER;
 	std::string rootDir;
 	std::string path;
-	bool loading_samples = false;
-
-	std::vector<SamplePlayer> sample_players;
+	unsigned int load_check_index = 0;
+
+	// The bank which process() is playing, and the newest one, which is the
+	// one that the GUI shows.  They only differ for the few milliseconds
+	// before process() picks up a newly loaded folder.
+	std::shared_ptr<SampleBank> playing_bank;
+	WavBankSamples *playing_samples = NULL;
+	std::shared_ptr<WavBankSamples> bank;
+	std::shared_ptr<SampleBankHost> bank_host = std::make_shared<SampleBankHost>();
 	dsp::SchmittTrigger playTrigger;
 	DeclickFilter declick_filter;
 
@@ -62,12 +121,34 @@ struct WavBank : VoxglitchSamplerModule
 		json_t *json_root = json_object();
 		json_object_set_new(json_root, "path", json_string(this->path.c_str()));
 		json_object_set_new(json_root, "trig_input_response_mode", json_integer(trig_input_response_mode));
+		json_object_set_new(json_root, "stream_read_ahead_ms", json_integer(stream_read_ahead_ms));
+		json_object_set_new(json_root, "load_on_demand", json_boolean(bank_host->load_on_demand));
+		json_object_set_new(json_root, "resident_sample_limit", json_integer(bank_host->resident_limit));
 		return json_root;
 	}
 
 	// Load
 	void dataFromJson(json_t *json_root) override
 	{
+		// The streaming setting has to be known before the samples are requested
+		json_t *stream_read_ahead_ms_json = json_object_get(json_root, "stream_read_ahead_ms");
+		if (stream_read_ahead_ms_json)
+			stream_read_ahead_ms = json_integer_value(stream_read_ahead_ms_json);
+
+		// So does the on-demand setting
+		bool load_on_demand = bank_host->load_on_demand;
+		unsigned int resident_limit = bank_host->resident_limit;
+
+		json_t *load_on_demand_json = json_object_get(json_root, "load_on_demand");
+		if (load_on_demand_json)
+			load_on_demand = json_boolean_value(load_on_demand_json);
+
+		json_t *resident_sample_limit_json = json_object_get(json_root, "resident_sample_limit");
+		if (resident_sample_limit_json)
+			resident_limit = json_integer_value(resident_sample_limit_json);
+
+		bank_host->configure(load_on_demand, resident_limit);
+
 		json_t *loaded_path_json = json_object_get(json_root, ("path"));
 		if (loaded_path_json)
 		{
@@ -83,11 +164,6 @@ struct WavBank : VoxglitchSamplerModule
 
 	void load_samples_from_path(std::string path)
 	{
-		loading_samples = true;
-
-		// Clear out any old .wav files
-		this->sample_players.clear();
-
 		// Load all .wav files found in the folder specified by 'path'
 		// this->rootDir = std::string(path);
 
@@ -98,20 +174,40 @@ struct WavBank : VoxglitchSamplerModule
 		sort(dirList.begin(), dirList.end());
 
 		// TODO: Consider supporting MP3.
+		std::vector<std::string> wav_paths;
+
 		for (auto path : dirList)
 		{
 			if (
 				(rack::string::lowercase(system::getExtension(path)) == "wav") ||
 				(rack::string::lowercase(system::getExtension(path)) == ".wav"))
 			{
-				SamplePlayer sample_player;
-
-				sample_player.loadSample(path);
-				this->sample_players.push_back(sample_player);
+				wav_paths.push_back(path);
 			}
 		}
 
-		loading_samples = false;
+		// The old bank keeps playing until process() swaps in the new one.  The
+		// SampleBankWorker then requests the .wav files, which are read in the
+		// background and swapped in by process() as they're ready.
+		bank = std::make_shared<WavBankSamples>(wav_paths, stream_read_ahead_ms);
+		SampleBankWorker::instance().assign(bank_host, bank);
+	}
+
+	void setLoadOnDemand(bool load_on_demand, unsigned int resident_limit)
+	{
+		bank_host->configure(load_on_demand, resident_limit);
+	}
+
+	void setStreamReadAhead(unsigned int stream_read_ahead_ms) override
+	{
+		VoxglitchSamplerModule::setStreamReadAhead(stream_read_ahead_ms);
+
+		// Load the samples again so that the new setting takes effect
+		if (bank)
+		{
+			bank->stream_read_ahead_ms = stream_read_ahead_ms;
+			bank_host->reload();
+		}
 	}
 
 	float calculate_inputs(int input_index, int knob_index, int attenuator_index, float scale)
@@ -125,12 +221,30 @@ struct WavBank : VoxglitchSamplerModule
 
 	void process(const ProcessArgs &args) override
 	{
-		// If the samples are being loaded, don't do anything
-		if (loading_samples)
+		// Pick up a newly loaded folder
+		if (bank_host->accept(playing_bank))
+		{
+			playing_samples = static_cast<WavBankSamples *>(playing_bank.get());
+			load_check_index = 0;
+			declick_filter.trigger();
+		}
+
+		// If no folder has been loaded yet, don't do anything
+		if (playing_samples == NULL)
 			return;
 
+		std::vector<SamplePlayer> &sample_players = playing_samples->sample_players;
 		unsigned int number_of_samples = sample_players.size();
 
+		// Swap in samples that have finished loading in the background.  Checking
+		// one slot per frame keeps the cost of this constant, no matter how many
+		// samples are in the bank.
+		if (number_of_samples > 0)
+		{
+			load_check_index = (load_check_index + 1) % number_of_samples;
+			sample_players[load_check_index].acceptLoadedSample();
+		}
+
 		// Read the input/knob for sample selection
 		unsigned int wav_input_value = calculate_inputs(WAV_INPUT, WAV_KNOB, WAV_ATTN_KNOB, number_of_samples);
 		wav_input_value = clamp(wav_input_value, 0, number_of_samples - 1);
@@ -150,7 +264,8 @@ struct WavBank : VoxglitchSamplerModule
 			declick_filter.trigger();
 
 			// Reset sample position so playback does not start at previous sample position
-			sample_players[selected_sample_slot].stop();
+			if (selected_sample_slot < number_of_samples)
+				sample_players[selected_sample_slot].stop();
 
 			// Set the selected sample
 			selected_sample_slot = wav_input_value;
@@ -158,6 +273,9 @@ struct WavBank : VoxglitchSamplerModule
 			playback = false;
 		}
 
+		// The SampleBankWorker loads the selected sample, and its neighbours
+		bank_host->select(selected_sample_slot);
+
 		// Check to see if the selected sample slot refers to an existing sample.
 		// If not, return.  This could happen before any samples have been loaded.
 		if (!(sample_players.size() > selected_sample_slot))
@@ -165,6 +283,9 @@ struct WavBank : VoxglitchSamplerModule
 
 		SamplePlayer *selected_sample_player = &sample_players[selected_sample_slot];
 
+		// Don't wait for the round-robin check if the selected sample is ready
+		selected_sample_player->acceptLoadedSample();
+
 		if (inputs[TRIG_INPUT].isConnected())
 		{
 			if (trig_input_response_mode == TRIGGER)
@@ -24,7 +24,8 @@ struct WavBankReadout : TransparentWidget
 		{
 			text_to_display = "";
 
-      unsigned int number_of_sample = module->sample_players.size();
+      std::shared_ptr<WavBankSamples> bank = module->bank;
+      unsigned int number_of_sample = bank ? bank->size() : 0;
 
       if(number_of_sample > 0)
       {
@@ -66,18 +67,23 @@ struct WavBankReadout : TransparentWidget
 
         for(unsigned int i = window_start; i < window_end; i++)
         {
-          text_to_display = module->sample_players[i].sample.display_name;
+          text_to_display = bank->residency.display_names[i];
           text_to_display.resize(22);
 
+          // Samples which are still loading, or which aren't loaded at all
+          // when loading on demand, are dimmed
+          unsigned char alpha = 0xff;
+          if(bank->sample_players[i].isLoading() || ! bank->residency.isResident(i)) alpha = 0x70;
+
           if(i == module->selected_sample_slot || (show_hover_effect && hover_row == i))
           {
             // nvgFillColor(args.vg, nvgRGBA(122, 179, 193, 0xff));
-            nvgFillColor(args.vg, nvgRGBA(150, 219, 234, 0xff));
+            nvgFillColor(args.vg, nvgRGBA(150, 219, 234, alpha));
           }
           else
           {
             // nvgFillColor(args.vg, nvgRGBA(73, 107, 116, 0xff));
-            nvgFillColor(args.vg, nvgRGBA(102, 151, 163, 0xff));
+            nvgFillColor(args.vg, nvgRGBA(102, 151, 163, alpha));
           }
 
           nvgText(args.vg, 0, 6.3 + ((i - window_start) * 14), text_to_display.c_str(), NULL);
@@ -68,6 +68,48 @@ struct WavBankWidget : VoxglitchSamplerModuleWidget
 
   // }} End of trigger mode menu code
 
+  //
+  // menu structure for loading samples on demand
+  //
+
+  struct LoadOnDemandOption : MenuItem {
+    WavBank *module;
+    bool load_on_demand = false;
+    unsigned int resident_limit = 0;
+
+    void onAction(const event::Action &e) override {
+      module->setLoadOnDemand(load_on_demand, resident_limit);
+    }
+  };
+
+  struct LoadOnDemandMenu : MenuItem {
+    WavBank *module;
+
+    Menu *createChildMenu() override {
+      Menu *menu = new Menu;
+
+      LoadOnDemandOption *off_option = createMenuItem<LoadOnDemandOption>("Off (load the whole folder)", CHECKMARK(! module->bank_host->load_on_demand));
+      off_option->module = module;
+      off_option->resident_limit = module->bank_host->resident_limit;
+      menu->addChild(off_option);
+
+      menu->addChild(createMenuLabel("Samples kept in memory"));
+
+      unsigned int resident_limit_options[] = { 8, 16, 32, 64, 128 };
+
+      for(unsigned int resident_limit : resident_limit_options)
+      {
+        LoadOnDemandOption *option = createMenuItem<LoadOnDemandOption>(std::to_string(resident_limit), CHECKMARK(module->bank_host->load_on_demand && module->bank_host->resident_limit == resident_limit));
+        option->module = module;
+        option->load_on_demand = true;
+        option->resident_limit = resident_limit;
+        menu->addChild(option);
+      }
+
+      return menu;
+    }
+  };
+
 
 	void appendContextMenu(Menu *menu) override
 	{
@@ -92,6 +134,14 @@ struct WavBankWidget : VoxglitchSamplerModuleWidget
     SampleInterpolationMenuItem *sample_interpolation_menu_item = createMenuItem<SampleInterpolationMenuItem>("Interpolation", RIGHT_ARROW);
     sample_interpolation_menu_item->module = module;
     menu->addChild(sample_interpolation_menu_item);
+
+    DiskStreamingMenuItem *disk_streaming_menu_item = createMenuItem<DiskStreamingMenuItem>("Disk Streaming", RIGHT_ARROW);
+    disk_streaming_menu_item->module = module;
+    menu->addChild(disk_streaming_menu_item);
+
+    LoadOnDemandMenu *load_on_demand_menu = createMenuItem<LoadOnDemandMenu>("Load on Demand", RIGHT_ARROW);
+    load_on_demand_menu->module = module;
+    menu->addChild(load_on_demand_menu);
 	}
 
 };
@@ -22,9 +22,9 @@ struct MenuItemLoadBankMC : MenuItem
 	{
 		if (path != "")
 		{
+			module->selected_sample_slot = 0;
 			module->load_samples_from_path(path);
 			module->path = path;
-			module->selected_sample_slot = 0;
 			module->setRoot(path);
 		}
 	}
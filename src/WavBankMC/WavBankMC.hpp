@@ -1,3 +1,58 @@
+//
+// The multi-channel samples for the .wav files in one folder.  See
+// SampleBankResidency.hpp.
+//
+struct WavBankMCSamples : SampleBank
+{
+  std::vector<SampleMC> samples;
+  std::vector< LoadSlot<SampleMCLoadRequest> > load_slots;
+
+  // Create all of the (empty) multi-channel samples up front.  They're
+  // filled in by process() as the files are read in the background.
+  WavBankMCSamples(const std::vector<std::string> &paths) : SampleBank(paths)
+  {
+    samples.resize(paths.size());
+    load_slots.resize(paths.size());
+  }
+
+  void load(unsigned int slot, bool urgent) override
+  {
+    load_slots[slot].post(SampleLoader::instance().submit(new SampleMCLoadRequest(residency.paths[slot]), urgent));
+  }
+
+  void unload(unsigned int slot) override
+  {
+    load_slots[slot].post(SampleLoader::instance().submit(new SampleMCLoadRequest("")));
+  }
+
+  void prioritize(unsigned int slot) override
+  {
+    SampleLoader::instance().prioritize(load_slots[slot].peek());
+  }
+
+  // False while a sample is loading, or when it isn't loaded at all
+  bool isReady(unsigned int slot)
+  {
+    return(slot < load_slots.size() && residency.isResident(slot) && ! load_slots[slot].pending());
+  }
+
+  // Swaps in a sample which has finished loading in the background.  Called
+  // from process().
+  bool accept(unsigned int slot)
+  {
+    SampleMCLoadRequest *load_request = load_slots[slot].take();
+    if(load_request == NULL) return(false);
+
+    bool success = load_request->success;
+    if(success) samples[slot].swap(load_request->sample);
+
+    // The request now holds the old sample data, which the loader will free
+    load_request->release();
+
+    return(success);
+  }
+};
+
 //
 // WavBankMC
 //
@@ -27,7 +82,15 @@ struct WavBankMC : VoxglitchSamplerModule
 
   unsigned int number_of_samples = 0;
   bool smoothing = true;
-	std::vector<SampleMC> samples;
+  unsigned int load_check_index = 0;
+
+  // The bank which process() is playing, and the newest one, which is the
+  // one that the GUI shows.  They only differ for the few milliseconds
+  // before process() picks up a newly loaded folder.
+  std::shared_ptr<SampleBank> playing_bank;
+  WavBankMCSamples *playing_samples = NULL;
+  std::shared_ptr<WavBankMCSamples> bank;
+  std::shared_ptr<SampleBankHost> bank_host = std::make_shared<SampleBankHost>();
   unsigned int sample_change_mode = RESTART_PLAYBACK;
 
 	enum ParamIds {
@@ -91,12 +154,25 @@ struct WavBankMC : VoxglitchSamplerModule
 		json_object_set_new(json_root, "path", json_string(this->path.c_str()));
     json_object_set_new(json_root, "sample_change_mode", json_integer(sample_change_mode));
     json_object_set_new(json_root, "smoothing", json_integer(smoothing));
+    json_object_set_new(json_root, "load_on_demand", json_boolean(bank_host->load_on_demand));
+    json_object_set_new(json_root, "resident_sample_limit", json_integer(bank_host->resident_limit));
 		return json_root;
 	}
 
   // Load
 	void dataFromJson(json_t *json_root) override
 	{
+    // The on-demand setting has to be known before the samples are requested
+    bool load_on_demand = bank_host->load_on_demand;
+    unsigned int resident_limit = bank_host->resident_limit;
+
+    json_t *load_on_demand_json = json_object_get(json_root, "load_on_demand");
+    if (load_on_demand_json) load_on_demand = json_boolean_value(load_on_demand_json);
+
+    json_t *resident_sample_limit_json = json_object_get(json_root, "resident_sample_limit");
+    if (resident_sample_limit_json) resident_limit = json_integer_value(resident_sample_limit_json);
+
+    bank_host->configure(load_on_demand, resident_limit);
 
 		json_t *loaded_path_json = json_object_get(json_root, ("path"));
 		if (loaded_path_json)
@@ -146,7 +222,7 @@ struct WavBankMC : VoxglitchSamplerModule
 
   void increment_selected_sample()
   {
-    change_selected_sample((selected_sample_slot + 1) % this->samples.size());
+    change_selected_sample((selected_sample_slot + 1) % number_of_samples);
   }
 
   void decrement_selected_sample()
@@ -157,13 +233,13 @@ struct WavBankMC : VoxglitchSamplerModule
     }
     else
     {
-      change_selected_sample(this->samples.size() - 1);
+      change_selected_sample(number_of_samples - 1);
     }
   }
 
   void change_selected_sample(unsigned int new_sample_slot)
   {
-    if(this->samples.size() != 0)
+    if(number_of_samples != 0)
     {
       // Reset the smooth ramp if the selected sample has changed
       smooth_all_channels();
@@ -206,7 +282,7 @@ struct WavBankMC : VoxglitchSamplerModule
   {
     unsigned int wav_input_value = params[WAV_KNOB].getValue() * number_of_samples;
 
-    if(this->samples.size() == 0) return;
+    if(number_of_samples == 0) return;
 
 		wav_input_value = clamp(wav_input_value, 0, number_of_samples - 1);
     previous_wav_knob_value = params[WAV_KNOB].getValue();
@@ -226,7 +302,7 @@ struct WavBankMC : VoxglitchSamplerModule
 
   void process_wav_navigation_buttons()
   {
-    if(this->samples.size() == 0) return;
+    if(number_of_samples == 0) return;
 
     // If next_wav button is pressed, step to the next sample
     bool next_wav_is_triggered = next_wav_cv_trigger.process(inputs[NEXT_WAV_TRIGGER_INPUT].getVoltage(), constants::gate_low_trigger, constants::gate_high_trigger) || next_wav_button_trigger.process(params[NEXT_WAV_BUTTON_PARAM].getValue());
@@ -249,10 +325,6 @@ struct WavBankMC : VoxglitchSamplerModule
 
 	void load_samples_from_path(std::string path)
 	{
-		// Clear out any old .wav files
-    // Reminder: this->samples is a vector, and vectors have a .clear() menthod.
-		this->samples.clear();
-
 		// Load all .wav files found in the folder specified by 'path'
 		this->rootDir = path;
 
@@ -262,9 +334,8 @@ struct WavBankMC : VoxglitchSamplerModule
     // loaded out of order.  I think it's a mac thing.
     sort(dirList.begin(), dirList.end());
 
-		// TODO: Decide on a maximum memory consuption allowed and abort if
-		// that amount of member would be exhausted by loading all of the files
-		// in the folder.
+    std::vector<std::string> wav_paths;
+
 		for (auto entry : dirList)
 		{
 			if (
@@ -274,19 +345,23 @@ struct WavBankMC : VoxglitchSamplerModule
         (rack::string::lowercase(system::getExtension(entry)) == ".wav")
       )
 			{
-        // Create new multi-channel sample.  This structure is defined in Common/sample_mc.hpp
-				SampleMC new_sample;
-
-        // Load the sample data from the disk
-				new_sample.load(entry);
-
-        // Reminder: .push_back is a method of vectors that pushes the object
-        // to the end of a list.
-				this->samples.push_back(new_sample);
+				wav_paths.push_back(entry);
 			}
 		}
+
+    // The old bank keeps playing until process() swaps in the new one.  The
+    // SampleBankWorker then requests the .wav files, which are read in the
+    // background and swapped in by process() as they're ready.  To keep
+    // memory in check with large folders, see the "Load on Demand" menu.
+    bank = std::make_shared<WavBankMCSamples>(wav_paths);
+    SampleBankWorker::instance().assign(bank_host, bank);
 	}
 
+  void set_load_on_demand(bool load_on_demand, unsigned int resident_limit)
+  {
+    bank_host->configure(load_on_demand, resident_limit);
+  }
+
   // Helper functions used by WavBankMCReadout
   bool wav_input_not_connected()
   {
@@ -307,10 +382,179 @@ struct WavBankMC : VoxglitchSamplerModule
 		return(((input_value * scale) * attenuator_value) + (knob_value * scale));
 	}
 
+  //
+  // Plays the four channels starting at first_channel, and returns their
+  // output voltages.  Channels which aren't playing, and lanes past the last
+  // channel of the sample, output 0.
+  //
+  simd::float_4 process_channels(SampleMC *sample, unsigned int first_channel, unsigned int number_of_channels, float sample_rate, float smooth_rate)
+  {
+    bool sample_is_playable = (! sample->loading) && (sample->loaded) && (sample->size() > 0);
+
+    // Find out which channels are playing, and where
+    bool lane_active[4] = {false, false, false, false};
+    unsigned int indexes[4] = {0, 0, 0, 0};
+    bool shared_index = true;
+
+    for (unsigned int lane = 0; lane < 4; lane++)
+    {
+      unsigned int channel = first_channel + lane;
+      if(channel >= number_of_channels) break;
+
+      if (playback[channel] && sample_is_playable && (playback_positions[channel] < sample->size()))
+      {
+        lane_active[lane] = true;
+        indexes[lane] = (unsigned int) playback_positions[channel];
+        if(indexes[lane] != indexes[0]) shared_index = false;
+      }
+      // This gets run if the sample is loading, or there's no sample data,
+      // or most importantly, if the sample playback had ended and loop == false
+      else
+      {
+        playback[channel] = false; // Cancel current trigger
+        shared_index = false;
+      }
+    }
+
+    if(! (lane_active[0] || lane_active[1] || lane_active[2] || lane_active[3])) return(simd::float_4::zero());
+
+    simd::float_4 active = simd::float_4(lane_active[0], lane_active[1], lane_active[2], lane_active[3]) > 0.f;
+
+    //
+    // Read the audio.  Usually every channel is at the same position, and
+    // the four channels sit next to each other in the frame.
+    //
+    simd::float_4 output_voltages;
+
+    if(shared_index)
+    {
+      output_voltages = simd::float_4::load(sample->frame(indexes[0]) + first_channel);
+    }
+    else
+    {
+      for (unsigned int lane = 0; lane < 4; lane++)
+      {
+        output_voltages[lane] = lane_active[lane] ? sample->frame(indexes[lane])[first_channel + lane] : 0.f;
+      }
+    }
+
+    output_voltages = simd::ifelse(active, output_voltages, simd::float_4::zero());
+
+    //
+    // Volume control
+    //
+    if(inputs[VOLUME_INPUT].isConnected())
+    {
+      output_voltages *= get_channel_voltages(VOLUME_INPUT, first_channel);
+    }
+
+    //
+    // Smoothing
+    //
+    simd::float_4 last_output_voltages = simd::float_4::load(&last_output_voltage[first_channel]);
+
+    if(this->smoothing)
+    {
+      simd::float_4 ramp = simd::float_4::load(&smooth_ramp[first_channel]);
+      simd::float_4 smoothing_lanes = active & (ramp < 1.f);
+
+      if(simd::movemask(smoothing_lanes))
+      {
+        ramp = simd::ifelse(smoothing_lanes, ramp + smooth_rate, ramp);
+        output_voltages = simd::ifelse(smoothing_lanes, (last_output_voltages * (1.f - ramp)) + (output_voltages * ramp), output_voltages);
+        ramp.store(&smooth_ramp[first_channel]);
+      }
+    }
+
+    simd::ifelse(active, output_voltages, last_output_voltages).store(&last_output_voltage[first_channel]);
+
+    // The first two channels also go to the left and right outputs.  Copy the
+    // left output to the right output if there's only 1 channel.
+    if(first_channel == 0)
+    {
+      if(lane_active[0]) outputs[LEFT_WAV_OUTPUT].setVoltage(output_voltages[0]);
+
+      if(number_of_channels == 1)
+      {
+        if(lane_active[0]) outputs[RIGHT_WAV_OUTPUT].setVoltage(output_voltages[0]);
+      }
+      else if(lane_active[1])
+      {
+        outputs[RIGHT_WAV_OUTPUT].setVoltage(output_voltages[1]);
+      }
+    }
+
+    //
+    // Increment sample offset (pitch)
+    //
+    float step_amount = sample->sample_rate / sample_rate;
+    bool pitch_is_connected = inputs[PITCH_INPUT].isConnected();
+    simd::float_4 channel_pitches = pitch_is_connected ? get_channel_voltages(PITCH_INPUT, first_channel) : simd::float_4::zero();
+
+    for (unsigned int lane = 0; lane < 4; lane++)
+    {
+      if(! lane_active[lane]) continue;
+
+      // If there's a polyphonic cable at the pitch input with a channel
+      // that matches the sample's channel, then use that cable to control
+      // the pitch of the channel playback.
+      if(pitch_is_connected)
+      {
+        playback_positions[first_channel + lane] += step_amount + ((channel_pitches[lane] / 10.0f) - 0.5f);
+      }
+      else
+      {
+        playback_positions[first_channel + lane] += step_amount;
+      }
+    }
+
+    return(output_voltages);
+  }
+
+  // Reads four channels of a polyphonic input.  Channels that the cable
+  // doesn't have use the voltage of the first channel.
+  simd::float_4 get_channel_voltages(int input_index, unsigned int first_channel)
+  {
+    Input &input = inputs[input_index];
+    unsigned int input_channels = input.getChannels();
+
+    if(first_channel + 4 <= input_channels) return(input.getVoltageSimd<simd::float_4>(first_channel));
+
+    simd::float_4 voltages;
+
+    for (unsigned int lane = 0; lane < 4; lane++)
+    {
+      unsigned int channel = first_channel + lane;
+      voltages[lane] = input.getVoltage(channel < input_channels ? channel : 0);
+    }
+
+    return(voltages);
+  }
+
 	void process(const ProcessArgs &args) override
 	{
+    // Pick up a newly loaded folder
+    if(bank_host->accept(playing_bank))
+    {
+      playing_samples = static_cast<WavBankMCSamples *>(playing_bank.get());
+      load_check_index = 0;
+      if(selected_sample_slot >= playing_samples->size()) selected_sample_slot = 0;
+      smooth_all_channels();
+    }
 
-		number_of_samples = samples.size();
+    // If no folder has been loaded yet, don't do anything
+    if(playing_samples == NULL) return;
+
+		number_of_samples = playing_samples->size();
+
+    // Swap in samples that have finished loading in the background.  Checking
+    // one slot per frame keeps the cost of this constant, no matter how many
+    // samples are in the bank.
+    if(number_of_samples > 0)
+    {
+      load_check_index = (load_check_index + 1) % number_of_samples;
+      playing_samples->accept(load_check_index);
+    }
     sample_time = args.sampleTime;
     float smooth_rate = (128.0f / args.sampleRate);
 
@@ -330,9 +574,15 @@ struct WavBankMC : VoxglitchSamplerModule
 
 		// Check to see if the selected sample slot refers to an existing sample.
 		// If not, return.  This edge case could happen before any samples have been loaded.
-		if(selected_sample_slot >= samples.size()) return;
+		if(selected_sample_slot >= number_of_samples) return;
 
-		SampleMC *selected_sample = &samples[selected_sample_slot];
+    // The SampleBankWorker loads the selected sample, and its neighbours
+    bank_host->select(selected_sample_slot);
+
+    // Don't wait for the round-robin check if the selected sample is ready
+    playing_samples->accept(selected_sample_slot);
+
+		SampleMC *selected_sample = &playing_samples->samples[selected_sample_slot];
 
     // If either the TRG CV input is triggered or the corresponding button is
     // pressed, then restart all playback positions and start playback.
@@ -349,6 +599,10 @@ struct WavBankMC : VoxglitchSamplerModule
     }
 
 
+		// The sample's channels are played on the channels of the poly output.
+    // Any beyond the 16th are ignored.
+    unsigned int number_of_channels = std::min(selected_sample->number_of_channels, (unsigned int) NUMBER_OF_CHANNELS);
+
 		// If the loop mode is true, check each channel position.  If any are past
     // the end of the sample, then reset them to 0.  (This reset might need
     // some work to be more accurate by indexing a little from the start position
@@ -356,7 +610,7 @@ struct WavBankMC : VoxglitchSamplerModule
 
 		if(params[LOOP_SWITCH].getValue() == true)
     {
-      for (unsigned int channel = 0; channel < selected_sample->number_of_channels; channel++)
+      for (unsigned int channel = 0; channel < number_of_channels; channel++)
       {
         // Note: All channels in a .wav file have the same length
         if (playback_positions[channel] >= selected_sample->size())
@@ -367,85 +621,15 @@ struct WavBankMC : VoxglitchSamplerModule
       }
     }
 
-    for (unsigned int channel = 0; channel < selected_sample->number_of_channels; channel++)
+    // Play the channels four at a time
+    for (unsigned int first_channel = 0; first_channel < number_of_channels; first_channel += 4)
     {
-      if (playback[channel] && (! selected_sample->loading) && (selected_sample->loaded) && (selected_sample->size() > 0) && (playback_positions[channel] < selected_sample->size()))
-  		{
-          float output_voltage = selected_sample->read(channel, (int)playback_positions[channel]);
-
-          //
-          // Volume control
-          //
-          float channel_volume = 1.0;
-          if(inputs[VOLUME_INPUT].isConnected())
-          {
-            // If the current channel has a volume input provided by the CV
-            // input at that channel, then use it.
-            if(channel < (unsigned int) inputs[VOLUME_INPUT].getChannels())
-            {
-              channel_volume = inputs[VOLUME_INPUT].getVoltage(channel);
-            }
-            // Otherwise use the volume of the first channel
-            else
-            {
-              channel_volume = inputs[VOLUME_INPUT].getVoltage(0);
-            }
-          }
-          output_voltage *= channel_volume;
-
-          //
-          // Smoothing
-          //
-          if(this->smoothing && (smooth_ramp[channel] < 1))
-    			{
-    				smooth_ramp[channel] += smooth_rate;
-    				output_voltage = (last_output_voltage[channel] * (1 - smooth_ramp[channel])) + (output_voltage * smooth_ramp[channel]);
-    			}
-          last_output_voltage[channel] = output_voltage;
-
-          // Output the audio
-    			outputs[POLY_WAV_OUTPUT].setVoltage(output_voltage, channel);
-
-          if(channel == 0) outputs[LEFT_WAV_OUTPUT].setVoltage(output_voltage);
-          if(channel == 1) outputs[RIGHT_WAV_OUTPUT].setVoltage(output_voltage);
-
-          // Copy the left output to the right output if there's only 1 channel
-          if(selected_sample->number_of_channels == 1) outputs[RIGHT_WAV_OUTPUT].setVoltage(output_voltage);
-
-          // Increment sample offset (pitch)
-    			if (inputs[PITCH_INPUT].isConnected())
-    			{
-            float channel_pitch = 0.5;
-
-            if(channel < (unsigned int) inputs[PITCH_INPUT].getChannels())
-            {
-              channel_pitch = inputs[PITCH_INPUT].getVoltage(channel);
-            }
-            else
-            {
-              channel_pitch = inputs[PITCH_INPUT].getVoltage(0);
-            }
-            // If there's a polyphonic cable at the pitch input with a channel
-            // that matches the sample's channel, then use that cable to control
-            // the pitch of the channel playback.
-    				playback_positions[channel] += (selected_sample->sample_rate / args.sampleRate) + ((channel_pitch / 10.0f) - 0.5f);
-    			}
-    			else
-    			{
-    				playback_positions[channel] += (selected_sample->sample_rate / args.sampleRate);
-    			}
-      }
-      // This block of code gets run if the sample is loading, or there's no
-      // sample data, or most importantly, if the sample playback had ended
-      // and loop == false
-      else
-      {
-        playback[channel] = false; // Cancel current trigger
-        outputs[POLY_WAV_OUTPUT].setVoltage(0, channel);
-      }
-    } // end of foreach channel
+      simd::float_4 output_voltages = process_channels(selected_sample, first_channel, number_of_channels, args.sampleRate, smooth_rate);
+
+      outputs[POLY_WAV_OUTPUT].setVoltageSimd(output_voltages, first_channel);
+    }
 
-    outputs[POLY_WAV_OUTPUT].setChannels(selected_sample->number_of_channels);
+    outputs[POLY_WAV_OUTPUT].setChannels(number_of_channels);
 
   } // end of process loop
 
@@ -34,21 +34,24 @@ struct WavBankMCReadout : TransparentWidget
       nvgFill(args.vg);
       */
 
-      if(module->samples.size() > 0)
+      std::shared_ptr<WavBankMCSamples> bank = module->bank;
+      unsigned int number_of_sample = bank ? bank->size() : 0;
+
+      if(number_of_sample > 0)
       {
         // When there are too many sample filenames to fit on the front panel,
         // then we'll show a window into the sample list.  Here's where the
         // window start and end are computed.
 
         window_start = 0;
-        window_end = module->samples.size();
+        window_end = number_of_sample;
 
         // If there are more samples than can naturally fit in the display, then
         // we'll do some extra work to scroll the panel list if necessary.
-        if(! (module->samples.size() < NUMBER_OF_SAMPLE_DISPLAY_ROWS))
+        if(! (number_of_sample < NUMBER_OF_SAMPLE_DISPLAY_ROWS))
         {
           unsigned int half_display_location = (NUMBER_OF_SAMPLE_DISPLAY_ROWS / 2);
-          unsigned int number_of_loaded_samples = module->samples.size();
+          unsigned int number_of_loaded_samples = number_of_sample;
 
           if(module->selected_sample_slot > half_display_location)
           {
@@ -74,16 +77,22 @@ struct WavBankMCReadout : TransparentWidget
 
         for(unsigned int i = window_start; i < window_end; i++)
         {
-          text_to_display = module->samples[i].display_name;
+          if(i >= number_of_sample) break;
+
+          text_to_display = bank->residency.display_names[i];
           text_to_display.resize(22);
 
+          // Samples which are still loading, or which aren't loaded at all
+          // when loading on demand, are dimmed
+          unsigned char alpha = bank->isReady(i) ? 0xff : 0x70;
+
           if(i == module->selected_sample_slot || (show_hover_effect && hover_row == i))
           {
-            nvgFillColor(args.vg, nvgRGBA(150, 219, 234, 0xff));
+            nvgFillColor(args.vg, nvgRGBA(150, 219, 234, alpha));
           }
           else
           {
-            nvgFillColor(args.vg, nvgRGBA(102, 151, 163, 0xff));
+            nvgFillColor(args.vg, nvgRGBA(102, 151, 163, alpha));
           }
 
           nvgText(args.vg, 0, 6.3 + ((i - window_start) * 16), text_to_display.c_str(), NULL);
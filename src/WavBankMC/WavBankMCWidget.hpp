@@ -126,6 +126,48 @@ struct WavBankMCWidget : VoxglitchModuleWidget
   */
   // }} End of trigger mode menu code
 
+  //
+  // menu structure for loading samples on demand
+  //
+
+  struct LoadOnDemandOption : MenuItem {
+    WavBankMC *module;
+    bool load_on_demand = false;
+    unsigned int resident_limit = 0;
+
+    void onAction(const event::Action &e) override {
+      module->set_load_on_demand(load_on_demand, resident_limit);
+    }
+  };
+
+  struct LoadOnDemandMenu : MenuItem {
+    WavBankMC *module;
+
+    Menu *createChildMenu() override {
+      Menu *menu = new Menu;
+
+      LoadOnDemandOption *off_option = createMenuItem<LoadOnDemandOption>("Off (load the whole folder)", CHECKMARK(! module->bank_host->load_on_demand));
+      off_option->module = module;
+      off_option->resident_limit = module->bank_host->resident_limit;
+      menu->addChild(off_option);
+
+      menu->addChild(createMenuLabel("Samples kept in memory"));
+
+      unsigned int resident_limit_options[] = { 8, 16, 32, 64, 128 };
+
+      for(unsigned int resident_limit : resident_limit_options)
+      {
+        LoadOnDemandOption *option = createMenuItem<LoadOnDemandOption>(std::to_string(resident_limit), CHECKMARK(module->bank_host->load_on_demand && module->bank_host->resident_limit == resident_limit));
+        option->module = module;
+        option->load_on_demand = true;
+        option->resident_limit = resident_limit;
+        menu->addChild(option);
+      }
+
+      return menu;
+    }
+  };
+
 
 	void appendContextMenu(Menu *menu) override
 	{
@@ -155,6 +197,10 @@ struct WavBankMCWidget : VoxglitchModuleWidget
 		menu_item_load_bank_mc->text = "Select Directory Containing WAV Files";
 		menu_item_load_bank_mc->module = module;
 		menu->addChild(menu_item_load_bank_mc);
+
+    LoadOnDemandMenu *load_on_demand_menu = createMenuItem<LoadOnDemandMenu>("Load on Demand", RIGHT_ARROW);
+    load_on_demand_menu->module = module;
+    menu->addChild(load_on_demand_menu);
 	}
 
 };
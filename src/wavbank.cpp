@@ -12,7 +12,9 @@
 #include "Common/dsp/DeclickFilter.hpp"
 #include "Common/Theme.hpp"
 #include "Common/components/VoxglitchComponents.hpp"
+#include "Common/SampleLoader.hpp"
 #include "Common/SamplePlayer.hpp"
+#include "Common/SampleBankResidency.hpp"
 
 #include "WavBank/defines.h"
 #include "WavBank/WavBank.hpp"
@@ -8,7 +8,10 @@
 #include "Common/constants.h"
 #include "Common/Theme.hpp"
 #include "Common/components/VoxglitchComponents.hpp"
+#include "Common/sample.hpp"
+#include "Common/SampleLoader.hpp"
 #include "Common/sample_mc.hpp"
+#include "Common/SampleBankResidency.hpp"
 
 #include "WavBankMC/defines.h"
 #include "WavBankMC/WavBankMC.hpp"